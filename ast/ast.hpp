@@ -1,13 +1,29 @@
 #ifndef __AST_HPP
 #define __AST_HPP
 
+#include <memory>
+#include <vector>
+
+#include "ast_arena.hpp"
 #include "ast_nodes.hpp"
 
+// owns every node in the tree through its arena, destroying the AST frees them all at once
 class AST {
     public:
-        AST(ASTNode* pRoot) : pRoot(pRoot) {};
-        ~AST() {  delete pRoot;  }
+        AST() {};
+        AST(const AST&) = delete;
+        AST& operator=(const AST&) = delete;
+
+        // extra arena for a thread building part of the tree, owned (and freed) by the AST
+        ASTArena& addArena() {
+            extraArenas.push_back(std::make_unique<ASTArena>());
+            return *extraArenas.back();
+        };
+
+        ASTArena arena;
         ASTNode* pRoot = nullptr;
+    private:
+        std::vector<std::unique_ptr<ASTArena>> extraArenas;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "ast_arena.hpp"
+
+void* ASTArena::allocate(size_t size, size_t align) {
+    used += size;
+
+    // big allocations get a block to themselves so the current block isn't wasted
+    if (size > AST_ARENA_BLOCK_SIZE / 4) {
+        blocks.push_back(std::make_unique<char[]>(size + align));
+        const uintptr_t addr = reinterpret_cast<uintptr_t>(blocks.back().get());
+        return reinterpret_cast<void*>((addr + align - 1) & ~(uintptr_t)(align - 1));
+    }
+
+    uintptr_t addr = (reinterpret_cast<uintptr_t>(pCurrent) + align - 1) & ~(uintptr_t)(align - 1);
+    if (pCurrent == nullptr || addr + size > reinterpret_cast<uintptr_t>(pEnd)) {
+        blocks.push_back(std::make_unique<char[]>(AST_ARENA_BLOCK_SIZE));
+        pCurrent = blocks.back().get();
+        pEnd = pCurrent + AST_ARENA_BLOCK_SIZE;
+        addr = (reinterpret_cast<uintptr_t>(pCurrent) + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    pCurrent = reinterpret_cast<char*>(addr + size);
+    return reinterpret_cast<void*>(addr);
+}
+
+std::string_view ASTArena::copyString(std::string_view str) {
+    if (str.empty()) return std::string_view();
+    char* pDest = static_cast<char*>(allocate(str.size(), 1));
+    std::memcpy(pDest, str.data(), str.size());
+    return std::string_view(pDest, str.size());
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef __AST_ARENA_HPP
+#define __AST_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#define AST_ARENA_BLOCK_SIZE 65536
+
+// bump-pointer allocator that every node of an AST (and each node's child array) lives in
+// nothing allocated here is ever destroyed or freed on its own, the whole arena is released
+// at once, so objects placed in it must not own anything outside of it
+class ASTArena {
+    public:
+        ASTArena() {};
+        ASTArena(const ASTArena&) = delete;
+        ASTArena& operator=(const ASTArena&) = delete;
+
+        void* allocate(size_t size, size_t align);
+
+        template <typename T, typename... Args>
+        T* make(Args&&... args) {
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        };
+
+        // copies str into the arena
+        std::string_view copyString(std::string_view str);
+
+        size_t bytesUsed() const { return used; };
+    private:
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char* pCurrent = nullptr; // next free byte of the current block
+        char* pEnd = nullptr; // end of the current block
+        size_t used = 0;
+};
+
+// lets standard containers allocate from an ASTArena, deallocation is a no-op
+template <typename T>
+class ArenaAllocator {
+    public:
+        typedef T value_type;
+
+        ArenaAllocator(ASTArena& arena) : pArena(&arena) {};
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : pArena(other.pArena) {};
+
+        T* allocate(size_t n) { return static_cast<T*>(pArena->allocate(n * sizeof(T), alignof(T))); };
+        void deallocate(T*, size_t) {};
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const { return pArena == other.pArena; };
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const { return pArena != other.pArena; };
+
+        ASTArena* pArena;
+};
+
+template <typename T>
+using arena_vector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
\ No newline at end of file
@@ -1,13 +1,13 @@
-#include "ast_nodes.hpp"
+#include <algorithm>
 
-// base destructor
-ASTNode::~ASTNode() {
-    for (ASTNode* pChild : this->children)
-        delete pChild;
-}
+#include "ast_nodes.hpp"
 
 ASTNode* ASTNode::removeChild(size_t i) {
     ASTNode* pNode = this->children[i];
     this->children.erase(this->children.begin()+i);
     return pNode;
+}
+
+void ASTNode::removeNullChildren() {
+    this->children.erase(std::remove(this->children.begin(), this->children.end(), nullptr), this->children.end());
 }
\ No newline at end of file
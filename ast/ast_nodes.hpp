@@ -1,92 +1,101 @@
 #ifndef __AST_NODES_HPP
 #define __AST_NODES_HPP
 
-#include <string>
+#include <cstdint>
+#include <string_view>
 #include <vector>
 
+#include "ast_arena.hpp"
 #include "../lexer.hpp"
-
-enum class ASTNodeType {
-    NODE, // base class
-    FUNCTION, VARIABLE, IDENTIFIER, RETURN,
-    EXPR, UNARY_EXPR, BIN_EXPR,
-    LIT_BOOL, LIT_CHAR, LIT_DOUBLE, LIT_INT, LIT_STR, LIT_NULL
-};
-
-enum class Register {
-    RAX, RBX, RCX, RDX, RDI, XMM0, XMM1
-};
-
-const std::string getRegisterStr(Register reg) {
-    switch (reg) {
-        case Register::RAX: return "rax";
-        case Register::RBX: return "rbx";
-        case Register::RCX: return "rcx";
-        case Register::RDX: return "rdx";
-        case Register::RDI: return "rdi";
-        case Register::XMM0: return "xmm0";
-        case Register::XMM1: return "xmm1";
-    }
-    return "";
-}
-
-// true for registers > 64 bit; false otherwise
-constexpr bool isRegisterWide(Register reg) {
-    return reg == Register::XMM0 || reg == Register::XMM1;
-}
+#include "../symbols.hpp"
+
+// every node kind as X(tag, class, visitor name, parent's visitor name)
+// the node type enum & the visitors' jump tables are all generated from this list
+#define AST_NODE_LIST(X) \
+    X(NODE, ASTNode, Node, Any) /* base class */ \
+    X(FUNCTION, ASTFunction, Function, Node) \
+    X(VARIABLE, ASTVariable, Variable, Node) \
+    X(IDENTIFIER, ASTIdentifier, Identifier, Node) \
+    X(RETURN, ASTReturn, Return, Node) \
+    X(EXPR, ASTExpr, Expr, Node) \
+    X(UNARY_EXPR, ASTUnaryExpr, UnaryExpr, Expr) \
+    X(BIN_EXPR, ASTBinExpr, BinExpr, Expr) \
+    X(CALL, ASTCall, Call, Expr) \
+    X(LIT_BOOL, ASTBoolLiteral, BoolLiteral, Node) \
+    X(LIT_CHAR, ASTCharLiteral, CharLiteral, Node) \
+    X(LIT_DOUBLE, ASTDoubleLiteral, DoubleLiteral, Node) \
+    X(LIT_INT, ASTIntLiteral, IntLiteral, Node) \
+    X(LIT_STR, ASTStringLiteral, StringLiteral, Node) \
+    X(LIT_NULL, ASTNullLiteral, NullLiteral, Node)
+
+#define AST_NODE_TAG(tag, cls, name, parent) tag,
+enum class ASTNodeType : uint8_t {
+    AST_NODE_LIST(AST_NODE_TAG)
+};
+#undef AST_NODE_TAG
+
+#define AST_NODE_COUNT(tag, cls, name, parent) + 1
+constexpr size_t NUM_AST_NODE_TYPES = 0 AST_NODE_LIST(AST_NODE_COUNT);
+#undef AST_NODE_COUNT
+
+// storage slot of a variable, set by the semantic pass
+// locals (& params) count up from 0 per function, globals count up from 0 with the flag set
+typedef uint32_t slot_t;
+#define SLOT_GLOBAL_FLAG 0x80000000u
+constexpr bool isSlotGlobal(slot_t slot) { return slot & SLOT_GLOBAL_FLAG; }
 
 // base class for all AST node types
+// nodes are allocated in their AST's arena & never destroyed individually, so they may only
+// hold trivially destructible data or containers that allocate from the same arena
+// the node's kind is a plain tag (no vtable), dispatch on it through ASTVisitor in ast_visitor.hpp
 class ASTNode {
     public:
-        ASTNode(const Token& token) : err(token.err), raw(token.raw) {};
-        virtual ~ASTNode();
+        ASTNode(const Token& token, ASTArena& arena, ASTNodeType tag = ASTNodeType::NODE)
+            : err(token.err), raw(token.raw), tag(tag), children(ArenaAllocator<ASTNode*>(arena)) {};
         void push(ASTNode* pNode) { children.push_back(pNode); };
+        void setChild(size_t i, ASTNode* pNode) { children[i] = pNode; };
+        void removeNullChildren(); // drops children that were set to nullptr, keeping the rest in order
         ASTNode* removeChild(size_t i);
         ASTNode* pop() { ASTNode* pNode = lastChild(); children.pop_back(); return pNode; };
         
-        virtual ASTNodeType nodeType() const { return ASTNodeType::NODE; };
+        ASTNodeType nodeType() const { return tag; };
 
         ASTNode* at(unsigned int i) const { return children[i]; };
         size_t size() const { return children.size(); };
         ASTNode* lastChild() const { return this->size() > 0 ? children[this->size()-1] : nullptr; };
 
-        // assembler helpers
-        bool isAssembled = false; // whether or not the node has been resolved
-
         // for error reporting
         ErrInfo err;
-        std::string raw;
+        std::string_view raw; // view into the source file, which outlives the AST
     protected:
-        std::vector<ASTNode*> children;
+        ASTNodeType tag;
+        arena_vector<ASTNode*> children;
 };
 
 class ASTReturn : public ASTNode {
     public:
-        ASTReturn(const Token& token) : ASTNode(token) {};
-        ASTNodeType nodeType() const { return ASTNodeType::RETURN; };
+        ASTReturn(const Token& token, ASTArena& arena) : ASTNode(token, arena, ASTNodeType::RETURN) {};
 };
 
 /************* EXPRESSIONS *************/
 
 class ASTExpr : public ASTNode {
     public:
-        ASTExpr(const Token& token) : ASTNode(token) {};
-        ASTNodeType nodeType() const { return ASTNodeType::EXPR; };
+        ASTExpr(const Token& token, ASTArena& arena, ASTNodeType tag = ASTNodeType::EXPR) : ASTNode(token, arena, tag) {};
+
+        TokenType valueType = TYPE_INT; // type the expression evaluates to (TYPE_*), set by the semantic pass
 };
 
 class ASTUnaryExpr : public ASTExpr {
     public:
-        ASTUnaryExpr(const Token& token) : ASTExpr(token), _opType(token.type) {};
-        ASTNodeType nodeType() const { return ASTNodeType::UNARY_EXPR; };
+        ASTUnaryExpr(const Token& token, ASTArena& arena) : ASTExpr(token, arena, ASTNodeType::UNARY_EXPR), _opType(token.type) {};
         
         ASTNode* right() { return children[0]; };
-        TokenType opType() { return _opType; };
+        TokenType opType() const { return _opType; };
 
         // if this unary is a post operator (comes after the literal/identifier; ex. post-inc/decrement)
         bool isPostOperator() const { return isPostOp; };
         void setIsPostOperator(bool isPostOperator) { this->isPostOp = isPostOperator; };
-
-        Register resultRegister; // the register that the resulting value is stored in
     private:
         TokenType _opType;
         bool isPostOp = false;
@@ -94,95 +103,111 @@ class ASTUnaryExpr : public ASTExpr {
 
 class ASTBinExpr : public ASTExpr {
     public:
-        ASTBinExpr(const Token& token) : ASTExpr(token), _opType(token.type) {};
-        ASTNodeType nodeType() const { return ASTNodeType::BIN_EXPR; };
+        ASTBinExpr(const Token& token, ASTArena& arena) : ASTExpr(token, arena, ASTNodeType::BIN_EXPR), _opType(token.type) {};
 
         ASTNode* left() { return children[0]; };
         ASTNode* right() { return children[1]; };
-        TokenType opType() { return _opType; };
+        TokenType opType() const { return _opType; };
 
-        Register resultRegister; // the register that the resulting value is stored in
+        bool isRightFirst = false; // evaluate the right operand before the left, set by orderOperands()
     private:
         TokenType _opType;
 };
 
+class ASTFunction;
+
+// children are the arguments in order
+class ASTCall : public ASTExpr {
+    public:
+        ASTCall(const Token& token, ASTArena& arena) : ASTExpr(token, arena, ASTNodeType::CALL), name(token.symbol) {};
+
+        symbol_t getName() const { return name; };
+
+        ASTFunction* pFunction = nullptr; // function called, resolved by the semantic pass
+    private:
+        symbol_t name; // name of function called
+};
+
 /************* LITERALS & IDENTIFIERS *************/
 
-typedef std::pair<std::string, TokenType> param_t;
+typedef std::pair<symbol_t, TokenType> param_t;
 class ASTFunction : public ASTNode {
     public:
-        ASTFunction(const std::string& name, const Token& token) : ASTNode(token), name(name), type(token.type) {};
-        ASTNodeType nodeType() const { return ASTNodeType::FUNCTION; };
+        ASTFunction(symbol_t name, const Token& token, ASTArena& arena)
+            : ASTNode(token, arena, ASTNodeType::FUNCTION), name(name), type(token.type), params(ArenaAllocator<param_t>(arena)) {};
         void appendParam(const param_t p) {  params.push_back(p);  };
-        size_t assemblerID; // # id
 
-        const std::string& getName() const { return name; };
+        symbol_t getName() const { return name; };
         TokenType getReturnType() const { return type; };
-        std::vector<param_t> getParams() const { return params; };
+
+        size_t numSlots = 0; // # of params & locals, set by the semantic pass
+        const arena_vector<param_t>& getParams() const { return params; };
         size_t getNumParams() const { return params.size(); };
     private:
-        std::string name; // name of function
+        symbol_t name; // name of function
         TokenType type; // return type
-        std::vector<param_t> params; // parameters {name, type}
+        arena_vector<param_t> params; // parameters {name, type}
 };
 
 class ASTVariable : public ASTNode {
     public:
-        ASTVariable(const std::string& name, const Token& token) : ASTNode(token), name(name), type(token.type) {};
-        ASTNodeType nodeType() const { return ASTNodeType::VARIABLE; };
+        ASTVariable(symbol_t name, const Token& token, ASTArena& arena) : ASTNode(token, arena, ASTNodeType::VARIABLE), name(name), type(token.type) {};
+
+        symbol_t getName() const { return name; };
+        TokenType getType() const { return type; };
+
+        slot_t slot = 0; // where the variable lives, set by the semantic pass
     private:
-        std::string name; // name of variable
+        symbol_t name; // name of variable
         TokenType type; // type of variable
 };
 
 class ASTIdentifier : public ASTNode {
     public:
-        ASTIdentifier(const Token& token) : ASTNode(token), name(token.raw) {};
-        ASTNodeType nodeType() const { return ASTNodeType::IDENTIFIER; };
+        ASTIdentifier(const Token& token, ASTArena& arena) : ASTNode(token, arena, ASTNodeType::IDENTIFIER), name(token.symbol) {};
+
+        symbol_t getName() const { return name; };
+
+        // resolved by the semantic pass
+        TokenType valueType = TYPE_INT; // declared type of the variable named
+        slot_t slot = 0;
     private:
-        std::string name; // name of identifier to be resolved
+        symbol_t name; // name of identifier to be resolved
 };
 
 class ASTBoolLiteral : public ASTNode {
     public:
-        ASTBoolLiteral(bool val, const Token& token) : ASTNode(token), val(val) {};
-        ASTNodeType nodeType() const { return ASTNodeType::LIT_BOOL; };
+        ASTBoolLiteral(bool val, const Token& token, ASTArena& arena) : ASTNode(token, arena, ASTNodeType::LIT_BOOL), val(val) {};
         bool val;
 };
 
 class ASTCharLiteral : public ASTNode {
     public:
-        ASTCharLiteral(char val, const Token& token) : ASTNode(token), val(val) {};
-        ASTNodeType nodeType() const { return ASTNodeType::LIT_CHAR; };
+        ASTCharLiteral(char val, const Token& token, ASTArena& arena) : ASTNode(token, arena, ASTNodeType::LIT_CHAR), val(val) {};
         char val;
 };
 
 class ASTDoubleLiteral : public ASTNode {
     public:
-        ASTDoubleLiteral(double val, const Token& token) : ASTNode(token), val(val) {};
-        ASTNodeType nodeType() const { return ASTNodeType::LIT_DOUBLE; };
+        ASTDoubleLiteral(double val, const Token& token, ASTArena& arena) : ASTNode(token, arena, ASTNodeType::LIT_DOUBLE), val(val) {};
         double val;
 };
 
 class ASTIntLiteral : public ASTNode {
     public:
-        ASTIntLiteral(int val, const Token& token) : ASTNode(token), val(val) {};
-        ASTNodeType nodeType() const { return ASTNodeType::LIT_INT; };
-        int val;
+        ASTIntLiteral(long long val, const Token& token, ASTArena& arena) : ASTNode(token, arena, ASTNodeType::LIT_INT), val(val) {};
+        long long val;
 };
 
 class ASTStringLiteral : public ASTNode {
     public:
-        ASTStringLiteral(const std::string& val, const Token& token) : ASTNode(token), val(val) {};
-        ASTNodeType nodeType() const { return ASTNodeType::LIT_STR; };
-        std::string val;
-        size_t assemblerID; // # id in .data section for this string
+        ASTStringLiteral(std::string_view val, const Token& token, ASTArena& arena) : ASTNode(token, arena, ASTNodeType::LIT_STR), val(val) {};
+        std::string_view val; // unescaped text, copied into the arena
 };
 
 class ASTNullLiteral : public ASTNode {
     public:
-        ASTNullLiteral(const Token& token) : ASTNode(token) {};
-        ASTNodeType nodeType() const { return ASTNodeType::LIT_NULL; };
+        ASTNullLiteral(const Token& token, ASTArena& arena) : ASTNode(token, arena, ASTNodeType::LIT_NULL) {};
 };
 
 #endif
\ No newline at end of file
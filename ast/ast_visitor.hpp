@@ -0,0 +1,137 @@
+#ifndef __AST_VISITOR_HPP
+#define __AST_VISITOR_HPP
+
+#include <type_traits>
+#include <vector>
+
+#include "ast_nodes.hpp"
+#include "flat_ast.hpp"
+
+/**
+ * Compile-time dispatched visitors (CRTP) for both AST representations.
+ *
+ * dispatch() reads the node's tag & jumps through a table with one entry per node kind,
+ * generated from AST_NODE_LIST, straight to Derived's handler, no virtual calls involved.
+ * A pass overrides only the handlers it cares about (ex. visitBinExpr), every other handler
+ * forwards to its parent kind's (BinExpr -> Expr -> Node -> Any), & visitAny does nothing.
+ * Handlers don't recurse on their own, call visitChildren() (or dispatch children) to descend,
+ * or dispatchSubtree() / dispatchPostorder() to reach every node of a subtree without recursing.
+ *
+ * The parser takes expressions of any depth (ex. a + a + ... + a), so passes over them walk from
+ * an explicit stack rather than natively recursing: dispatchSubtree() in preorder for handlers
+ * that only look at their own node, dispatchPostorder() bottom up for handlers that combine
+ * their children's results. Passes that have to act between children (ex. the branch of && &
+ * ||) keep a staged stack of their own for the same reason.
+ */
+
+// visitor over the pointer AST, IsConst for passes that only read the tree
+template <typename Derived, typename Result = void, bool IsConst = false>
+class ASTVisitor {
+    public:
+        template <typename T>
+        using node_ref = std::conditional_t<IsConst, const T&, T&>;
+
+        Result dispatch(node_ref<ASTNode> node) {
+            typedef Result (*Handler)(Derived&, node_ref<ASTNode>);
+#define AST_VISITOR_THUNK(tag, cls, name, parent) \
+            [](Derived& visitor, node_ref<ASTNode> node) -> Result { return visitor.visit##name(static_cast<node_ref<cls>>(node)); },
+            static constexpr Handler JUMP_TABLE[] = { AST_NODE_LIST(AST_VISITOR_THUNK) };
+#undef AST_VISITOR_THUNK
+            static_assert(sizeof(JUMP_TABLE) / sizeof(Handler) == NUM_AST_NODE_TYPES, "visitor jump table is missing node kinds");
+            return JUMP_TABLE[(size_t)node.nodeType()](static_cast<Derived&>(*this), node);
+        };
+
+        // dispatches every child of node in order
+        void visitChildren(node_ref<ASTNode> node) {
+            for (size_t i = 0; i < node.size(); i++)
+                dispatch(*node.at(i));
+        };
+
+        // dispatches every node of the subtree at root in preorder
+        void dispatchSubtree(node_ref<ASTNode> root) {
+            std::vector<std::conditional_t<IsConst, const ASTNode*, ASTNode*>> stack = {&root};
+            while (!stack.empty()) {
+                node_ref<ASTNode> node = *stack.back();
+                stack.pop_back();
+                dispatch(node);
+                for (size_t i = node.size(); i-- > 0;) // reversed so the first child comes first
+                    stack.push_back(node.at(i));
+            }
+        };
+
+        // dispatches every node of the subtree at root after its children, returns root's result
+        // a handler finds its children's results in order from pChildResults
+        Result dispatchPostorder(node_ref<ASTNode> root) {
+            struct Pending {
+                std::conditional_t<IsConst, const ASTNode*, ASTNode*> pNode;
+                bool isExpanded; // children are already dispatched (or on the stack)
+            };
+            std::vector<Pending> stack = {{&root, false}};
+            std::vector<Result> results; // of the dispatched nodes not yet taken by their parent
+            const Result* const pOuterResults = pChildResults; // a handler may start a walk of its own
+            while (!stack.empty()) {
+                const Pending pending = stack.back();
+                const size_t len = pending.pNode->size();
+                if (!pending.isExpanded && len > 0) {
+                    stack.back().isExpanded = true;
+                    for (size_t i = len; i-- > 0;) // reversed so the first child comes first
+                        stack.push_back({pending.pNode->at(i), false});
+                    continue;
+                }
+                stack.pop_back();
+                const size_t first = results.size() - len;
+                pChildResults = results.data() + first;
+                Result result = dispatch(*pending.pNode);
+                results.resize(first);
+                results.push_back(result);
+            }
+            pChildResults = pOuterResults;
+            return results.back();
+        };
+
+        Result visitAny(node_ref<ASTNode>) { return Result(); };
+#define AST_VISITOR_DEFAULT(tag, cls, name, parent) \
+        Result visit##name(node_ref<cls> node) { return static_cast<Derived&>(*this).visit##parent(node); };
+        AST_NODE_LIST(AST_VISITOR_DEFAULT)
+#undef AST_VISITOR_DEFAULT
+    protected:
+        // results of the children of the node dispatchPostorder() is dispatching, nullptr outside
+        // of one (Result can't be bool, vector<bool> has no data())
+        const Result* pChildResults = nullptr;
+};
+
+template <typename Derived, typename Result = void>
+using ConstASTVisitor = ASTVisitor<Derived, Result, true>;
+
+// visitor over a FlatAST, handlers get node ids & read fields through ast
+template <typename Derived, typename Result = void>
+class FlatASTVisitor {
+    public:
+        FlatASTVisitor(const FlatAST& ast) : ast(ast) {};
+
+        Result dispatch(node_id id) {
+            typedef Result (*Handler)(Derived&, node_id);
+#define FLAT_VISITOR_THUNK(tag, cls, name, parent) \
+            [](Derived& visitor, node_id id) -> Result { return visitor.visit##name(id); },
+            static constexpr Handler JUMP_TABLE[] = { AST_NODE_LIST(FLAT_VISITOR_THUNK) };
+#undef FLAT_VISITOR_THUNK
+            static_assert(sizeof(JUMP_TABLE) / sizeof(Handler) == NUM_AST_NODE_TYPES, "visitor jump table is missing node kinds");
+            return JUMP_TABLE[(size_t)ast.tag(id)](static_cast<Derived&>(*this), id);
+        };
+
+        void visitChildren(node_id id) {
+            const size_t len = ast.numChildren(id);
+            for (size_t i = 0; i < len; i++)
+                dispatch(ast.child(id, i));
+        };
+
+        Result visitAny(node_id) { return Result(); };
+#define FLAT_VISITOR_DEFAULT(tag, cls, name, parent) \
+        Result visit##name(node_id id) { return static_cast<Derived&>(*this).visit##parent(id); };
+        AST_NODE_LIST(FLAT_VISITOR_DEFAULT)
+#undef FLAT_VISITOR_DEFAULT
+    protected:
+        const FlatAST& ast;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <unordered_map>
+#include <vector>
+
+#include "flat_ast.hpp"
+#include "ast_visitor.hpp"
+
+// works out the kind specific fields of one node
+class FlatASTBuilder : public ConstASTVisitor<FlatASTBuilder> {
+    public:
+        FlatASTBuilder(FlatAST& flat, const std::unordered_map<const ASTFunction*, uint32_t>& functionIds)
+            : flat(flat), functionIds(functionIds) { value.i = 0; };
+
+        void visitFunction(const ASTFunction& func) {
+            op = func.getReturnType();
+            value.index = (uint32_t)flat.functions.size();
+            flat.functions.push_back({func.getName(), {(uint32_t)flat.params.size(), (uint32_t)func.getNumParams()}, (uint32_t)func.numSlots});
+            flat.params.insert(flat.params.end(), func.getParams().begin(), func.getParams().end());
+        };
+        void visitVariable(const ASTVariable& var) {
+            op = var.getType();
+            type = var.getType();
+            value.var = {var.getName(), var.slot};
+        };
+        void visitIdentifier(const ASTIdentifier& identifier) {
+            type = identifier.valueType;
+            value.var = {identifier.getName(), identifier.slot};
+        };
+        void visitExpr(const ASTExpr& expr) { type = expr.valueType; };
+        void visitUnaryExpr(const ASTUnaryExpr& expr) {
+            op = expr.opType();
+            type = expr.valueType;
+            flag = expr.isPostOperator() ? FLAT_FLAG_POST_OP : 0;
+        };
+        void visitBinExpr(const ASTBinExpr& expr) {
+            op = expr.opType();
+            type = expr.valueType;
+            flag = expr.isRightFirst ? FLAT_FLAG_RIGHT_FIRST : 0;
+        };
+        void visitCall(const ASTCall& call) {
+            type = call.valueType;
+            value.index = functionIds.at(call.pFunction);
+        };
+        void visitBoolLiteral(const ASTBoolLiteral& literal) { type = TYPE_BOOL; value.b = literal.val; };
+        void visitCharLiteral(const ASTCharLiteral& literal) { type = TYPE_CHAR; value.c = literal.val; };
+        void visitDoubleLiteral(const ASTDoubleLiteral& literal) { type = TYPE_DOUBLE; value.d = literal.val; };
+        void visitIntLiteral(const ASTIntLiteral& literal) { type = TYPE_INT; value.i = literal.val; };
+        void visitStringLiteral(const ASTStringLiteral& literal) {
+            type = TYPE_STR;
+            value.index = (uint32_t)flat.strings.size();
+            flat.strings.push_back(literal.val);
+        };
+        void visitNullLiteral(const ASTNullLiteral&) { type = TYPE_STR; };
+
+        uint8_t op = 0, type = 0, flag = 0;
+        FlatValue value;
+    private:
+        FlatAST& flat;
+        const std::unordered_map<const ASTFunction*, uint32_t>& functionIds;
+};
+
+// flattens the tree in preorder with an explicit stack (see ast_visitor.hpp)
+FlatAST::FlatAST(const AST& ast, const int fileIndex) : fileIndex(fileIndex) {
+    struct Pending {
+        const ASTNode* pNode;
+        uint32_t slot; // where in childIds the node's id goes (unused for the root)
+    };
+    std::vector<Pending> stack = {{ast.pRoot, 0}};
+
+    // functions are numbered in source order (which is also preorder) so calls can refer ahead
+    std::unordered_map<const ASTFunction*, uint32_t> functionIds;
+    for (size_t i = 0; i < ast.pRoot->size(); i++)
+        if (ast.pRoot->at(i)->nodeType() == ASTNodeType::FUNCTION)
+            functionIds.emplace(static_cast<const ASTFunction*>(ast.pRoot->at(i)), (uint32_t)functionIds.size());
+
+    while (!stack.empty()) {
+        const Pending pending = stack.back();
+        stack.pop_back();
+        const ASTNode& node = *pending.pNode;
+
+        const node_id id = (node_id)tags.size();
+        if (id != root()) childIds[pending.slot] = id;
+
+        FlatASTBuilder builder(*this, functionIds);
+        builder.dispatch(node); // fills in the kind specific fields
+
+        tags.push_back((uint8_t)node.nodeType());
+        ops.push_back(builder.op);
+        types.push_back(builder.type);
+        flags.push_back(builder.flag);
+        offsets.push_back(node.err.offset);
+        values.push_back(builder.value);
+
+        // reserve the child range now, children fill in their ids as they're numbered
+        const size_t numChildren = node.size();
+        children.push_back({(uint32_t)childIds.size(), (uint32_t)numChildren});
+        childIds.resize(childIds.size() + numChildren);
+        for (size_t i = numChildren; i-- > 0;) // reversed so the first child is numbered next
+            stack.push_back({node.at(i), children.back().start + (uint32_t)i});
+    }
+}
\ No newline at end of file
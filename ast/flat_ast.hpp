@@ -0,0 +1,97 @@
+#ifndef __FLAT_AST_HPP
+#define __FLAT_AST_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "ast.hpp"
+#include "ast_nodes.hpp"
+#include "../lexer.hpp"
+#include "../symbols.hpp"
+
+typedef uint32_t node_id;
+
+// [start, start+count) slice of one of the shared index arrays
+struct FlatRange {
+    uint32_t start;
+    uint32_t count;
+};
+
+struct FlatFunction {
+    symbol_t name;
+    FlatRange params; // into the param list
+    uint32_t numSlots; // # of params & locals
+};
+
+// per node payload, which member is live depends on the tag
+union FlatValue {
+    long long i; // LIT_INT
+    double d; // LIT_DOUBLE
+    bool b; // LIT_BOOL
+    char c; // LIT_CHAR
+    struct {
+        symbol_t symbol;
+        slot_t slot;
+    } var; // VARIABLE, IDENTIFIER
+    uint32_t index; // LIT_STR into strings, FUNCTION & CALL into functions
+};
+
+#define FLAT_FLAG_POST_OP 0x1 // UNARY_EXPR that comes after its operand
+#define FLAT_FLAG_RIGHT_FIRST 0x2 // BIN_EXPR whose right operand is evaluated first
+
+/**
+ * Read-only, data-oriented snapshot of an AST for the passes that walk the whole tree.
+ *
+ * Nodes are numbered in preorder (the root is 0, a node's subtree is the ids right after it)
+ * and every field lives in its own array indexed by node_id, so walks only touch the fields
+ * they read. Children are ranges of one shared child array & source locations are offsets,
+ * turned back into line/col only for errors.
+ * String literals view into the AST's arena, so the AST must outlive its FlatAST.
+ */
+class FlatAST {
+    public:
+        FlatAST(const AST& ast, const int fileIndex);
+
+        size_t size() const { return tags.size(); };
+        node_id root() const { return 0; };
+
+        ASTNodeType tag(node_id id) const { return (ASTNodeType)tags[id]; };
+        TokenType op(node_id id) const { return (TokenType)ops[id]; }; // operator, declared or return type
+        TokenType type(node_id id) const { return (TokenType)types[id]; }; // type of the value the node evaluates to
+        bool isPostOp(node_id id) const { return flags[id] & FLAT_FLAG_POST_OP; };
+        bool isRightFirst(node_id id) const { return flags[id] & FLAT_FLAG_RIGHT_FIRST; };
+        ErrInfo err(node_id id) const { return {offsets[id], fileIndex}; };
+        const FlatValue& value(node_id id) const { return values[id]; };
+
+        size_t numChildren(node_id id) const { return children[id].count; };
+        node_id child(node_id id, size_t i) const { return childIds[children[id].start + i]; };
+
+        // node kind specific data
+        const FlatFunction& function(node_id id) const { return functions[values[id].index]; };
+        const param_t& param(const FlatFunction& func, size_t i) const { return params[func.params.start + i]; };
+        std::string_view string(node_id id) const { return strings[values[id].index]; };
+        size_t numFunctions() const { return functions.size(); };
+        size_t numStrings() const { return strings.size(); };
+        std::string_view stringAt(size_t i) const { return strings[i]; }; // in source order
+    private:
+        friend class FlatASTBuilder;
+        int fileIndex;
+
+        // per node
+        std::vector<uint8_t> tags; // ASTNodeType
+        std::vector<uint8_t> ops; // TokenType
+        std::vector<uint8_t> types; // TokenType (TYPE_*), only for nodes with a value
+        std::vector<uint8_t> flags;
+        std::vector<uint32_t> offsets; // byte offset of the node's token in the source file
+        std::vector<FlatRange> children; // into childIds
+        std::vector<FlatValue> values;
+
+        // shared
+        std::vector<node_id> childIds;
+        std::vector<FlatFunction> functions;
+        std::vector<param_t> params;
+        std::vector<std::string_view> strings;
+};
+
+#endif
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <cstdint>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -6,58 +7,130 @@
 #include "compiler.hpp"
 #include "lexer.hpp"
 #include "parser.hpp"
+#include "token_stream.hpp"
+#include "token_store.hpp"
+#include "thread_pool.hpp"
 #include "errors.hpp"
+#include "source_file.hpp"
+#include "semantics.hpp"
 #include "ast/ast.hpp"
-#include "ast/ast_extractor.hpp"
+#include "ast/flat_ast.hpp"
+#include "ir/ir.hpp"
+#include "ir/ir_builder.hpp"
+#include "ir/ir_printer.hpp"
+#include "ir/ir_tail_calls.hpp"
+#include "ir/ir_verifier.hpp"
+#include "opt/constant_folding.hpp"
+#include "opt/dead_code.hpp"
+#include "opt/inliner.hpp"
+#include "opt/local_dataflow.hpp"
+#include "opt/operand_order.hpp"
+#include "x86/elf_writer.hpp"
+#include "x86/x86_codegen.hpp"
+#include "x86/x86_encoder.hpp"
 
-void compileSrc(const std::string& inPath, const std::string& asmPath) {
-    // open src file
-    std::ifstream inHandle( inPath );
-    if (!inHandle.is_open()) {
+void compileSrc(const std::string& inPath, const std::string& outPath, const CompileOptions& options) {
+    // map src file, the mapping stays alive for the whole compile since tokens view into it
+    SourceFile src( inPath );
+    if (!src.isOpen()) {
         std::cerr << "Failed to open source file: " << inPath << '\n';
         exit(EXIT_FAILURE);
     }
 
-    // create empty asm file
-    std::ofstream outHandle( asmPath );
-    if (!outHandle.is_open()) {
-        inHandle.close();
-        std::cerr << "Failed to create assembly file: " << asmPath + '\n';
+    // create empty asm file, object files & executables are written in one go at the end
+    std::ofstream outHandle;
+    if (options.outputFormat == OutputFormat::ASM) {
+        outHandle.open( outPath );
+        if (!outHandle.is_open()) {
+            std::cerr << "Failed to create assembly file: " << outPath + '\n';
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // token offsets are stored in 32 bits
+    if (src.size() > UINT32_MAX) {
+        std::cerr << "Source file is too large: " << inPath << '\n';
         exit(EXIT_FAILURE);
     }
 
-    // 1. tokenize document via lexer
-    // 1.A register file with global filesIndex in errors.hpp
-    const int fileIndex = DTException::registerFile(inPath);
-    std::string line;
-    std::vector<Token> tokens;
-    trace lineNum = 0;
-    while (std::getline(inHandle, line)) {
-        if (line.back() == '\r') line.pop_back(); // remove carriage return if present
-        tokenize(line, tokens, ++lineNum, fileIndex);
+    // 1. register file with global filesIndex in errors.hpp
+    const int fileIndex = DTException::registerFile(inPath, src.view());
+
+    // 2. tokenize document via lexer & build AST via parser
+    // tokens are either streamed straight out of the lexer (constant token memory) or
+    // tokenized up front into a packed TokenStore and then streamed from it
+    AST* pAST;
+    if (options.isStreaming) {
+        LexerTokenStream stream(src.view(), fileIndex);
+        pAST = buildAST(stream);
+    } else {
+        ThreadPool pool( options.numThreads );
+        TokenStore tokens(src.view(), fileIndex);
+        tokenize(src.view(), tokens, fileIndex, pool);
+        tokens.matchGroups(); // unbalanced brackets are reported before parsing starts
+        pAST = buildAST(tokens, pool);
     }
+    AST& ast = *pAST;
 
-    // 2. build AST via parser
-    for (const Token& token : tokens) {
-        std::cout << token.raw << ' ';
+    // 3. semantic analysis, annotates the AST with types & storage slots for lowering
+    try {
+        checkSemantics(ast, fileIndex);
+    } catch (DTException& e) {
+        delete &ast;
+        throw;
     }
-    std::cout << '\n';
-    AST& ast = *buildAST(tokens);
 
-    // 3. semantic analysis
-    // TODO - perform semantic analysis check on AST, throws errors or simply does nothing if passed all checks
-    // try {
-    //     checkSemantics(ast);
-    // } catch (DTException& e) {
-    //     delete &ast;
-    //     throw;
-    // }
+    // 4. optimize
+    if (options.optLevel >= 1) {
+        eliminateDeadCode(ast);
+        if (options.optLevel >= 2) {
+            inlineCalls(ast);
+            eliminateDeadCode(ast); // callees inlined everywhere are unreachable now
+        }
+        foldConstants(ast);
+        propagateLocals(ast);
+        orderOperands(ast);
+    }
 
-    // 4. generate assembly code
-    generateASM(outHandle, ast);
+    // 5. lower to SSA form
+    FlatAST flatAST(ast, fileIndex);
+    IRModule module = buildIR(flatAST);
+    if (options.optLevel >= 1) optimizeTailCalls(module, options.isReportingTailCalls);
+    const std::string error = verifyIR(module);
+    if (!error.empty()) {
+        std::cerr << "Internal compiler error: " << error << '\n';
+        exit(EXIT_FAILURE);
+    }
+    if (options.isDumpingIR) printIR(std::cout, module);
+
+    // 6. generate machine code
+    CodegenOptions codegenOptions;
+    codegenOptions.isStrengthReducing = options.optLevel >= 1;
+    codegenOptions.isReportingTailCalls = options.isReportingTailCalls;
+    codegenOptions.isReportingSpills = options.isReportingSpills;
+    codegenOptions.isPeepholeOptimizing = options.optLevel >= 1;
+    codegenOptions.isReportingPeephole = options.isReportingPeephole;
+    const X86Program program = generateX86(module, codegenOptions);
+
+    // 7. write it out as assembly, or assemble it here
+    if (options.outputFormat == OutputFormat::ASM) {
+        writeASM(outHandle, program);
+        outHandle.close();
+    } else {
+        X86Object object;
+        const std::string encodeError = encodeX86(program, object);
+        if (!encodeError.empty()) {
+            std::cerr << "Internal compiler error: " << encodeError << '\n';
+            exit(EXIT_FAILURE);
+        }
+        const bool isWritten = options.outputFormat == OutputFormat::OBJECT ? writeELFObject(outPath, object) :
+                                                                              writeELFExecutable(outPath, object);
+        if (!isWritten) {
+            std::cerr << "Failed to create output file: " << outPath + '\n';
+            exit(EXIT_FAILURE);
+        }
+    }
 
-    // close file handles & free mem
-    inHandle.close();
-    outHandle.close();
+    // free mem
     delete &ast;
 }
\ No newline at end of file
@@ -1,8 +1,29 @@
 #ifndef __COMPILER_HPP
 #define __COMPILER_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
-void compileSrc(const std::string&, const std::string&);
+// what compileSrc() writes to its output path
+enum class OutputFormat : uint8_t {
+    ASM, // NASM source
+    OBJECT, // relocatable ELF64 object
+    EXECUTABLE // static ELF64 executable
+};
+
+// flags passed in from the command line
+struct CompileOptions {
+    bool isStreaming = false; // lex tokens on demand while parsing instead of tokenizing the whole file first
+    size_t numThreads = 1; // for lexing & parsing, 0 for one per core
+    int optLevel = 1; // -O<n>, 0 turns every optimization pass off
+    bool isReportingTailCalls = false; // print the calls compiled as jumps
+    bool isDumpingIR = false; // print the IR handed to the backend
+    bool isReportingSpills = false; // print how many values of each function had to live on the stack
+    bool isReportingPeephole = false; // print how many times each peephole rule fired
+    OutputFormat outputFormat = OutputFormat::EXECUTABLE;
+};
+
+void compileSrc(const std::string&, const std::string&, const CompileOptions&);
 
 #endif
\ No newline at end of file
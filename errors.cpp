@@ -1,6 +1,36 @@
+#include <algorithm>
+#include <cstring>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "errors.hpp"
 
-std::vector<std::string> DTException::filesIndex = std::vector<std::string>();
\ No newline at end of file
+std::vector<DTException::SourceInfo> DTException::filesIndex = std::vector<DTException::SourceInfo>();
+static std::mutex lineStartsMutex; // errors can be raised by several lexer threads at once
+
+// recovers the line & column of an error from its offset
+void DTException::locate(const ErrInfo& err, trace& line, trace& col) {
+    SourceInfo& file = filesIndex[err.fileIndex];
+
+    // lines are only indexed once something actually goes wrong
+    std::lock_guard<std::mutex> lock( lineStartsMutex );
+    if (file.lineStarts.empty()) {
+        file.lineStarts.push_back(0);
+        const char* pStart = file.src.data();
+        const char* pEnd = pStart + file.src.size();
+        for (const char* p = pStart; (p = (const char*)std::memchr(p, '\n', pEnd - p)) != nullptr; p++)
+            file.lineStarts.push_back((uint32_t)(p - pStart + 1));
+    }
+
+    // binary search for the last line starting at or before the offset
+    auto it = std::upper_bound(file.lineStarts.begin(), file.lineStarts.end(), err.offset);
+    line = (trace)(it - file.lineStarts.begin());
+    col = err.offset - *(it-1) + 1;
+}
+
+std::string DTException::getLocation(const ErrInfo& err) {
+    trace line, col;
+    locate(err, line, col);
+    return filesIndex[err.fileIndex].fileName + ':' + std::to_string(line) + ':' + std::to_string(col);
+}
\ No newline at end of file
@@ -1,8 +1,10 @@
 #ifndef __ERRORS_HPP
 #define __ERRORS_HPP
 
+#include <cstdint>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "lexer.hpp"
@@ -13,9 +15,14 @@ class DTException : public std::runtime_error {
     public:
         // keep a global list of all files so that their corresponding index
         // can be stored in tokens to save memory
-        static std::vector<std::string> filesIndex;
-        static int registerFile(const std::string& fileName) {
-            filesIndex.push_back(fileName);
+        struct SourceInfo {
+            std::string fileName;
+            std::string_view src; // to recover line & column numbers from offsets
+            std::vector<uint32_t> lineStarts; // offset of each line, built by the first error in the file
+        };
+        static std::vector<SourceInfo> filesIndex;
+        static int registerFile(const std::string& fileName, std::string_view src) {
+            filesIndex.push_back({fileName, src, {}});
             return (int)filesIndex.size()-1;
         }
 
@@ -30,16 +37,24 @@ class DTException : public std::runtime_error {
 
         // as Tokens
         DTException(const ErrInfo& err, const std::string& type) : std::runtime_error(type) {
-            this->msg = genMsg(err.line, err.col, err.fileIndex, type);
+            trace line, col;
+            locate(err, line, col);
+            this->msg = genMsg(line, col, err.fileIndex, type);
         };
         DTException(const ErrInfo& err, const std::string& type, const std::string& msg) : std::runtime_error(type) {
-            this->msg = genMsg(err.line, err.col, err.fileIndex, type, msg);
+            trace line, col;
+            locate(err, line, col);
+            this->msg = genMsg(line, col, err.fileIndex, type, msg);
         };
 
         const char* what() { return msg.c_str(); }
+
+        // file:line:col of a token, for messages that aren't errors
+        static std::string getLocation(const ErrInfo&);
     private:
+        static void locate(const ErrInfo&, trace&, trace&);
         static std::string genMsg(c_trace line, c_trace col, const int fileIndex, const std::string& type, const std::string& msg="") {
-            return type + "Exception at " + filesIndex[fileIndex] + ':'
+            return type + "Exception at " + filesIndex[fileIndex].fileName + ':'
                    + std::to_string(line) + ':' + std::to_string(col)
                    + (msg.size() > 0 ? ('\n' + msg) : "");
         }
@@ -49,8 +64,8 @@ class DTException : public std::runtime_error {
 // specific exceptions
 class DTSyntaxException : public DTException {
     public:
-        DTSyntaxException(const ErrInfo& err, const std::string& raw)
-            : DTException(err, "Syntax", "Near: " + raw) {};
+        DTSyntaxException(const ErrInfo& err, std::string_view raw)
+            : DTException(err, "Syntax", "Near: " + std::string(raw)) {};
 };
 
 class DTUnclosedGroupException : public DTException {
@@ -58,4 +73,16 @@ class DTUnclosedGroupException : public DTException {
         DTUnclosedGroupException(const ErrInfo& err) : DTException(err, "Syntax") {};
 };
 
+// valid syntax the compiler can't handle yet (ex. while loops)
+class DTUnsupportedException : public DTException {
+    public:
+        DTUnsupportedException(const ErrInfo& err, std::string_view raw)
+            : DTException(err, "Unsupported", '\'' + std::string(raw) + "' statements aren't supported yet") {};
+};
+
+class DTSemanticException : public DTException {
+    public:
+        DTSemanticException(const ErrInfo& err, const std::string& msg) : DTException(err, "Semantic", msg) {};
+};
+
 #endif
\ No newline at end of file
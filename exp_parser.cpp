@@ -1,209 +1,205 @@
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
 #include "exp_parser.hpp"
 #include "lexer.hpp" // for Tokens & types
+#include "lexer_tables.hpp"
 #include "ast/ast.hpp"
 #include "ast/ast_nodes.hpp"
 #include "errors.hpp"
+#include "token_stream.hpp"
+#include "toolbox.hpp"
+
+/************* PRECEDENCE TABLE *************/
+
+// binding power of each binary operator, higher binds tighter (same order as C)
+// prefix unaries bind tighter than every binary & postfix inc/dec tighter still
+struct OpPrecedence {
+    TokenType type;
+    uint8_t precedence;
+};
+
+constexpr OpPrecedence BINARY_OPERATORS[] = {
+    {ASSIGN, 1}, {ASSIGN_ADD, 1}, {ASSIGN_SUB, 1}, {ASSIGN_MUL, 1}, {ASSIGN_DIV, 1}, {ASSIGN_MOD, 1},
+    {ASSIGN_LSHIFT, 1}, {ASSIGN_RSHIFT, 1}, {ASSIGN_BIT_OR, 1}, {ASSIGN_BIT_AND, 1}, {ASSIGN_BIT_NOT, 1}, {ASSIGN_BIT_XOR, 1},
+    {OP_BOOL_OR, 2},
+    {OP_BOOL_AND, 3},
+    {OP_BIT_OR, 4},
+    {OP_BIT_XOR, 5},
+    {OP_BIT_AND, 6},
+    {OP_EQ, 7}, {OP_NEQ, 7},
+    {OP_LT, 8}, {OP_LTE, 8}, {OP_GT, 8}, {OP_GTE, 8},
+    {OP_LSHIFT, 9}, {OP_RSHIFT, 9},
+    {OP_ADD, 10}, {OP_SUB, 10},
+    {OP_MUL, 11}, {OP_DIV, 11}, {OP_MOD, 11}
+};
+constexpr uint8_t PREC_ASSIGN = 1; // the only right-associative level
+constexpr uint8_t PREC_PREFIX = 12;
+
+struct PrecedenceTable {
+    uint8_t binary[NUM_TOKEN_TYPES]; // 0 if the token isn't a binary operator
+};
+
+constexpr PrecedenceTable buildPrecedenceTable() {
+    PrecedenceTable table = {};
+    for (const OpPrecedence& op : BINARY_OPERATORS)
+        table.binary[op.type] = op.precedence;
+    return table;
+}
+
+constexpr PrecedenceTable PRECEDENCE_TABLE = buildPrecedenceTable();
+
+/************* PARSER *************/
+
+// operator waiting on the operator stack for its right operand
+// a CALL is an open argument list, its arguments are the operands from operandBase up
+struct PendingOp {
+    enum Kind : uint8_t { PREFIX, BINARY, PAREN, CALL } kind;
+    uint8_t precedence;
+    Token token;
+    size_t operandBase = 0;
+
+    bool isGroup() const { return kind == PAREN || kind == CALL; };
+};
+
+// pops the top operator & combines it with its operand(s) from the operand stack
+static void reduce(std::vector<PendingOp>& ops, std::vector<ASTNode*>& operands, ASTArena& arena) {
+    const PendingOp op = ops.back();
+    ops.pop_back();
+
+    ASTNode* pRight = operands.back();
+    operands.pop_back();
+    if (op.kind == PendingOp::PREFIX) {
+        // ++/-- need something to store back to
+        if ((op.token.type == OP_INC || op.token.type == OP_DEC) && pRight->nodeType() != ASTNodeType::IDENTIFIER)
+            throw DTSyntaxException(op.token.err, op.token.raw);
+        ASTUnaryExpr* pUnary = arena.make<ASTUnaryExpr>(op.token, arena);
+        pUnary->push(pRight);
+        operands.push_back(pUnary);
+    } else {
+        ASTNode* pLeft = operands.back();
+        operands.pop_back();
+        if (op.precedence == PREC_ASSIGN && pLeft->nodeType() != ASTNodeType::IDENTIFIER)
+            throw DTSyntaxException(op.token.err, op.token.raw);
+        ASTBinExpr* pBin = arena.make<ASTBinExpr>(op.token, arena);
+        pBin->push(pLeft);
+        pBin->push(pRight);
+        operands.push_back(pBin);
+    }
+}
+
+// closes the argument list on top of the operator stack, its arguments become one call operand
+static void reduceCall(std::vector<PendingOp>& ops, std::vector<ASTNode*>& operands, ASTArena& arena) {
+    const PendingOp call = ops.back();
+    ops.pop_back();
+
+    ASTCall* pCall = arena.make<ASTCall>(call.token, arena);
+    for (size_t i = call.operandBase; i < operands.size(); i++)
+        pCall->push(operands[i]);
+    operands.resize(call.operandBase);
+    operands.push_back(pCall);
+}
+
+// makes the leaf node for a literal or identifier token
+static ASTNode* parseOperand(const Token& token, ASTArena& arena) {
+    switch (token.type) {
+        case TokenType::LIT_BOOL: return arena.make<ASTBoolLiteral>(token.value.b, token, arena);
+        case TokenType::LIT_CHAR: return arena.make<ASTCharLiteral>(token.value.c, token, arena);
+        case TokenType::LIT_DOUBLE: return arena.make<ASTDoubleLiteral>(token.value.d, token, arena);
+        case TokenType::LIT_INT: return arena.make<ASTIntLiteral>(token.value.i, token, arena);
+        case TokenType::LIT_STR: return arena.make<ASTStringLiteral>(arena.copyString(unescapeString(token.raw)), token, arena);
+        case TokenType::LIT_NULL: return arena.make<ASTNullLiteral>(token, arena);
+        case TokenType::IDENTIFIER: return arena.make<ASTIdentifier>(token, arena);
+        default: throw DTSyntaxException(token.err, token.raw);
+    }
+}
 
 // for parsing an expression
-// (bottom)     -->     -->     -->     -->     -->     -->     -->     (top)
-// PARENTHESIS, UNARIES, MULT/DIV/MOD, ADD/SUB & INC/DEC, COMPARISON, ASSIGNMENT
-/**
- * 1. PARSE ALL TOKENS (W/ PARENTHESIS RECURSIVELY) SO NODE IS FLAT EXCEPT FOR PARENTHETICALS
- * 2. COMBINE UNARIES
- * 3. COMBINE MULT/DIV/MOD ARGS ON EITHER SIDE
- * 4. ADD/SUB & INC/DEC
- * 5. COMPARISON
- * 6. ASSIGNMENT
- * 7. ASTEXPR SHOULD NOW BE FORMATTED HIERARCHICALLY
-*/
-ASTNode* parseExpresion(const std::vector<Token>& tokens, size_t start, size_t end) {
-    ASTExpr* pNode = new ASTExpr(tokens[start]);
-
-    // initially parse tokens as flat vector
-    try {
-        for (size_t i = start; i <= end; i++) {
-            // if opening a parenthesis group, find closing parenthesis & recurse-parse it
-            if (tokens[i].type == LPAREN) {
-                size_t start = i, parensOpen = 1;
-                while (++i <= end && parensOpen > 0) {
-                    if (tokens[i].type == RPAREN) parensOpen--;
-                    else if (tokens[i].type == LPAREN) parensOpen++;
-                }
-                if (i-- > end) throw DTUnclosedGroupException(tokens[start].err);
-                pNode->push( parseExpresion(tokens, start+1, i-1) );
-            } else if (isTokenLiteral(tokens[i].type)) { // push literal
-                switch (tokens[i].type) {
-                    case TokenType::LIT_BOOL:
-                        pNode->push( new ASTBoolLiteral(tokens[i].raw == "true", tokens[i]) );
-                        break;
-                    case TokenType::LIT_CHAR:
-                        pNode->push( new ASTCharLiteral(tokens[i].raw[0], tokens[i]) );
-                        break;
-                    case TokenType::LIT_DOUBLE:
-                        pNode->push( new ASTDoubleLiteral(std::stod(tokens[i].raw), tokens[i]) );
-                        break;
-                    case TokenType::LIT_INT:
-                        pNode->push( new ASTIntLiteral(std::stoi(tokens[i].raw), tokens[i]) );
-                        break;
-                    case TokenType::LIT_STR:
-                        pNode->push( new ASTStringLiteral(tokens[i].raw, tokens[i]) );
-                        break;
-                    case TokenType::LIT_NULL:
-                        pNode->push( new ASTNullLiteral(tokens[i]) );
-                        break;
-                    default: break; // suppress g++ warnings
-                }
-            } else if (isTokenUnaryOp(tokens[i].type)) { // push unary
-                pNode->push( new ASTUnaryExpr(tokens[i]) );
-            } else if (isTokenBinaryOp(tokens[i].type)) { // push binary
-                pNode->push( new ASTBinExpr(tokens[i]) );
-            } else if (tokens[i].type == TokenType::IDENTIFIER) {
-                pNode->push( new ASTIdentifier(tokens[i]) );
+// single pass operator precedence parser, operands & pending operators are kept on explicit
+// stacks (parentheses too) so the work is linear & nesting depth is only bounded by memory
+// calls are argument lists on the same stacks, so they nest just as freely
+// the expression ends at the first ; or unmatched ) which is left for the caller
+ASTNode* parseExpresion(TokenStream& stream, ASTArena& arena) {
+    const Token* pFirst = stream.peek();
+    ASTExpr* pNode = arena.make<ASTExpr>(pFirst != nullptr ? *pFirst : stream.last(), arena);
+
+    std::vector<ASTNode*> operands;
+    std::vector<PendingOp> ops;
+    bool isExpectingOperand = true; // false once an operand is complete & an operator may follow
+    size_t parenDepth = 0;
+
+    const Token* pToken;
+    while ((pToken = stream.peek()) != nullptr && pToken->type != SEMICOLON) {
+        const Token& token = *pToken;
+        if (isExpectingOperand) {
+            const Token* pNext = stream.peek(1);
+            if (token.type == IDENTIFIER && pNext != nullptr && pNext->type == LPAREN) { // call
+                ops.push_back({PendingOp::CALL, 0, token, operands.size()});
+                parenDepth++;
+                stream.next(); // name, the ( is consumed below
+            } else if (token.type == RPAREN && !ops.empty() && ops.back().kind == PendingOp::CALL &&
+                       operands.size() == ops.back().operandBase) { // call w/o arguments
+                reduceCall(ops, operands, arena);
+                parenDepth--;
+                isExpectingOperand = false;
+            } else if (token.type == LPAREN) {
+                ops.push_back({PendingOp::PAREN, 0, token});
+                parenDepth++;
+            } else if (isTokenUnaryOp(token.type)) {
+                ops.push_back({PendingOp::PREFIX, PREC_PREFIX, token});
             } else {
-                throw DTSyntaxException(tokens[i].err, tokens[i].raw);
-            }
-        }
-
-        // hierarchically rearrange expression
-
-        // COMBINE UNARIES
-        for (size_t i = 0; i < pNode->size(); i++) {
-            ASTNode* pCurrent = pNode->at(i);
-            if (pCurrent->nodeType() == ASTNodeType::UNARY_EXPR) {
-                // verify if this is a math operation (+ or - sign), it's valid
-                ASTUnaryExpr* pCurrentExpr = static_cast<ASTUnaryExpr*>(pCurrent);
-                TokenType opType = pCurrentExpr->opType();
-                if ((opType == TokenType::OP_ADD || opType == TokenType::OP_SUB) &&
-                    !(i == 0 || pNode->at(i-1)->nodeType() == ASTNodeType::UNARY_EXPR || pNode->at(i-1)->nodeType() == ASTNodeType::BIN_EXPR)) {
-                    continue;
-                }
-                
-                // ignore inc/decrements
-                if (opType == TokenType::OP_INC || opType == TokenType::OP_DEC) continue;
-
-                // unary child is after the unary
-                // check for following expression
-                if (i+1 == pNode->size()) throw DTSyntaxException(pCurrent->err, pCurrent->raw);
-
-                // append next node as child of unary
-                pCurrent->push(pNode->at(i+1));
-                pNode->removeChild(i+1);
-            }
-        }
-
-        // COMBINE MULT/DIV/MOD ARGS ON EITHER SIDE
-        for (size_t i = 0; i < pNode->size(); i++) {
-            ASTNode* pCurrent = pNode->at(i);
-            if (pCurrent->nodeType() == ASTNodeType::BIN_EXPR) {
-                // verify this is mult/div/mod math operation
-                ASTBinExpr* pCurrentExpr = static_cast<ASTBinExpr*>(pCurrent);
-                TokenType opType = pCurrentExpr->opType();
-                if (opType != TokenType::OP_MUL && opType != TokenType::OP_DIV && opType != TokenType::OP_MOD)
-                    continue;
-
-                // check for following expression
-                if (i == 0 || i+1 == pNode->size()) throw DTSyntaxException(pCurrent->err, pCurrent->raw);
-                
-                // append previous and next nodes as children of bin expr
-                pCurrent->push(pNode->at(i-1));
-                pCurrent->push(pNode->at(i+1));
-                pNode->removeChild(i+1); // remove last, first to prevent adjusting indexing
-                pNode->removeChild(i-1);
-                i--; // skip back once since removing previous node
+                operands.push_back(parseOperand(token, arena));
+                isExpectingOperand = false;
             }
+            stream.next();
+            continue;
         }
 
-        // ADD/SUB & INC/DEC
-        for (size_t i = 0; i < pNode->size(); i++) {
-            ASTNode* pCurrent = pNode->at(i);
-            if (pCurrent->nodeType() == ASTNodeType::UNARY_EXPR) {
-                // verify this is inc or dec
-                ASTUnaryExpr* pCurrentExpr = static_cast<ASTUnaryExpr*>(pCurrent);
-                TokenType opType = pCurrentExpr->opType();
-                if (opType != TokenType::OP_INC && opType != TokenType::OP_DEC) continue;
-
-                // check if identifiers are before/after operator
-                // first takes precedence (ex. i++i -> i++ and i)
-                bool isIdenBefore = i > 0 && pNode->at(i-1)->nodeType() == ASTNodeType::IDENTIFIER;
-                bool isIdenAfter = i+1 < pNode->size() && pNode->at(i+1)->nodeType() == ASTNodeType::IDENTIFIER;
-
-                if (isIdenBefore) { // append last node as child of unary
-                    pCurrent->push(pNode->at(i-1));
-                    pNode->removeChild(i-1);
-                    i--; // fix increment offset
-                } else if (isIdenAfter) { // append next node as child of unary
-                    pCurrent->push(pNode->at(i+1));
-                    pNode->removeChild(i+1);
-                    pCurrentExpr->setIsPostOperator(true);
-                } else {
-                    throw DTSyntaxException(pCurrent->err, pCurrent->raw);
-                }
-            } else if (pCurrent->nodeType() == ASTNodeType::BIN_EXPR) {
-                // verify this is add/sub math operation
-                ASTBinExpr* pCurrentExpr = static_cast<ASTBinExpr*>(pCurrent);
-                TokenType opType = pCurrentExpr->opType();
-                if (opType != TokenType::OP_ADD && opType != TokenType::OP_SUB) continue;
-
-                // check for following expression
-                if (i == 0 || i+1 == pNode->size()) throw DTSyntaxException(pCurrent->err, pCurrent->raw);
-                
-                // append previous and next nodes as children of bin expr
-                pCurrent->push(pNode->at(i-1));
-                pCurrent->push(pNode->at(i+1));
-                pNode->removeChild(i+1); // remove last, first to prevent adjusting indexing
-                pNode->removeChild(i-1);
-                i--; // skip back once since removing previous node
-            }
-        }
-
-        // COMPARISON OPERATORS
-        for (size_t i = 0; i < pNode->size(); i++) {
-            ASTNode* pCurrent = pNode->at(i);
-            if (pCurrent->nodeType() == ASTNodeType::BIN_EXPR) {
-                // verify this is a comparison operation
-                ASTBinExpr* pCurrentExpr = static_cast<ASTBinExpr*>(pCurrent);
-                if (!isTokenCompOp(pCurrentExpr->opType())) continue;
-
-                // check for following expression
-                if (i == 0 || i+1 == pNode->size()) throw DTSyntaxException(pCurrent->err, pCurrent->raw);
-                
-                // append previous and next nodes as children of bin expr
-                pCurrent->push(pNode->at(i-1));
-                pCurrent->push(pNode->at(i+1));
-                pNode->removeChild(i+1); // remove last, first to prevent adjusting indexing
-                pNode->removeChild(i-1);
-                i--; // skip back once since removing previous node
-            }
+        if (token.type == OP_INC || token.type == OP_DEC) { // postfix, binds tighter than anything on the stack
+            if (operands.back()->nodeType() != ASTNodeType::IDENTIFIER)
+                throw DTSyntaxException(token.err, token.raw);
+            ASTUnaryExpr* pUnary = arena.make<ASTUnaryExpr>(token, arena);
+            pUnary->setIsPostOperator(true);
+            pUnary->push(operands.back());
+            operands.back() = pUnary;
+        } else if (token.type == RPAREN) {
+            if (parenDepth == 0) break; // closes a group the caller opened
+            while (!ops.back().isGroup())
+                reduce(ops, operands, arena);
+            if (ops.back().kind == PendingOp::CALL) reduceCall(ops, operands, arena);
+            else ops.pop_back();
+            parenDepth--;
+        } else if (token.type == COMMA && parenDepth > 0) { // next argument
+            while (!ops.back().isGroup())
+                reduce(ops, operands, arena);
+            if (ops.back().kind != PendingOp::CALL) throw DTSyntaxException(token.err, token.raw);
+            isExpectingOperand = true;
+        } else if (PRECEDENCE_TABLE.binary[token.type] != 0) {
+            // everything on the stack that binds at least as tight goes first (assignments group right)
+            const uint8_t precedence = PRECEDENCE_TABLE.binary[token.type];
+            while (!ops.empty() && !ops.back().isGroup() &&
+                   (ops.back().precedence > precedence || (ops.back().precedence == precedence && precedence != PREC_ASSIGN)))
+                reduce(ops, operands, arena);
+            ops.push_back({PendingOp::BINARY, precedence, token});
+            isExpectingOperand = true;
+        } else {
+            throw DTSyntaxException(token.err, token.raw);
         }
+        stream.next();
+    }
 
-        // ASSIGNMENTS
-        for (size_t i = 0; i < pNode->size(); i++) {
-            ASTNode* pCurrent = pNode->at(i);
-            if (pCurrent->nodeType() == ASTNodeType::BIN_EXPR) {
-                // verify this is an assignment expression
-                ASTBinExpr* pCurrentExpr = static_cast<ASTBinExpr*>(pCurrent);
-                if (!isTokenAssignOp(pCurrentExpr->opType())) continue;
-
-                // check for following expression
-                if (i == 0 || i+1 == pNode->size()) throw DTSyntaxException(pCurrent->err, pCurrent->raw);
-                
-                // append previous and next nodes as children of bin expr
-                pCurrent->push(pNode->at(i-1));
-                pCurrent->push(pNode->at(i+1));
-                pNode->removeChild(i+1); // remove last, first to prevent adjusting indexing
-                pNode->removeChild(i-1);
-                i--; // skip back once since removing previous node
-            }
-        }
+    // the expression can't end on an operator (or be empty)
+    if (isExpectingOperand) {
+        const Token& token = pToken != nullptr ? *pToken : stream.last();
+        throw DTSyntaxException(token.err, token.raw);
+    }
 
-        // ASTEXPR SHOULD NOW BE FORMATTED HIERARCHICALLY
-    } catch (DTException& e) {
-        delete pNode;
-        throw;
+    while (!ops.empty()) {
+        if (ops.back().isGroup()) throw DTUnclosedGroupException(ops.back().token.err);
+        reduce(ops, operands, arena);
     }
+    pNode->push(operands.back());
 
     return pNode;
 }
\ No newline at end of file
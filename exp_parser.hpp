@@ -4,10 +4,11 @@
 #include <vector>
 
 #include "lexer.hpp" // for Tokens & types
+#include "token_stream.hpp"
 #include "ast/ast.hpp"
 #include "ast/ast_nodes.hpp"
 
 // this single method deserves its own file because it's so damn complicated
-ASTNode* parseExpresion(const std::vector<Token>&, size_t, size_t);
+ASTNode* parseExpresion(TokenStream&, ASTArena&);
 
 #endif
\ No newline at end of file
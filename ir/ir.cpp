@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "ir.hpp"
+
+const char* getOpName(IROp op) {
+#define IR_OPCODE_NAME(op, name) name,
+    static const char* const NAMES[] = { IR_OPCODE_LIST(IR_OPCODE_NAME) };
+#undef IR_OPCODE_NAME
+    return NAMES[(size_t)op];
+}
+
+size_t IRBlock::numSuccessors() const {
+    switch (terminator().op) {
+        case IROp::BR: return 1;
+        case IROp::CBR: return 2;
+        default: return 0;
+    }
+}
+
+// iterative DFS, so deep chains of && / || can't overflow the native stack
+std::vector<block_id> getReversePostorder(const IRFunction& func) {
+    std::vector<block_id> order;
+    std::vector<uint8_t> isVisited(func.blocks.size(), false);
+    struct Frame {
+        block_id block;
+        size_t nextSuccessor;
+    };
+    std::vector<Frame> dfs = {{0, 0}};
+    isVisited[0] = true;
+    while (!dfs.empty()) {
+        Frame& frame = dfs.back();
+        const IRBlock& block = func.blocks[frame.block];
+        if (frame.nextSuccessor < block.numSuccessors()) {
+            // last successor first, so the first one ends up right after the block
+            const block_id next = block.successor(block.numSuccessors() - 1 - frame.nextSuccessor++);
+            if (!isVisited[next]) {
+                isVisited[next] = true;
+                dfs.push_back({next, 0}); // invalidates frame
+            }
+            continue;
+        }
+        order.push_back(frame.block);
+        dfs.pop_back();
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Cooper, Harvey & Kennedy's "A Simple, Fast Dominance Algorithm"
+std::vector<block_id> getDominators(const IRFunction& func) {
+    const std::vector<block_id> order = getReversePostorder(func);
+    std::vector<uint32_t> rank(func.blocks.size(), UINT32_MAX); // position in order
+    for (size_t i = 0; i < order.size(); i++) rank[order[i]] = (uint32_t)i;
+
+    std::vector<block_id> idom(func.blocks.size(), UINT32_MAX);
+    idom[0] = 0;
+    bool isChanged = true;
+    while (isChanged) {
+        isChanged = false;
+        for (size_t i = 1; i < order.size(); i++) {
+            const block_id b = order[i];
+            block_id newIdom = UINT32_MAX;
+            for (block_id pred : func.blocks[b].preds) {
+                if (idom[pred] == UINT32_MAX) continue; // not processed yet (or unreachable)
+                if (newIdom == UINT32_MAX) {
+                    newIdom = pred;
+                    continue;
+                }
+                // walk both up to their common dominator
+                block_id x = pred, y = newIdom;
+                while (x != y) {
+                    while (rank[x] > rank[y]) x = idom[x];
+                    while (rank[y] > rank[x]) y = idom[y];
+                }
+                newIdom = x;
+            }
+            if (idom[b] != newIdom) {
+                idom[b] = newIdom;
+                isChanged = true;
+            }
+        }
+    }
+    return idom;
+}
+
+void removeUnreachableBlocks(IRFunction& func) {
+    std::vector<block_id> newIds(func.blocks.size(), UINT32_MAX);
+    for (block_id b : getReversePostorder(func)) newIds[b] = 0;
+    block_id numKept = 0;
+    for (size_t b = 0; b < func.blocks.size(); b++)
+        if (newIds[b] == 0) newIds[b] = numKept++;
+    if (numKept == func.blocks.size()) return;
+
+    std::vector<IRBlock> kept;
+    kept.reserve(numKept);
+    for (size_t b = 0; b < func.blocks.size(); b++) {
+        if (newIds[b] == UINT32_MAX) continue;
+        IRBlock& block = func.blocks[b];
+
+        // edges from dropped blocks go, along with what they fed the phis
+        std::vector<block_id> preds;
+        std::vector<size_t> keptPreds;
+        for (size_t i = 0; i < block.preds.size(); i++) {
+            if (newIds[block.preds[i]] == UINT32_MAX) continue;
+            preds.push_back(newIds[block.preds[i]]);
+            keptPreds.push_back(i);
+        }
+        for (IRInstr& instr : block.instrs) {
+            if (instr.op != IROp::PHI) break;
+            std::vector<vreg_t> args;
+            for (size_t i : keptPreds) args.push_back(instr.args[i]);
+            instr.args = std::move(args);
+        }
+        block.preds = std::move(preds);
+
+        IRInstr& terminator = block.instrs.back();
+        for (size_t i = 0; i < block.numSuccessors(); i++)
+            terminator.targets[i] = newIds[terminator.targets[i]];
+        kept.push_back(std::move(block));
+    }
+    func.blocks = std::move(kept);
+}
\ No newline at end of file
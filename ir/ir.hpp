@@ -0,0 +1,121 @@
+#ifndef __IR_HPP
+#define __IR_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "../symbols.hpp"
+
+// virtual register, each one is defined by exactly one instruction (SSA)
+typedef uint32_t vreg_t;
+#define VREG_NONE UINT32_MAX
+
+typedef uint32_t block_id;
+
+// what a virtual register holds, ints, chars, bools & strings (addresses) are all 64 bit ints
+enum class IRType : uint8_t {
+    NONE, // for instructions that don't define a value
+    I64,
+    F64
+};
+
+// every opcode as X(opcode, name in dumps)
+#define IR_OPCODE_LIST(X) \
+    /* values */ \
+    X(PARAM, "param") /* imm.i = index of the param */ \
+    X(CONST, "const") /* imm.i, or imm.d for F64 */ \
+    X(STRING, "string") /* address of string literal imm.i */ \
+    X(LOAD_GLOBAL, "load") /* global imm.i */ \
+    X(STORE_GLOBAL, "store") /* args[0] into global imm.i */ \
+    X(PHI, "phi") /* args[i] is the value coming from the block's preds[i] */ \
+    X(CALL, "call") /* function imm.i, args already converted to its params' types */ \
+    /* ints, wrapping, shift counts are taken mod 64 & DIV / MOD trap like idiv does */ \
+    X(ADD, "add") X(SUB, "sub") X(MUL, "mul") X(DIV, "div") X(MOD, "mod") \
+    X(SHL, "shl") X(SAR, "sar") X(AND, "and") X(OR, "or") X(XOR, "xor") \
+    X(NEG, "neg") X(NOT, "not") \
+    /* doubles */ \
+    X(FADD, "fadd") X(FSUB, "fsub") X(FMUL, "fmul") X(FDIV, "fdiv") X(FNEG, "fneg") \
+    /* comparisons give 1 or 0, on doubles they're false for NaN (except FNE) */ \
+    X(EQ, "eq") X(NE, "ne") X(LT, "lt") X(LE, "le") X(GT, "gt") X(GE, "ge") \
+    X(FEQ, "feq") X(FNE, "fne") X(FLT, "flt") X(FLE, "fle") X(FGT, "fgt") X(FGE, "fge") \
+    /* conversions */ \
+    X(ITOF, "itof") \
+    X(SEXT8, "sext8") /* wraps an int into a char */ \
+    /* terminators, exactly one ends each block */ \
+    X(BR, "br") /* to targets[0] */ \
+    X(CBR, "cbr") /* to targets[0] if args[0] != 0, else targets[1] */ \
+    X(RET, "ret") /* args[0] is the value returned */
+
+#define IR_OPCODE_TAG(op, name) op,
+enum class IROp : uint8_t {
+    IR_OPCODE_LIST(IR_OPCODE_TAG)
+};
+#undef IR_OPCODE_TAG
+
+const char* getOpName(IROp);
+
+constexpr bool isTerminator(IROp op) { return op == IROp::BR || op == IROp::CBR || op == IROp::RET; }
+
+#define IR_FLAG_TAIL 0x1 // CALL whose value is returned right after it, set by optimizeTailCalls()
+
+union IRImmediate {
+    long long i;
+    double d;
+};
+
+struct IRInstr {
+    IROp op;
+    IRType type = IRType::NONE; // of dst
+    uint8_t flags = 0;
+    vreg_t dst = VREG_NONE;
+    std::vector<vreg_t> args;
+    IRImmediate imm = {0};
+    block_id targets[2] = {0, 0}; // BR & CBR
+    uint32_t offset = 0; // into the source file, of what the instruction was lowered from
+};
+
+// phis come first & the terminator last
+// a CBR's targets always have it as their only pred (no critical edges), so whatever feeds a
+// block's phis can be placed at the end of its preds
+struct IRBlock {
+    std::vector<IRInstr> instrs;
+    std::vector<block_id> preds; // in the order phis list their args
+
+    const IRInstr& terminator() const { return instrs.back(); };
+    size_t numSuccessors() const;
+    block_id successor(size_t i) const { return terminator().targets[i]; };
+};
+
+struct IRFunction {
+    symbol_t name = SYMBOL_NONE;
+    uint32_t index = 0; // in the module
+    IRType returnType = IRType::I64;
+    std::vector<IRType> paramTypes;
+    std::vector<IRBlock> blocks; // blocks[0] is the entry
+    std::vector<IRType> vregTypes; // indexed by vreg
+
+    vreg_t newVreg(IRType type) { vregTypes.push_back(type); return (vreg_t)vregTypes.size()-1; };
+    block_id newBlock() { blocks.emplace_back(); return (block_id)blocks.size()-1; };
+    size_t numVregs() const { return vregTypes.size(); };
+};
+
+struct IRModule {
+    std::vector<IRFunction> functions; // in source order
+    IRFunction init; // stores every global's initial value, runs before main
+    std::vector<IRType> globalTypes;
+    std::vector<std::string_view> strings; // literals in source order, view into the AST's arena
+    uint32_t mainIndex = 0;
+    int fileIndex = 0; // for locating offsets
+};
+
+// reachable blocks, each after all of its preds (except along back edges)
+std::vector<block_id> getReversePostorder(const IRFunction&);
+
+// immediate dominator of each reachable block (the entry's is itself), UINT32_MAX if unreachable
+std::vector<block_id> getDominators(const IRFunction&);
+
+// drops blocks no path from the entry reaches & renumbers the rest in order
+void removeUnreachableBlocks(IRFunction&);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,477 @@
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include "ir_builder.hpp"
+#include "../ast/ast_visitor.hpp"
+#include "../semantics.hpp"
+
+static IRType getIRType(TokenType type) {
+    return type == TYPE_DOUBLE ? IRType::F64 : IRType::I64;
+}
+
+// opcode of a binary operator on ints or on doubles, operands converted to the same type first
+static IROp getBinaryOp(TokenType op, bool isDouble) {
+    switch (op) {
+        case OP_ADD: return isDouble ? IROp::FADD : IROp::ADD;
+        case OP_SUB: return isDouble ? IROp::FSUB : IROp::SUB;
+        case OP_MUL: return isDouble ? IROp::FMUL : IROp::MUL;
+        case OP_DIV: return isDouble ? IROp::FDIV : IROp::DIV;
+        case OP_MOD: return IROp::MOD;
+        case OP_LSHIFT: return IROp::SHL;
+        case OP_RSHIFT: return IROp::SAR;
+        case OP_BIT_AND: return IROp::AND;
+        case OP_BIT_OR: return IROp::OR;
+        case OP_BIT_XOR: return IROp::XOR;
+        case OP_EQ: return isDouble ? IROp::FEQ : IROp::EQ;
+        case OP_NEQ: return isDouble ? IROp::FNE : IROp::NE;
+        case OP_LT: return isDouble ? IROp::FLT : IROp::LT;
+        case OP_LTE: return isDouble ? IROp::FLE : IROp::LE;
+        case OP_GT: return isDouble ? IROp::FGT : IROp::GT;
+        default: return isDouble ? IROp::FGE : IROp::GE; // OP_GTE
+    }
+}
+
+// lowers one function body (or the global initializers) into func
+// each local's current value is tracked per slot as the body is walked in evaluation order,
+// the only control flow is && / || so every merge joins exactly the two sides of one of them,
+// writes are logged so the right side's can be undone & merged in phis once it's done
+// expressions are lowered from a staged work stack (see ast_visitor.hpp): each handler runs once
+// per stage of its node, it can queue the node again at a later stage after the operand to lower
+// first & every value lowered is left on values for its operator to take
+class IRBuilder : public FlatASTVisitor<IRBuilder> {
+    public:
+        IRBuilder(const FlatAST& ast, IRFunction& func, size_t numSlots)
+            : FlatASTVisitor(ast), func(func), current(numSlots, VREG_NONE), stamps(numSlots, 0) {
+            block = func.newBlock();
+        };
+
+        void buildFunction(node_id node) {
+            const FlatFunction& function = ast.function(node);
+            for (size_t i = 0; i < function.params.count; i++) {
+                const IRType type = getIRType(ast.param(function, i).second);
+                func.paramTypes.push_back(type);
+                IRInstr& param = emit(IROp::PARAM, type, node);
+                param.imm.i = (long long)i;
+                writeLocal((slot_t)i, param.dst); // params are the first slots
+            }
+
+            const TokenType returnType = ast.op(node);
+            for (size_t i = 0; i < ast.numChildren(node); i++) {
+                const node_id statement = ast.child(node, i);
+                switch (ast.tag(statement)) {
+                    case ASTNodeType::VARIABLE: {
+                        const node_id init = ast.child(statement, 0);
+                        const vreg_t value = convert(build(init), ast.type(init), ast.type(statement), statement);
+                        writeLocal(ast.value(statement).var.slot, value);
+                        break;
+                    }
+                    case ASTNodeType::RETURN: {
+                        vreg_t value;
+                        if (ast.numChildren(statement) > 0) {
+                            const node_id expr = ast.child(statement, 0);
+                            value = convert(build(expr), ast.type(expr), returnType, statement);
+                        } else {
+                            value = emitZero(returnType, statement);
+                        }
+                        emitReturn(value, statement);
+                        return; // nothing after it runs
+                    }
+                    case ASTNodeType::EXPR:
+                        build(statement);
+                        break;
+                    default: break;
+                }
+            }
+            emitReturn(emitZero(returnType, node), node); // falling off the end returns 0
+        };
+
+        void buildGlobal(node_id var) {
+            const node_id init = ast.child(var, 0);
+            const vreg_t value = convert(build(init), ast.type(init), ast.type(var), var);
+            emitStore(ast.value(var).var.slot, value, var);
+        };
+
+        void finishGlobals() { emit(IROp::RET, IRType::NONE, ast.root()); };
+
+        // wrapper around the top of the expression
+        void visitExpr(node_id expr) { lower(ast.child(expr, 0)); };
+
+        void visitIdentifier(node_id node) { values.push_back(read(node)); };
+
+        void visitUnaryExpr(node_id expr) {
+            const node_id operand = ast.child(expr, 0);
+            const TokenType type = ast.type(expr);
+            const TokenType op = ast.op(expr);
+            if (op == OP_INC || op == OP_DEC) {
+                values.push_back(buildIncrement(expr, operand));
+                return;
+            }
+            if (stage == 0) {
+                resume(expr, 1);
+                lower(operand);
+                return;
+            }
+
+            const vreg_t value = popValue();
+            switch (op) {
+                case OP_ADD:
+                    values.push_back(convert(value, ast.type(operand), type, expr));
+                    break;
+                case OP_SUB: {
+                    const vreg_t converted = convert(value, ast.type(operand), type, expr);
+                    values.push_back(emitValue(type == TYPE_DOUBLE ? IROp::FNEG : IROp::NEG, getIRType(type), {converted}, expr));
+                    break;
+                }
+                case OP_BOOL_NOT:
+                    values.push_back(emitValue(IROp::EQ, IRType::I64, {value, emitConstant(0, expr)}, expr));
+                    break;
+                default: // OP_BIT_NOT
+                    values.push_back(emitValue(IROp::NOT, IRType::I64, {value}, expr));
+                    break;
+            }
+        };
+
+        void visitBinExpr(node_id expr) {
+            const node_id left = ast.child(expr, 0), right = ast.child(expr, 1);
+            const TokenType op = ast.op(expr);
+            if (op == OP_BOOL_AND || op == OP_BOOL_OR) {
+                buildLogical(expr);
+                return;
+            }
+
+            // plain assignment only needs the right side
+            if (op == ASSIGN) {
+                if (stage == 0) {
+                    resume(expr, 1);
+                    lower(right);
+                    return;
+                }
+                const vreg_t value = convert(popValue(), ast.type(right), ast.type(left), expr);
+                write(left, value, expr);
+                values.push_back(value);
+                return;
+            }
+
+            // both operands are brought to a common type: double if either one is, each right
+            // after it's lowered, the right goes first only when neither side has side effects
+            const bool isDouble = ast.type(left) == TYPE_DOUBLE || ast.type(right) == TYPE_DOUBLE;
+            const TokenType operandType = isDouble ? TYPE_DOUBLE : TYPE_INT;
+            const bool isRightFirst = ast.isRightFirst(expr);
+            const node_id first = isRightFirst ? right : left, second = isRightFirst ? left : right;
+            if (stage == 0) {
+                resume(expr, 1);
+                lower(first);
+                return;
+            } else if (stage == 1) {
+                values.back() = convert(values.back(), ast.type(first), operandType, expr);
+                resume(expr, 2);
+                lower(second);
+                return;
+            }
+            const vreg_t secondValue = convert(popValue(), ast.type(second), operandType, expr);
+            const vreg_t firstValue = popValue();
+            const vreg_t a = isRightFirst ? secondValue : firstValue, b = isRightFirst ? firstValue : secondValue;
+
+            const TokenType binaryOp = isTokenAssignOp(op) ? getCompoundOp(op) : op;
+            const IROp irOp = getBinaryOp(binaryOp, isDouble);
+            const bool isCompare = irOp >= IROp::EQ && irOp <= IROp::FGE;
+            const vreg_t result = emitValue(irOp, isCompare ? IRType::I64 : getIRType(operandType), {a, b}, expr);
+            if (!isTokenAssignOp(op)) {
+                values.push_back(result);
+                return;
+            }
+
+            // compound assignment, the result goes back into the left's type
+            const vreg_t value = convert(result, operandType, ast.type(left), expr);
+            write(left, value, expr);
+            values.push_back(value);
+        };
+
+        // stage i has lowered the first i arguments, each converted to its param's type
+        void visitCall(node_id call) {
+            const FlatFunction& callee = ast.function(call);
+            const size_t numArgs = ast.numChildren(call);
+            if (stage > 0) {
+                const node_id arg = ast.child(call, stage - 1);
+                values.back() = convert(values.back(), ast.type(arg), ast.param(callee, stage - 1).second, arg);
+            }
+            if (stage < numArgs) {
+                resume(call, stage + 1);
+                lower(ast.child(call, stage));
+                return;
+            }
+
+            IRInstr& instr = emit(IROp::CALL, getIRType(ast.type(call)), call);
+            instr.args.assign(values.end() - numArgs, values.end());
+            instr.imm.i = ast.value(call).index;
+            values.resize(values.size() - numArgs);
+            values.push_back(instr.dst);
+        };
+
+        void visitBoolLiteral(node_id node) { values.push_back(emitConstant(ast.value(node).b, node)); };
+        void visitCharLiteral(node_id node) { values.push_back(emitConstant(ast.value(node).c, node)); };
+        void visitIntLiteral(node_id node) { values.push_back(emitConstant(ast.value(node).i, node)); };
+        void visitDoubleLiteral(node_id node) {
+            IRInstr& instr = emit(IROp::CONST, IRType::F64, node);
+            instr.imm.d = ast.value(node).d;
+            values.push_back(instr.dst);
+        };
+        void visitStringLiteral(node_id node) {
+            IRInstr& instr = emit(IROp::STRING, IRType::I64, node);
+            instr.imm.i = ast.value(node).index;
+            values.push_back(instr.dst);
+        };
+        void visitNullLiteral(node_id node) { values.push_back(emitConstant(0, node)); };
+    private:
+        // a node waiting on the work stack & how far its lowering has got
+        struct Work {
+            node_id node;
+            uint32_t stage; // 0 before any of its operands are lowered
+        };
+
+        // lowers an expression & returns its value
+        vreg_t build(node_id expr) {
+            const size_t base = work.size();
+            lower(expr);
+            while (work.size() > base) {
+                const Work item = work.back();
+                work.pop_back();
+                stage = item.stage;
+                dispatch(item.node);
+            }
+            return popValue();
+        };
+
+        // queues a node, the last one queued is lowered first
+        void lower(node_id node) { work.push_back({node, 0}); };
+        void resume(node_id node, uint32_t nextStage) { work.push_back({node, nextStage}); };
+
+        vreg_t popValue() {
+            const vreg_t value = values.back();
+            values.pop_back();
+            return value;
+        };
+
+        // appends an instruction to the current block, defining a new vreg unless type is NONE
+        // the reference is only good until the next one is emitted
+        IRInstr& emit(IROp op, IRType type, node_id at) {
+            std::vector<IRInstr>& instrs = func.blocks[block].instrs;
+            instrs.emplace_back();
+            IRInstr& instr = instrs.back();
+            instr.op = op;
+            instr.type = type;
+            if (type != IRType::NONE) instr.dst = func.newVreg(type);
+            instr.offset = ast.err(at).offset;
+            return instr;
+        };
+
+        vreg_t emitValue(IROp op, IRType type, std::initializer_list<vreg_t> args, node_id at) {
+            IRInstr& instr = emit(op, type, at);
+            instr.args = args;
+            return instr.dst;
+        };
+
+        vreg_t emitConstant(long long val, node_id at) {
+            IRInstr& instr = emit(IROp::CONST, IRType::I64, at);
+            instr.imm.i = val;
+            return instr.dst;
+        };
+
+        vreg_t emitZero(TokenType type, node_id at) {
+            if (type != TYPE_DOUBLE) return emitConstant(0, at);
+            IRInstr& instr = emit(IROp::CONST, IRType::F64, at);
+            instr.imm.d = 0.0;
+            return instr.dst;
+        };
+
+        void emitReturn(vreg_t value, node_id at) {
+            emit(IROp::RET, IRType::NONE, at).args = {value};
+        };
+
+        void emitBranch(block_id target, node_id at) {
+            emit(IROp::BR, IRType::NONE, at).targets[0] = target;
+            func.blocks[target].preds.push_back(block);
+        };
+
+        void emitStore(slot_t slot, vreg_t value, node_id at) {
+            IRInstr& instr = emit(IROp::STORE_GLOBAL, IRType::NONE, at);
+            instr.args = {value};
+            instr.imm.i = slot & ~SLOT_GLOBAL_FLAG;
+        };
+
+        // converts a value as allowed by isTypeAssignable(), the same value if nothing changes
+        vreg_t convert(vreg_t value, TokenType from, TokenType to, node_id at) {
+            if (from == to) return value;
+            if (to == TYPE_DOUBLE) return emitValue(IROp::ITOF, IRType::F64, {value}, at);
+            if (to == TYPE_CHAR) return emitValue(IROp::SEXT8, IRType::I64, {value}, at); // chars are kept sign extended
+            return value; // char & bool are already valid ints
+        };
+
+        vreg_t read(node_id identifier) {
+            const slot_t slot = ast.value(identifier).var.slot;
+            if (!isSlotGlobal(slot)) return current[slot];
+            IRInstr& instr = emit(IROp::LOAD_GLOBAL, getIRType(ast.type(identifier)), identifier);
+            instr.imm.i = slot & ~SLOT_GLOBAL_FLAG;
+            return instr.dst;
+        };
+
+        void write(node_id identifier, vreg_t value, node_id at) {
+            const slot_t slot = ast.value(identifier).var.slot;
+            if (isSlotGlobal(slot)) emitStore(slot, value, at);
+            else writeLocal(slot, value);
+        };
+
+        void writeLocal(slot_t slot, vreg_t value) {
+            log.push_back({slot, current[slot]});
+            current[slot] = value;
+        };
+
+        // ++ & --, the operand is always an identifier
+        vreg_t buildIncrement(node_id expr, node_id operand) {
+            const TokenType type = ast.type(operand);
+            const bool isInc = ast.op(expr) == OP_INC;
+            const vreg_t old = read(operand);
+            vreg_t value;
+            if (type == TYPE_DOUBLE) {
+                IRInstr& one = emit(IROp::CONST, IRType::F64, expr);
+                one.imm.d = 1.0;
+                const vreg_t oneValue = one.dst;
+                value = emitValue(isInc ? IROp::FADD : IROp::FSUB, IRType::F64, {old, oneValue}, expr);
+            } else {
+                value = emitValue(isInc ? IROp::ADD : IROp::SUB, IRType::I64, {old, emitConstant(1, expr)}, expr);
+                if (type == TYPE_CHAR) value = emitValue(IROp::SEXT8, IRType::I64, {value}, expr); // wrap within the char
+            }
+            write(operand, value, expr);
+            return ast.isPostOp(expr) ? old : value;
+        };
+
+        // && and || only evaluate the right side if the left doesn't decide the result
+        //   left: cbr left, right, decided (swapped for ||)
+        //   right: ... br merge
+        //   decided: const 0 (1 for ||), br merge
+        //   merge: phis for the result & every local the right side wrote to
+        // stage 1 branches once the left is lowered, stage 2 merges once the right is
+        void buildLogical(node_id expr) {
+            const bool isAnd = ast.op(expr) == OP_BOOL_AND;
+            const node_id right = ast.child(expr, 1);
+            if (stage == 0) {
+                resume(expr, 1);
+                lower(ast.child(expr, 0));
+                return;
+            } else if (stage == 1) {
+                const vreg_t left = popValue();
+                const block_id rightBlock = func.newBlock(), decidedBlock = func.newBlock();
+                IRInstr& branch = emit(IROp::CBR, IRType::NONE, expr);
+                branch.args = {left};
+                branch.targets[0] = isAnd ? rightBlock : decidedBlock;
+                branch.targets[1] = isAnd ? decidedBlock : rightBlock;
+                func.blocks[rightBlock].preds.push_back(block);
+                func.blocks[decidedBlock].preds.push_back(block);
+
+                logicals.push_back({decidedBlock, log.size()});
+                block = rightBlock;
+                resume(expr, 2);
+                lower(right);
+                return;
+            }
+
+            const PendingLogical pending = logicals.back();
+            logicals.pop_back();
+            const block_id decidedBlock = pending.decidedBlock;
+            const size_t logStart = pending.logStart;
+            vreg_t rightValue = popValue();
+            if (ast.type(right) != TYPE_BOOL) // bools are always 0 or 1 already
+                rightValue = emitValue(IROp::NE, IRType::I64, {rightValue, emitConstant(0, expr)}, expr);
+            const block_id rightEnd = block;
+
+            block = decidedBlock;
+            const vreg_t decidedValue = emitConstant(isAnd ? 0 : 1, expr);
+
+            const block_id mergeBlock = func.newBlock();
+            block = rightEnd;
+            emitBranch(mergeBlock, expr);
+            block = decidedBlock;
+            emitBranch(mergeBlock, expr);
+
+            // undo the right side's writes, keeping what each local ended up as
+            block = mergeBlock;
+            const uint32_t stamp = ++numMerges;
+            std::vector<std::pair<slot_t, vreg_t>> written;
+            for (size_t i = log.size(); i-- > logStart;) {
+                const slot_t slot = log[i].first;
+                if (stamps[slot] != stamp) {
+                    stamps[slot] = stamp;
+                    written.push_back({slot, current[slot]});
+                }
+                current[slot] = log[i].second;
+            }
+            log.resize(logStart);
+
+            // the preds are {rightEnd, decidedBlock} in that order
+            const vreg_t result = emitPhi(IRType::I64, rightValue, decidedValue, expr);
+            for (const std::pair<slot_t, vreg_t>& write : written) {
+                const vreg_t before = current[write.first];
+                if (write.second == before) continue;
+                if (before == VREG_NONE) continue; // can't be read afterwards without a declaration
+                writeLocal(write.first, emitPhi(func.vregTypes[before], write.second, before, expr));
+            }
+            values.push_back(result);
+        };
+
+        vreg_t emitPhi(IRType type, vreg_t fromRight, vreg_t fromDecided, node_id at) {
+            return emitValue(IROp::PHI, type, {fromRight, fromDecided}, at);
+        };
+
+        IRFunction& func;
+        block_id block; // where instructions are emitted
+        std::vector<vreg_t> current; // value of each local slot
+        std::vector<std::pair<slot_t, vreg_t>> log; // {slot, value before} of every write
+        std::vector<uint32_t> stamps; // per slot, last merge that saw it written
+        uint32_t numMerges = 0;
+
+        // && / || whose right side is being lowered
+        struct PendingLogical {
+            block_id decidedBlock;
+            size_t logStart; // where the right side's writes start in log
+        };
+
+        std::vector<Work> work;
+        uint32_t stage = 0; // of the node being handled
+        std::vector<vreg_t> values; // lowered operands not yet used by their operator
+        std::vector<PendingLogical> logicals;
+};
+
+IRModule buildIR(const FlatAST& ast) {
+    IRModule module;
+    module.fileIndex = ast.err(ast.root()).fileIndex;
+    for (size_t i = 0; i < ast.numStrings(); i++) module.strings.push_back(ast.stringAt(i));
+
+    const node_id root = ast.root();
+    const symbol_t mainSymbol = SymbolTable::intern("main");
+    module.init.returnType = IRType::NONE;
+    IRBuilder globals(ast, module.init, 0);
+    for (size_t i = 0; i < ast.numChildren(root); i++) {
+        const node_id node = ast.child(root, i);
+        if (ast.tag(node) == ASTNodeType::FUNCTION) {
+            const FlatFunction& function = ast.function(node);
+            module.functions.emplace_back();
+            IRFunction& func = module.functions.back();
+            func.name = function.name;
+            func.index = ast.value(node).index;
+            func.returnType = getIRType(ast.op(node));
+            if (function.name == mainSymbol && function.params.count == 0) module.mainIndex = func.index;
+
+            IRBuilder builder(ast, func, function.numSlots);
+            builder.buildFunction(node);
+        } else if (ast.tag(node) == ASTNodeType::VARIABLE) {
+            const size_t index = ast.value(node).var.slot & ~SLOT_GLOBAL_FLAG;
+            if (module.globalTypes.size() <= index) module.globalTypes.resize(index + 1, IRType::I64);
+            module.globalTypes[index] = getIRType(ast.type(node));
+            globals.buildGlobal(node); // in source order
+        }
+    }
+    globals.finishGlobals();
+    return module;
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef __IR_BUILDER_HPP
+#define __IR_BUILDER_HPP
+
+#include "ir.hpp"
+#include "../ast/flat_ast.hpp"
+
+// lowers an AST that passed checkSemantics() to SSA form
+// locals become virtual registers (globals stay in memory), && / || become branches merging
+// in phis & every implicit conversion is made explicit
+// function bodies are straight-line code, so each one ends at its first return (falling off
+// the end returns 0)
+// strings in the module view into the AST's arena, so the AST must outlive it
+IRModule buildIR(const FlatAST&);
+
+#endif
\ No newline at end of file
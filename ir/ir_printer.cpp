@@ -0,0 +1,62 @@
+#include <ostream>
+#include <string>
+
+#include "ir_printer.hpp"
+#include "../symbols.hpp"
+
+static const char* getTypeName(IRType type) {
+    switch (type) {
+        case IRType::I64: return "i64";
+        case IRType::F64: return "f64";
+        default: return "void";
+    }
+}
+
+static void printInstr(std::ostream& out, const IRModule& module, const IRInstr& instr) {
+    out << "    ";
+    if (instr.dst != VREG_NONE) out << '%' << instr.dst << ':' << getTypeName(instr.type) << " = ";
+    out << getOpName(instr.op);
+
+    // immediates, then args
+    switch (instr.op) {
+        case IROp::PARAM: out << ' ' << instr.imm.i; break;
+        case IROp::CONST:
+            if (instr.type == IRType::F64) out << ' ' << instr.imm.d;
+            else out << ' ' << instr.imm.i;
+            break;
+        case IROp::STRING: out << " s" << instr.imm.i; break;
+        case IROp::LOAD_GLOBAL: case IROp::STORE_GLOBAL: out << " g" << instr.imm.i << (instr.args.empty() ? "" : ","); break;
+        case IROp::CALL: out << ' ' << SymbolTable::name(module.functions[instr.imm.i].name); break;
+        default: break;
+    }
+    for (size_t i = 0; i < instr.args.size(); i++)
+        out << (i == 0 ? " %" : ", %") << instr.args[i];
+
+    if (instr.op == IROp::BR) out << " b" << instr.targets[0];
+    else if (instr.op == IROp::CBR) out << ", b" << instr.targets[0] << ", b" << instr.targets[1];
+    if (instr.flags & IR_FLAG_TAIL) out << " ; tail";
+    out << '\n';
+}
+
+static void printFunction(std::ostream& out, const IRModule& module, const IRFunction& func, const char* name) {
+    out << "function " << name << '(';
+    for (size_t i = 0; i < func.paramTypes.size(); i++)
+        out << (i == 0 ? "" : ", ") << getTypeName(func.paramTypes[i]);
+    out << ") -> " << getTypeName(func.returnType) << '\n';
+
+    for (block_id b = 0; b < func.blocks.size(); b++) {
+        const IRBlock& block = func.blocks[b];
+        out << 'b' << b << ':';
+        for (size_t i = 0; i < block.preds.size(); i++)
+            out << (i == 0 ? " ; preds b" : ", b") << block.preds[i];
+        out << '\n';
+        for (const IRInstr& instr : block.instrs) printInstr(out, module, instr);
+    }
+    out << '\n';
+}
+
+void printIR(std::ostream& out, const IRModule& module) {
+    printFunction(out, module, module.init, "<globals>");
+    for (const IRFunction& func : module.functions)
+        printFunction(out, module, func, std::string(SymbolTable::name(func.name)).c_str());
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#ifndef __IR_PRINTER_HPP
+#define __IR_PRINTER_HPP
+
+#include <ostream>
+
+#include "ir.hpp"
+
+// writes a readable listing of the IR (for --dump-ir), one instruction per line as
+//   %2:i64 = add %0, %1
+// under a header per block listing its preds in phi order
+void printIR(std::ostream&, const IRModule&);
+
+#endif
\ No newline at end of file
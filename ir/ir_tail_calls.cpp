@@ -0,0 +1,154 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "ir_tail_calls.hpp"
+#include "../errors.hpp"
+#include "../symbols.hpp"
+
+// drops pred i of a block, the phis' args from it go with it
+static void removePred(IRBlock& block, size_t i) {
+    block.preds.erase(block.preds.begin() + i);
+    for (IRInstr& instr : block.instrs) {
+        if (instr.op != IROp::PHI) break;
+        instr.args.erase(instr.args.begin() + i);
+    }
+}
+
+// 1. copies blocks that only return (maybe a phi) into every pred jumping straight to them
+static void duplicateReturns(IRFunction& func) {
+    bool isChanged = true;
+    while (isChanged) {
+        isChanged = false;
+        for (block_id b = 0; b < func.blocks.size(); b++) {
+            IRBlock& block = func.blocks[b];
+            const IRInstr& ret = block.terminator();
+            if (ret.op != IROp::RET) continue;
+            size_t numPhis = 0;
+            while (block.instrs[numPhis].op == IROp::PHI) numPhis++;
+            if (numPhis != block.instrs.size() - 1) continue;
+
+            for (size_t i = block.preds.size(); i-- > 0;) {
+                IRBlock& pred = func.blocks[block.preds[i]];
+                if (pred.terminator().op != IROp::BR) continue; // CBRs only lead to blocks with a single pred
+
+                // the value returned when coming from this pred
+                IRInstr copy = ret;
+                for (size_t j = 0; j < numPhis; j++)
+                    if (!copy.args.empty() && copy.args[0] == block.instrs[j].dst) copy.args[0] = block.instrs[j].args[i];
+                pred.instrs.back() = copy;
+                removePred(block, i);
+                isChanged = true;
+            }
+        }
+    }
+    removeUnreachableBlocks(func);
+}
+
+// whether the last instructions of a block are a call & the return of its value
+static bool isTailCall(const IRBlock& block) {
+    const size_t size = block.instrs.size();
+    if (size < 2) return false;
+    const IRInstr& ret = block.instrs[size-1], & call = block.instrs[size-2];
+    return ret.op == IROp::RET && call.op == IROp::CALL && ret.args.size() == 1 && ret.args[0] == call.dst;
+}
+
+// 2. moves everything after the params into a loop header the self calls jump back to
+static void loopSelfCalls(IRFunction& func, const std::vector<block_id>& latches) {
+    const block_id header = func.newBlock();
+    IRBlock& entry = func.blocks[0];
+    size_t numParams = 0;
+    while (numParams < entry.instrs.size() && entry.instrs[numParams].op == IROp::PARAM) numParams++;
+    func.blocks[header].instrs.assign(entry.instrs.begin() + numParams, entry.instrs.end());
+    entry.instrs.resize(numParams);
+    entry.instrs.emplace_back();
+    entry.instrs.back().op = IROp::BR;
+    entry.instrs.back().targets[0] = header;
+    entry.instrs.back().offset = func.blocks[header].terminator().offset;
+    func.blocks[header].preds.push_back(0);
+
+    // whatever followed the entry follows the header now
+    const IRBlock& headerBlock = func.blocks[header];
+    for (size_t i = 0; i < headerBlock.numSuccessors(); i++)
+        for (block_id& pred : func.blocks[headerBlock.successor(i)].preds)
+            if (pred == 0) pred = header;
+
+    // each param is a phi of the value it came in with & the args of each self call
+    std::vector<vreg_t> phis(func.paramTypes.size());
+    for (size_t p = 0; p < func.paramTypes.size(); p++) phis[p] = func.newVreg(func.paramTypes[p]);
+    std::vector<vreg_t> renamed(func.numVregs());
+    for (vreg_t v = 0; v < renamed.size(); v++) renamed[v] = v;
+    for (size_t i = 0; i < numParams; i++) {
+        const IRInstr& param = func.blocks[0].instrs[i];
+        renamed[param.dst] = phis[param.imm.i];
+    }
+    for (block_id b = 1; b < func.blocks.size(); b++)
+        for (IRInstr& instr : func.blocks[b].instrs)
+            for (vreg_t& arg : instr.args) arg = renamed[arg];
+
+    std::vector<IRInstr> headerPhis(func.paramTypes.size());
+    for (size_t p = 0; p < func.paramTypes.size(); p++) {
+        headerPhis[p].op = IROp::PHI;
+        headerPhis[p].type = func.paramTypes[p];
+        headerPhis[p].dst = phis[p];
+        headerPhis[p].args.push_back(VREG_NONE);
+    }
+    for (size_t i = 0; i < numParams; i++) {
+        const IRInstr& param = func.blocks[0].instrs[i];
+        headerPhis[param.imm.i].args[0] = param.dst;
+        headerPhis[param.imm.i].offset = param.offset;
+    }
+
+    // unused params have no PARAM, their value can't be observed so anything of the type will do
+    for (size_t p = 0; p < func.paramTypes.size(); p++) {
+        if (headerPhis[p].args[0] != VREG_NONE) continue;
+        IRInstr param;
+        param.op = IROp::PARAM;
+        param.type = func.paramTypes[p];
+        param.dst = func.newVreg(param.type);
+        param.imm.i = (long long)p;
+        IRBlock& newEntry = func.blocks[0];
+        newEntry.instrs.insert(newEntry.instrs.end() - 1, param);
+        headerPhis[p].args[0] = param.dst;
+    }
+
+    for (block_id latch : latches) {
+        if (latch == 0) latch = header; // moved
+        IRBlock& block = func.blocks[latch];
+        const IRInstr call = block.instrs[block.instrs.size()-2];
+        for (size_t p = 0; p < headerPhis.size(); p++) headerPhis[p].args.push_back(call.args[p]);
+        block.instrs.resize(block.instrs.size()-2);
+        block.instrs.emplace_back();
+        block.instrs.back().op = IROp::BR;
+        block.instrs.back().targets[0] = header;
+        block.instrs.back().offset = call.offset;
+        func.blocks[header].preds.push_back(latch);
+    }
+    IRBlock& loopHeader = func.blocks[header];
+    loopHeader.instrs.insert(loopHeader.instrs.begin(), headerPhis.begin(), headerPhis.end());
+}
+
+static void reportTailCall(const IRModule& module, const IRInstr& call, const char* how) {
+    std::cout << "Tail call to " << SymbolTable::name(module.functions[call.imm.i].name) << " at "
+              << DTException::getLocation({call.offset, module.fileIndex}) << " compiled as " << how << '\n';
+}
+
+void optimizeTailCalls(IRModule& module, bool isReporting) {
+    for (IRFunction& func : module.functions) {
+        duplicateReturns(func);
+
+        std::vector<block_id> latches;
+        for (block_id b = 0; b < func.blocks.size(); b++) {
+            IRBlock& block = func.blocks[b];
+            if (!isTailCall(block)) continue;
+            IRInstr& call = block.instrs[block.instrs.size()-2];
+            if (call.imm.i == func.index) {
+                latches.push_back(b);
+                if (isReporting) reportTailCall(module, call, "a loop");
+            } else {
+                call.flags |= IR_FLAG_TAIL;
+            }
+        }
+        if (!latches.empty()) loopSelfCalls(func, latches);
+    }
+}
\ No newline at end of file
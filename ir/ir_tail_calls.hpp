@@ -0,0 +1,14 @@
+#ifndef __IR_TAIL_CALLS_HPP
+#define __IR_TAIL_CALLS_HPP
+
+#include "ir.hpp"
+
+// finds calls whose value is returned as is & makes them not need a frame of their own
+// 1. blocks holding nothing but phis & a return are copied into their preds, so the return
+//    right after a call on either side of && / || is found in the call's own block
+// 2. calls to the function itself become jumps back to its start, with the args flowing
+//    into phis that take the params' place (reported as loops if isReporting)
+// 3. the rest are flagged IR_FLAG_TAIL, the backend jumps to them if the frame allows it
+void optimizeTailCalls(IRModule&, bool isReporting);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ir_verifier.hpp"
+#include "../symbols.hpp"
+
+// type each arg of an instruction has to have, NONE if it doesn't take any
+static IRType getOperandType(IROp op) {
+    switch (op) {
+        case IROp::FADD: case IROp::FSUB: case IROp::FMUL: case IROp::FDIV: case IROp::FNEG:
+        case IROp::FEQ: case IROp::FNE: case IROp::FLT: case IROp::FLE: case IROp::FGT: case IROp::FGE:
+            return IRType::F64;
+        case IROp::PARAM: case IROp::CONST: case IROp::STRING: case IROp::LOAD_GLOBAL: case IROp::BR:
+            return IRType::NONE;
+        default:
+            return IRType::I64;
+    }
+}
+
+// # of args an instruction takes, -1 if it varies
+static int getNumOperands(IROp op) {
+    switch (op) {
+        case IROp::PARAM: case IROp::CONST: case IROp::STRING: case IROp::LOAD_GLOBAL: case IROp::BR:
+            return 0;
+        case IROp::STORE_GLOBAL: case IROp::NEG: case IROp::NOT: case IROp::FNEG:
+        case IROp::ITOF: case IROp::SEXT8: case IROp::CBR:
+            return 1;
+        case IROp::PHI: case IROp::CALL: case IROp::RET:
+            return -1;
+        default:
+            return 2;
+    }
+}
+
+// type of the value an instruction defines, returns NONE for ones that don't define any
+static IRType getResultType(const IRInstr& instr) {
+    switch (instr.op) {
+        case IROp::STORE_GLOBAL: case IROp::BR: case IROp::CBR: case IROp::RET:
+            return IRType::NONE;
+        case IROp::PARAM: case IROp::CONST: case IROp::LOAD_GLOBAL: case IROp::PHI: case IROp::CALL:
+            return instr.type; // any
+        case IROp::FADD: case IROp::FSUB: case IROp::FMUL: case IROp::FDIV: case IROp::FNEG: case IROp::ITOF:
+            return IRType::F64;
+        default:
+            return IRType::I64;
+    }
+}
+
+// preorder span [first, last] of each reachable block in the dominator tree, so a block
+// dominates another iff its span contains the other's first (the tree is walked w/ an explicit
+// stack, a chain of && / || makes it as deep as there are operators)
+static void getDominatorSpans(const std::vector<block_id>& idoms, std::vector<uint32_t>& first, std::vector<uint32_t>& last) {
+    std::vector<std::vector<block_id>> children(idoms.size());
+    for (block_id b = 1; b < idoms.size(); b++)
+        if (idoms[b] != UINT32_MAX) children[idoms[b]].push_back(b);
+
+    struct Frame {
+        block_id block;
+        size_t nextChild;
+    };
+    std::vector<Frame> dfs = {{0, 0}};
+    uint32_t counter = 0;
+    first.assign(idoms.size(), UINT32_MAX);
+    last.assign(idoms.size(), UINT32_MAX);
+    first[0] = counter++;
+    while (!dfs.empty()) {
+        Frame& frame = dfs.back();
+        const block_id b = frame.block;
+        if (frame.nextChild < children[b].size()) {
+            const block_id child = children[b][frame.nextChild++];
+            first[child] = counter++;
+            dfs.push_back({child, 0}); // invalidates frame
+            continue;
+        }
+        last[b] = counter - 1;
+        dfs.pop_back();
+    }
+}
+
+class IRVerifier {
+    public:
+        IRVerifier(const IRModule& module, const IRFunction& func) : module(module), func(func) {};
+
+        std::string verify() {
+            if (func.blocks.empty()) return fail("has no blocks");
+            if (!func.blocks[0].preds.empty()) return fail("has an entry block with preds");
+
+            std::string error;
+            if (!(error = verifyBlocks()).empty() || !(error = verifyEdges()).empty()) return error;
+            return verifyDefs();
+        };
+    private:
+        std::string fail(const std::string& what) const {
+            const std::string name = &func == &module.init ? "<globals>" : std::string(SymbolTable::name(func.name));
+            return "IR of " + name + ' ' + what;
+        };
+
+        std::string fail(block_id b, const std::string& what) const { return fail("b" + std::to_string(b) + ' ' + what); };
+
+        // shape of each block & its instructions
+        std::string verifyBlocks() const {
+            for (block_id b = 0; b < func.blocks.size(); b++) {
+                const IRBlock& block = func.blocks[b];
+                if (block.instrs.empty() || !isTerminator(block.terminator().op)) return fail(b, "doesn't end in a terminator");
+
+                bool isPastPhis = false;
+                for (size_t i = 0; i < block.instrs.size(); i++) {
+                    const IRInstr& instr = block.instrs[i];
+                    const char* name = getOpName(instr.op);
+                    if (isTerminator(instr.op) && i != block.instrs.size()-1) return fail(b, std::string("has ") + name + " before its end");
+                    if (instr.op == IROp::PHI) {
+                        if (isPastPhis) return fail(b, "has a phi after other instructions");
+                        if (instr.args.size() != block.preds.size()) return fail(b, "has a phi with an arg count that doesn't match its preds");
+                    } else {
+                        isPastPhis = true;
+                    }
+                    if (instr.op == IROp::PARAM && b != 0) return fail(b, "has a param outside the entry");
+
+                    const int numOperands = getNumOperands(instr.op);
+                    if (numOperands >= 0 && instr.args.size() != (size_t)numOperands) return fail(b, std::string("has ") + name + " with the wrong # of args");
+                    for (const vreg_t arg : instr.args)
+                        if (arg >= func.numVregs()) return fail(b, std::string("has ") + name + " using an undefined vreg");
+
+                    // what the instruction defines
+                    const IRType resultType = getResultType(instr);
+                    if ((resultType == IRType::NONE) != (instr.dst == VREG_NONE)) return fail(b, std::string("has ") + name + " with the wrong dst");
+                    if (resultType != IRType::NONE && (resultType != instr.type || instr.dst >= func.numVregs() || func.vregTypes[instr.dst] != instr.type))
+                        return fail(b, std::string("has ") + name + " defining the wrong type");
+
+                    // what it uses
+                    std::string error = verifyOperandTypes(b, instr);
+                    if (!error.empty()) return error;
+                }
+            }
+            return "";
+        };
+
+        std::string verifyOperandTypes(block_id b, const IRInstr& instr) const {
+            const std::string name = getOpName(instr.op);
+            switch (instr.op) {
+                case IROp::PHI:
+                    for (const vreg_t arg : instr.args)
+                        if (func.vregTypes[arg] != instr.type) return fail(b, "has a phi mixing types");
+                    return "";
+                case IROp::PARAM:
+                    if (instr.imm.i < 0 || (size_t)instr.imm.i >= func.paramTypes.size() || func.paramTypes[instr.imm.i] != instr.type)
+                        return fail(b, "has a param that doesn't match the function's");
+                    return "";
+                case IROp::CALL: {
+                    if (instr.imm.i < 0 || (size_t)instr.imm.i >= module.functions.size()) return fail(b, "calls a function that doesn't exist");
+                    const IRFunction& callee = module.functions[instr.imm.i];
+                    if (callee.returnType != instr.type || callee.paramTypes.size() != instr.args.size()) return fail(b, "has a call that doesn't match its callee");
+                    for (size_t i = 0; i < instr.args.size(); i++)
+                        if (func.vregTypes[instr.args[i]] != callee.paramTypes[i]) return fail(b, "has a call that doesn't match its callee");
+                    return "";
+                }
+                case IROp::LOAD_GLOBAL: case IROp::STORE_GLOBAL: {
+                    if (instr.imm.i < 0 || (size_t)instr.imm.i >= module.globalTypes.size()) return fail(b, "uses a global that doesn't exist");
+                    const IRType type = instr.op == IROp::LOAD_GLOBAL ? instr.type : func.vregTypes[instr.args[0]];
+                    if (type != module.globalTypes[instr.imm.i]) return fail(b, "has " + name + " of the wrong type");
+                    return "";
+                }
+                case IROp::STRING:
+                    if (instr.imm.i < 0 || (size_t)instr.imm.i >= module.strings.size()) return fail(b, "uses a string that doesn't exist");
+                    return "";
+                case IROp::RET:
+                    if (func.returnType == IRType::NONE ? !instr.args.empty() :
+                        instr.args.size() != 1 || func.vregTypes[instr.args[0]] != func.returnType)
+                        return fail(b, "returns the wrong type");
+                    return "";
+                default: {
+                    const IRType type = getOperandType(instr.op);
+                    for (const vreg_t arg : instr.args)
+                        if (func.vregTypes[arg] != type) return fail(b, "has " + name + " with an operand of the wrong type");
+                    return "";
+                }
+            }
+        };
+
+        // preds are exactly the blocks branching in, once per edge
+        std::string verifyEdges() const {
+            std::vector<std::vector<block_id>> preds(func.blocks.size());
+            for (block_id b = 0; b < func.blocks.size(); b++) {
+                const IRBlock& block = func.blocks[b];
+                for (size_t i = 0; i < block.numSuccessors(); i++) {
+                    const block_id target = block.successor(i);
+                    if (target >= func.blocks.size() || target == 0) return fail(b, "branches to a block that can't be a target");
+                    preds[target].push_back(b);
+                }
+                if (block.terminator().op == IROp::CBR && block.successor(0) == block.successor(1))
+                    return fail(b, "has a cbr with both targets the same");
+            }
+            for (block_id b = 0; b < func.blocks.size(); b++) {
+                std::vector<block_id> expected = func.blocks[b].preds;
+                std::sort(expected.begin(), expected.end());
+                std::sort(preds[b].begin(), preds[b].end());
+                if (expected != preds[b]) return fail(b, "has preds that don't match the branches to it");
+                if (preds[b].size() > 1)
+                    for (const block_id pred : preds[b])
+                        if (func.blocks[pred].terminator().op == IROp::CBR) return fail(pred, "has a critical edge out of it");
+            }
+            return "";
+        };
+
+        // single definitions that dominate their uses
+        std::string verifyDefs() {
+            const std::vector<block_id> idoms = getDominators(func);
+            std::vector<block_id> defBlocks(func.numVregs(), UINT32_MAX);
+            std::vector<uint32_t> defIndices(func.numVregs(), 0);
+            for (block_id b = 0; b < func.blocks.size(); b++) {
+                if (idoms[b] == UINT32_MAX) continue; // unreachable, never runs
+                const IRBlock& block = func.blocks[b];
+                for (size_t i = 0; i < block.instrs.size(); i++) {
+                    const vreg_t dst = block.instrs[i].dst;
+                    if (dst == VREG_NONE) continue;
+                    if (defBlocks[dst] != UINT32_MAX) return fail(b, "redefines %" + std::to_string(dst));
+                    defBlocks[dst] = b;
+                    defIndices[dst] = (uint32_t)i;
+                }
+            }
+
+            // def (in block, at index) comes before a use
+            std::vector<uint32_t> first, last;
+            getDominatorSpans(idoms, first, last);
+            auto dominates = [&](vreg_t v, block_id b, size_t i) {
+                const block_id defBlock = defBlocks[v];
+                if (defBlock == UINT32_MAX || idoms[b] == UINT32_MAX) return false;
+                if (defBlock == b) return defIndices[v] < i;
+                return first[defBlock] <= first[b] && first[b] <= last[defBlock];
+            };
+
+            for (block_id b = 0; b < func.blocks.size(); b++) {
+                if (idoms[b] == UINT32_MAX) continue;
+                const IRBlock& block = func.blocks[b];
+                for (size_t i = 0; i < block.instrs.size(); i++) {
+                    const IRInstr& instr = block.instrs[i];
+                    for (size_t j = 0; j < instr.args.size(); j++) {
+                        const vreg_t arg = instr.args[j];
+                        const bool isDominated = instr.op == IROp::PHI ?
+                            dominates(arg, block.preds[j], func.blocks[block.preds[j]].instrs.size()) :
+                            dominates(arg, b, i);
+                        if (!isDominated) return fail(b, "uses %" + std::to_string(arg) + " where it isn't always defined");
+                    }
+                }
+            }
+            return "";
+        };
+
+        const IRModule& module;
+        const IRFunction& func;
+};
+
+std::string verifyIR(const IRModule& module) {
+    for (const IRFunction& func : module.functions) {
+        const std::string error = IRVerifier(module, func).verify();
+        if (!error.empty()) return error;
+    }
+    if (module.mainIndex >= module.functions.size()) return "IR has no main function";
+    return IRVerifier(module, module.init).verify();
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef __IR_VERIFIER_HPP
+#define __IR_VERIFIER_HPP
+
+#include <string>
+
+#include "ir.hpp"
+
+// checks the invariants every pass over the IR relies on, returns what's wrong with the first
+// broken one found (empty if there's none)
+// 1. every block ends in its only terminator, phis come first & have one arg per pred
+// 2. preds match the edges of the terminators & no CBR target has another pred
+// 3. each vreg is defined once, by an instruction of its type, & that def dominates every use
+//    (a phi's arg is used at the end of the matching pred)
+// 4. operands & returned values have the types their instruction expects
+std::string verifyIR(const IRModule&);
+
+#endif
\ No newline at end of file
@@ -1,8 +1,17 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "lexer.hpp"
+#include "lexer_tables.hpp"
+#include "lexer_simd.hpp"
+#include "token_store.hpp"
+#include "thread_pool.hpp"
 #include "toolbox.hpp"
 #include "errors.hpp"
 
@@ -45,250 +54,193 @@ bool isTokenAssignOp(const TokenType type) {
            type == ASSIGN_BIT_NOT || type == ASSIGN_BIT_XOR;
 };
 
-void tokenize(const std::string& src, std::vector<Token>& tokens, const trace lineNum, const int fileIndex) {
-    // break src string into tokens
-    size_t len = src.size();
-    std::string buffer;
-    for (size_t i = 0; i < len; i++) {
-        buffer.clear();
-        const ErrInfo errInfo = {lineNum, i+1, fileIndex};
+// true if the token opens a group (ex. (, [, {)
+bool isTokenGroupOpen(const TokenType type) {
+    return type == LPAREN || type == LBRACKET || type == LBRACE;
+}
+
+// true if the token closes a group (ex. ), ], })
+bool isTokenGroupClose(const TokenType type) {
+    return type == RPAREN || type == RBRACKET || type == RBRACE;
+}
+
+// true for chars that can start an identifier or keyword
+static inline bool isIdentStart(const char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$';
+}
 
-        if (std::isspace(src[i])) { // whitespace
+Lexer::Lexer(std::string_view src, const int fileIndex, size_t start, SymbolBatch* pSymbols)
+    : src(src), pKernels(&getLexKernels()), fileIndex(fileIndex), pSymbols(pSymbols), i(start) {}
+
+// lexes the next token from src into token, returns false once src is exhausted
+// token text is a view into src, so src must outlive the tokens
+bool Lexer::next(Token& token) {
+    const LexKernels& kernels = *pKernels; // scalar or SIMD scanning loops
+    const size_t len = src.size();
+    const char* pSrc = src.data();
+
+    while (i < len) {
+        const size_t start = i;
+
+        if (std::isspace((unsigned char)src[i])) { // whitespace
+            i = kernels.skipSpace(pSrc, i, len);
             continue;
-        } else if ((src[i] >= '0' && src[i] <= '9') || src[i] == '.') { // int/double literals
-            TokenType tokenType = TokenType::LIT_INT;
-            buffer = src[i];
+        }
+
+        const ErrInfo errInfo = {(uint32_t)i, fileIndex};
+        token.err = errInfo;
+        token.symbol = SYMBOL_NONE;
+        if ((src[i] >= '0' && src[i] <= '9') || (src[i] == '.' && i+1 < len && src[i+1] >= '0' && src[i+1] <= '9')) {
+            // int/double literals, decoded here so the parser never re-reads the text
+            TokenType tokenType = src[i] == '.' ? TokenType::LIT_DOUBLE : TokenType::LIT_INT;
             while (++i < len && ((src[i] >= '0' && src[i] <= '9') || src[i] == '.')) {
                 if (src[i] == '.') tokenType = TokenType::LIT_DOUBLE;
-                buffer.push_back(src[i]);
-            }
-            if (i != len) i--;
-            tokens.push_back({tokenType, buffer, errInfo});
-            continue;
-        } else if (std::isalpha(src[i])) { // keywords
-            switch (src[i]) {
-                case 'b':
-                    if (src.find("bool", i) == i) {
-                        i += 3;
-                        tokens.push_back({TokenType::TYPE_BOOL, "bool", errInfo}); continue;
-                    }
-                    break; // not found
-                case 'c':
-                    if (src.find("char", i) == i) {
-                        i += 3;
-                        tokens.push_back({TokenType::TYPE_CHAR, "char", errInfo}); continue;
-                    }
-                    break; // not found
-                case 'd':
-                    if (src.find("double", i) == i) {
-                        i += 5;
-                        tokens.push_back({TokenType::TYPE_DOUBLE, "double", errInfo}); continue;
-                    }
-                    break; // not found
-                case 'e':
-                    if (src.find("elif", i) == i) {
-                        i += 3;
-                        tokens.push_back({TokenType::ELIF, "elif", errInfo}); continue;
-                    } else if (src.find("else", i) == i) {
-                        i += 3;
-                        tokens.push_back({TokenType::ELSE, "else", errInfo}); continue;
-                    }
-                    break; // not found
-                case 'f':
-                    if (src.find("for", i) == i) {
-                        i += 2;
-                        tokens.push_back({TokenType::FOR, "for", errInfo}); continue;
-                    } else if (src.find("false", i) == i) {
-                        i += 4;
-                        tokens.push_back({TokenType::LIT_BOOL, "false", errInfo}); continue;
-                    } 
-                    break; // not found
-                case 'i':
-                    if (src.find("if", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::IF, "if", errInfo}); continue;
-                    } else if (src.find("int", i) == i) {
-                        i += 2;
-                        tokens.push_back({TokenType::TYPE_INT, "int", errInfo}); continue;
-                    }
-                    break; // not found
-                case 'n':
-                    if (src.find("null", i) == i) {
-                        i += 3;
-                        tokens.push_back({TokenType::LIT_NULL, "null", errInfo}); continue;
-                    }
-                    break; // not found
-                case 'r':
-                    if (src.find("return", i) == i) {
-                        i += 5;
-                        tokens.push_back({TokenType::RETURN, "return", errInfo}); continue;
-                    } 
-                    break; // not found
-                case 's':
-                    if (src.find("string", i) == i) {
-                        i += 5;
-                        tokens.push_back({TokenType::TYPE_STR, "string", errInfo}); continue;
-                    } 
-                    break; // not found
-                case 't':
-                    if (src.find("true", i) == i) {
-                        i += 3;
-                        tokens.push_back({TokenType::LIT_BOOL, "true", errInfo}); continue;
-                    } 
-                    break; // not found
-                case 'w':
-                    if (src.find("while", i) == i) {
-                        i += 4;
-                        tokens.push_back({TokenType::WHILE, "while", errInfo}); continue;
-                    }
-                    break; // not found
             }
-        } else { // misc. characters & operators
-            switch (src[i]) {
-                case '"': // strings
-                    while (++i < len && src[i] != '"') {
-                        if (src[i] == '\\') i++;
-                        buffer.push_back(src[i]);
-                    }
-                    if (i == len) // unclosed string
-                        throw DTSyntaxException(errInfo, "\"");
-                    tokens.push_back({TokenType::LIT_STR, buffer, errInfo});
-                    continue;
-                case '\'': // characters
-                    if (i + 2 < len && src[i+2] == '\'') { // normal single-digit char
-                        tokens.push_back({TokenType::LIT_CHAR, src.substr(i+1, 1), errInfo});
-                        i += 2;
-                        continue;
-                    } else if (i + 3 < len && src[i+1] == '\\' && src[i+3] == '\'') { // escaped char
-                        tokens.push_back({TokenType::LIT_CHAR, escapeChar(src.substr(i+1, 2)) + "", errInfo});
-                        i += 3;
-                        continue;
-                    }
-                    // unclosed char
-                    throw DTSyntaxException(errInfo, src.substr(i, 1));
-                    break;
-                case ';': tokens.push_back({TokenType::SEMICOLON, ";", errInfo}); continue;
-                case '(': tokens.push_back({TokenType::LPAREN, "(", errInfo}); continue;
-                case ')': tokens.push_back({TokenType::RPAREN, ")", errInfo}); continue;
-                case '[': tokens.push_back({TokenType::LBRACKET, "[", errInfo}); continue;
-                case ']': tokens.push_back({TokenType::RBRACKET, "]", errInfo}); continue;
-                case '{': tokens.push_back({TokenType::LBRACE, "{", errInfo}); continue;
-                case '}': tokens.push_back({TokenType::RBRACE, "}", errInfo}); continue;
-                case '#': { // handle comments
-                    while (i < len && src[i] != '\n') i++;
-                    continue;
+            token.type = tokenType;
+            token.raw = src.substr(start, i - start);
+
+            std::from_chars_result result = tokenType == TokenType::LIT_INT
+                ? std::from_chars(pSrc + start, pSrc + i, token.value.i)
+                : std::from_chars(pSrc + start, pSrc + i, token.value.d);
+            if (result.ec != std::errc() || result.ptr != pSrc + i) // out of range or malformed (ex. 1.2.3)
+                throw DTSyntaxException(errInfo, token.raw);
+            return true;
+        } else if (isIdentStart(src[i])) { // keywords & identifiers
+            i = kernels.skipIdent(pSrc, i+1, len);
+            token.raw = src.substr(start, i - start);
+            token.type = lookupKeyword(token.raw);
+            if (token.type == TokenType::IDENTIFIER)
+                token.symbol = pSymbols != nullptr ? pSymbols->intern(token.raw) : SymbolTable::intern(token.raw);
+            else if (token.type == TokenType::LIT_BOOL)
+                token.value.b = token.raw == "true";
+            return true;
+        }
+
+        // misc. characters & operators
+        switch (src[i]) {
+            case '"': // strings, raw text is kept escaped & decoded by the parser
+                i = kernels.findStringEnd(pSrc, i+1, len);
+                while (i < len && src[i] == '\\') { // skip escaped chars & keep scanning
+                    i += (i+1 < len && src[i+1] != '\n') ? 2 : 1;
+                    i = kernels.findStringEnd(pSrc, i, len);
+                }
+                if (i == len || src[i] == '\n') // unclosed string
+                    throw DTSyntaxException(errInfo, "\"");
+                token.type = TokenType::LIT_STR;
+                token.raw = src.substr(start+1, i - start - 1);
+                i++;
+                return true;
+            case '\'': // characters, which can't hold a raw newline so every token stays on one line
+                if (i + 2 < len && src[i+2] == '\'' && src[i+1] != '\n') { // normal single-digit char
+                    token.type = TokenType::LIT_CHAR;
+                    token.raw = src.substr(i+1, 1);
+                    token.value.c = src[i+1];
+                    i += 3;
+                    return true;
+                } else if (i + 3 < len && src[i+1] == '\\' && src[i+2] != '\n' && src[i+3] == '\'') { // escaped char
+                    token.type = TokenType::LIT_CHAR;
+                    token.raw = src.substr(i+1, 2);
+                    token.value.c = escapeChar(token.raw);
+                    i += 4;
+                    return true;
                 }
-                case '.': tokens.push_back({TokenType::DOT, ".", errInfo}); continue;
-                case ',': tokens.push_back({TokenType::COMMA, ",", errInfo}); continue;
-                case '<':
-                    if (src.find("<<=", i) == i) {
-                        i += 2;
-                        tokens.push_back({TokenType::ASSIGN_LSHIFT, "<<=", errInfo}); continue;
-                    } else if (src.find("<<", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_LSHIFT, "<<", errInfo}); continue;
-                    } else if (src.find("<=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_LTE, "<=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_LT, "<", errInfo}); continue;
-                case '>':
-                    if (src.find(">>=", i) == i) {
-                        i += 2;
-                        tokens.push_back({TokenType::ASSIGN_RSHIFT, ">>=", errInfo}); continue;
-                    } else if (src.find(">>", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_RSHIFT, ">>", errInfo}); continue;
-                    } else if (src.find(">=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_GTE, ">=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_GT, ">", errInfo}); continue;
-                case '+':
-                    if (src.find("++", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_INC, "++", errInfo}); continue;
-                    } else if (src.find("+=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::ASSIGN_ADD, "+=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_ADD, "+", errInfo}); continue;
-                case '-':
-                    if (src.find("--", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_DEC, "--", errInfo}); continue;
-                    } else if (src.find("-=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::ASSIGN_SUB, "-=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_SUB, "-", errInfo}); continue;
-                case '*':
-                    if (src.find("*=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::ASSIGN_MUL, "*=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_MUL, "*", errInfo}); continue;
-                case '/':
-                    if (src.find("/=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::ASSIGN_DIV, "/=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_DIV, "/", errInfo}); continue;
-                case '%':
-                    if (src.find("%=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::ASSIGN_MOD, "%=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_MOD, "%", errInfo}); continue;
-                case '|':
-                    if (src.find("|=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::ASSIGN_BIT_OR, "|=", errInfo}); continue;
-                    } else if (src.find("||", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_BOOL_OR, "||", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_BIT_OR, "|", errInfo}); continue;
-                case '&':
-                    if (src.find("&=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::ASSIGN_BIT_AND, "&=", errInfo}); continue;
-                    } else if (src.find("&&", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_BOOL_AND, "&&", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_BIT_AND, "&", errInfo}); continue;
-                case '~':
-                    if (src.find("~=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::ASSIGN_BIT_NOT, "~=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_BIT_NOT, "~", errInfo}); continue;
-                case '^':
-                    if (src.find("^=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::ASSIGN_BIT_XOR, "^=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_BIT_XOR, "^", errInfo}); continue;
-                case '!':
-                    if (src.find("!=", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_NEQ, "!=", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::OP_BOOL_NOT, "!", errInfo}); continue;
-                case '=':
-                    if (src.find("==", i) == i) {
-                        i++;
-                        tokens.push_back({TokenType::OP_EQ, "==", errInfo}); continue;
-                    }
-                    tokens.push_back({TokenType::ASSIGN, "=", errInfo}); continue;
+                // unclosed char
+                throw DTSyntaxException(errInfo, src.substr(i, 1));
+            case '#': // handle comments, stop at the newline so it's still counted
+                i = kernels.findNewline(pSrc, i+1, len);
+                continue;
+            default: { // operators & punctuation, longest match wins (ex. <<= over <<)
+                TokenType tokenType;
+                const size_t opLen = matchOperator(src, i, tokenType);
+                if (opLen == 0) // unknown character
+                    throw DTSyntaxException(errInfo, src.substr(i, 1));
+                token.type = tokenType;
+                token.raw = src.substr(start, opLen);
+                i += opLen;
+                return true;
             }
         }
+    }
+    return false;
+}
 
-        // base case, handle as identifier
-        while (i < len && (std::isalnum(src[i]) || src[i] == '$' || src[i] == '_'))
-            buffer.push_back(src[i++]);
-        if (i != len) i--;
-        tokens.push_back({TokenType::IDENTIFIER, buffer, errInfo});
+// tokenizes all of src at once
+void tokenize(std::string_view src, TokenStore& tokens, const int fileIndex) {
+    tokens.reserve(src.size() / LEX_BYTES_PER_TOKEN + 1);
+
+    Lexer lexer(src, fileIndex);
+    Token token;
+    while (lexer.next(token))
+        tokens.push(token);
+}
+
+// one slice of a file being lexed in parallel
+struct LexChunk {
+    LexChunk(std::string_view src, const int fileIndex, size_t start, size_t end)
+        : start(start), end(end), tokens(src, fileIndex) {};
+
+    size_t start, end; // [start, end) in src, end is just past a newline (or the end of src)
+    TokenStore tokens;
+    SymbolBatch symbols;
+    std::exception_ptr pError; // first error in the chunk, lexing stops there
+
+    std::vector<symbol_t> globalIds; // local symbol id -> SymbolTable id
+    size_t tokenAt = 0, literalAt = 0; // where the chunk lands in the stitched TokenStore
+};
+
+// tokenizes src split into chunks across the pool, the result (including symbol ids & which
+// error gets reported) is exactly what the single-threaded tokenize gives for any thread count
+// chunks are split at newlines, which no token can span
+void tokenize(std::string_view src, TokenStore& tokens, const int fileIndex, ThreadPool& pool) {
+    const size_t len = src.size();
+    const size_t maxChunks = std::min(pool.size() * LEX_CHUNKS_PER_THREAD, len / LEX_MIN_CHUNK_SIZE);
+    if (pool.size() == 1 || maxChunks <= 1) {
+        tokenize(src, tokens, fileIndex);
+        return;
+    }
+
+    // 1. place chunk boundaries on the first newline past each even split
+    std::vector<LexChunk> chunks;
+    chunks.reserve(maxChunks);
+    size_t start = 0;
+    for (size_t c = 1; c <= maxChunks && start < len; c++) {
+        size_t end = len;
+        const size_t target = std::max(start, len / maxChunks * c);
+        const char* pNewline = c < maxChunks ? (const char*)std::memchr(src.data() + target, '\n', len - target) : nullptr;
+        if (pNewline != nullptr) end = pNewline - src.data() + 1;
+        chunks.emplace_back(src, fileIndex, start, end);
+        start = end;
+    }
+
+    // 2. lex every chunk into its own store with its own interner
+    pool.run(chunks.size(), [&](size_t c) {
+        LexChunk& chunk = chunks[c];
+        try {
+            chunk.tokens.reserve((chunk.end - chunk.start) / LEX_BYTES_PER_TOKEN + 1);
+            Lexer lexer(src.substr(0, chunk.end), fileIndex, chunk.start, &chunk.symbols);
+            Token token;
+            while (lexer.next(token))
+                chunk.tokens.push(token);
+        } catch (...) {
+            chunk.pError = std::current_exception();
+        }
+    });
+
+    // 3. in source order, report the first error & hand out global symbol ids
+    size_t numTokens = 0, numLiterals = 0;
+    for (LexChunk& chunk : chunks) {
+        if (chunk.pError) std::rethrow_exception(chunk.pError);
+        chunk.globalIds = chunk.symbols.commit();
+        chunk.tokenAt = numTokens;
+        chunk.literalAt = numLiterals;
+        numTokens += chunk.tokens.size();
+        numLiterals += chunk.tokens.numLiterals();
     }
+
+    // 4. stitch the chunks together
+    tokens.resize(numTokens, numLiterals);
+    pool.run(chunks.size(), [&](size_t c) {
+        const LexChunk& chunk = chunks[c];
+        tokens.splice(chunk.tokenAt, chunk.literalAt, chunk.tokens, chunk.globalIds);
+    });
 }
\ No newline at end of file
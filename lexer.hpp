@@ -1,10 +1,14 @@
 #ifndef __LEXER_HPP
 #define __LEXER_HPP
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
-enum TokenType {
+#include "symbols.hpp"
+
+enum TokenType : uint8_t {
     RETURN,
     SEMICOLON,
     IDENTIFIER,
@@ -43,19 +47,56 @@ enum TokenType {
 typedef unsigned long long trace;
 typedef const trace c_trace;
 
+// where a token came from, the line & column are only worked out if an error is reported
 struct ErrInfo {
-    trace line; // stack trace
-    trace col; // stack trace
+    uint32_t offset; // byte offset into the source file
     int fileIndex;
 };
 
+// literal values, decoded once by the lexer
+union TokenValue {
+    long long i; // LIT_INT
+    double d; // LIT_DOUBLE
+    char c; // LIT_CHAR
+    bool b; // LIT_BOOL
+};
+
 struct Token {
     TokenType type;
-    std::string raw;
+    std::string_view raw; // view into the SourceFile's buffer (w/o quotes for strings & chars)
     ErrInfo err;
+    symbol_t symbol; // interned name for IDENTIFIER tokens, SYMBOL_NONE otherwise
+    TokenValue value; // for literals
+};
+
+// rough average source bytes per token, used to pre-size the token vector
+#define LEX_BYTES_PER_TOKEN 4
+
+// files smaller than this are lexed on a single thread
+#define LEX_MIN_CHUNK_SIZE (1 << 18)
+#define LEX_CHUNKS_PER_THREAD 4 // extra chunks even out threads that hit denser code
+
+struct LexKernels; // lexer_simd.hpp
+
+// produces tokens one at a time from a source buffer
+// lexing can start at any line boundary, offsets stay relative to the start of src either way
+class Lexer {
+    public:
+        Lexer(std::string_view src, const int fileIndex, size_t start = 0, SymbolBatch* pSymbols = nullptr);
+        bool next(Token&);
+    private:
+        std::string_view src;
+        const LexKernels* pKernels;
+        int fileIndex;
+        SymbolBatch* pSymbols; // chunk-local interner, nullptr to intern straight into the SymbolTable
+
+        size_t i; // current offset in src
 };
 
-void tokenize(const std::string&, std::vector<Token>&, const trace, const int);
+class TokenStore; // token_store.hpp
+class ThreadPool; // thread_pool.hpp
+void tokenize(std::string_view, TokenStore&, const int);
+void tokenize(std::string_view, TokenStore&, const int, ThreadPool&);
 
 /********* token helper methods *********/
 
@@ -65,5 +106,7 @@ bool isTokenBinaryOp(const TokenType);
 bool isTokenLiteral(const TokenType);
 bool isTokenCompOp(const TokenType);
 bool isTokenAssignOp(const TokenType);
+bool isTokenGroupOpen(const TokenType);
+bool isTokenGroupClose(const TokenType);
 
 #endif
\ No newline at end of file
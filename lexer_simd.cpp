@@ -0,0 +1,204 @@
+#include <cstddef>
+
+#include "lexer_simd.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LEX_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+/************* SCALAR *************/
+
+static inline bool isSpaceChar(const char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r'); // matches std::isspace in the C locale
+}
+
+static inline bool isIdentChar(const char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$';
+}
+
+static size_t skipSpaceScalar(const char* src, size_t i, size_t len) {
+    while (i < len && isSpaceChar(src[i])) i++;
+    return i;
+}
+
+static size_t findNewlineScalar(const char* src, size_t i, size_t len) {
+    while (i < len && src[i] != '\n') i++;
+    return i;
+}
+
+static size_t skipIdentScalar(const char* src, size_t i, size_t len) {
+    while (i < len && isIdentChar(src[i])) i++;
+    return i;
+}
+
+static size_t findStringEndScalar(const char* src, size_t i, size_t len) {
+    while (i < len && src[i] != '"' && src[i] != '\\' && src[i] != '\n') i++;
+    return i;
+}
+
+static const LexKernels SCALAR_KERNELS = {
+    skipSpaceScalar, findNewlineScalar, skipIdentScalar, findStringEndScalar
+};
+
+#ifdef LEX_HAS_X86_SIMD
+
+/************* SSE2 *************/
+
+static inline unsigned int spaceMask16(__m128i v) {
+    // ' ' or '\t'..'\r', the range check is done unsigned via min
+    const __m128i offset = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+    const __m128i inRange = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('\r' - '\t')), offset);
+    return (unsigned int)_mm_movemask_epi8(_mm_or_si128(inRange, _mm_cmpeq_epi8(v, _mm_set1_epi8(' '))));
+}
+
+static inline unsigned int identMask16(__m128i v) {
+    const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20)); // fold A-Z onto a-z
+    const __m128i alphaOff = _mm_sub_epi8(lower, _mm_set1_epi8('a'));
+    const __m128i alpha = _mm_cmpeq_epi8(_mm_min_epu8(alphaOff, _mm_set1_epi8('z' - 'a')), alphaOff);
+    const __m128i digitOff = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+    const __m128i digit = _mm_cmpeq_epi8(_mm_min_epu8(digitOff, _mm_set1_epi8('9' - '0')), digitOff);
+    const __m128i misc = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_cmpeq_epi8(v, _mm_set1_epi8('$')));
+    return (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), misc));
+}
+
+static size_t skipSpaceSSE2(const char* src, size_t i, size_t len) {
+    for (; i + 16 <= len; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const unsigned int mask = spaceMask16(v);
+        if (mask != 0xFFFF) return i + __builtin_ctz(~mask);
+    }
+    return skipSpaceScalar(src, i, len);
+}
+
+static size_t findNewlineSSE2(const char* src, size_t i, size_t len) {
+    for (; i + 16 <= len; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    return findNewlineScalar(src, i, len);
+}
+
+static size_t skipIdentSSE2(const char* src, size_t i, size_t len) {
+    for (; i + 16 <= len; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const unsigned int mask = identMask16(v);
+        if (mask != 0xFFFF) return i + __builtin_ctz(~mask);
+    }
+    return skipIdentScalar(src, i, len);
+}
+
+static size_t findStringEndSSE2(const char* src, size_t i, size_t len) {
+    for (; i + 16 <= len; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                                                       _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                                          _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        const unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    return findStringEndScalar(src, i, len);
+}
+
+static const LexKernels SSE2_KERNELS = {
+    skipSpaceSSE2, findNewlineSSE2, skipIdentSSE2, findStringEndSSE2
+};
+
+/************* AVX2 *************/
+
+#define LEX_AVX2 __attribute__((target("avx2")))
+
+LEX_AVX2 static inline unsigned int spaceMask32(__m256i v) {
+    const __m256i offset = _mm256_sub_epi8(v, _mm256_set1_epi8('\t'));
+    const __m256i inRange = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8('\r' - '\t')), offset);
+    return (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(inRange, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '))));
+}
+
+LEX_AVX2 static inline unsigned int identMask32(__m256i v) {
+    const __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+    const __m256i alphaOff = _mm256_sub_epi8(lower, _mm256_set1_epi8('a'));
+    const __m256i alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alphaOff, _mm256_set1_epi8('z' - 'a')), alphaOff);
+    const __m256i digitOff = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+    const __m256i digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digitOff, _mm256_set1_epi8('9' - '0')), digitOff);
+    const __m256i misc = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('$')));
+    return (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), misc));
+}
+
+LEX_AVX2 static size_t skipSpaceAVX2(const char* src, size_t i, size_t len) {
+    for (; i + 32 <= len; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const unsigned int mask = spaceMask32(v);
+        if (mask != 0xFFFFFFFFu) return i + __builtin_ctz(~mask);
+    }
+    return skipSpaceSSE2(src, i, len);
+}
+
+LEX_AVX2 static size_t findNewlineAVX2(const char* src, size_t i, size_t len) {
+    for (; i + 32 <= len; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    return findNewlineSSE2(src, i, len);
+}
+
+LEX_AVX2 static size_t skipIdentAVX2(const char* src, size_t i, size_t len) {
+    for (; i + 32 <= len; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const unsigned int mask = identMask32(v);
+        if (mask != 0xFFFFFFFFu) return i + __builtin_ctz(~mask);
+    }
+    return skipIdentSSE2(src, i, len);
+}
+
+LEX_AVX2 static size_t findStringEndAVX2(const char* src, size_t i, size_t len) {
+    for (; i + 32 <= len; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                                                             _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                                             _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+        const unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    return findStringEndSSE2(src, i, len);
+}
+
+static const LexKernels AVX2_KERNELS = {
+    skipSpaceAVX2, findNewlineAVX2, skipIdentAVX2, findStringEndAVX2
+};
+
+#endif
+
+/************* DISPATCH *************/
+
+LexSIMDLevel detectLexSIMDLevel() {
+#ifdef LEX_HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return LexSIMDLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return LexSIMDLevel::SSE2;
+#endif
+    return LexSIMDLevel::SCALAR;
+}
+
+static LexSIMDLevel activeLevel = detectLexSIMDLevel();
+
+// forcing a level the CPU doesn't have falls back to the best one it does
+void setLexSIMDLevel(LexSIMDLevel level) {
+    const LexSIMDLevel supported = detectLexSIMDLevel();
+    activeLevel = (int)level > (int)supported ? supported : level;
+}
+
+LexSIMDLevel getLexSIMDLevel() {
+    return activeLevel;
+}
+
+const LexKernels& getLexKernels() {
+    switch (activeLevel) {
+#ifdef LEX_HAS_X86_SIMD
+        case LexSIMDLevel::AVX2: return AVX2_KERNELS;
+        case LexSIMDLevel::SSE2: return SSE2_KERNELS;
+#endif
+        default: return SCALAR_KERNELS;
+    }
+}
\ No newline at end of file
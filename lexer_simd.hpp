@@ -0,0 +1,37 @@
+#ifndef __LEXER_SIMD_HPP
+#define __LEXER_SIMD_HPP
+
+#include <cstddef>
+
+/**
+ * Character classification kernels for the lexer's hot loops.
+ * Each kernel scans forward from src[i] and returns the index of the first char that ends
+ * the run (or len), consuming 16 (SSE2) or 32 (AVX2) bytes per step where it can.
+ * The level is picked once at runtime from the host CPU, but can be forced (ex. to compare
+ * the vector paths against the scalar one).
+ */
+
+enum class LexSIMDLevel {
+    SCALAR, SSE2, AVX2
+};
+
+struct LexKernels {
+    // skips whitespace
+    size_t (*skipSpace)(const char* src, size_t i, size_t len);
+
+    // finds the next '\n' (the end of a # comment)
+    size_t (*findNewline)(const char* src, size_t i, size_t len);
+
+    // skips identifier chars [A-Za-z0-9_$]
+    size_t (*skipIdent)(const char* src, size_t i, size_t len);
+
+    // finds the next char that ends a run of plain string contents: '"', '\\' or '\n'
+    size_t (*findStringEnd)(const char* src, size_t i, size_t len);
+};
+
+LexSIMDLevel detectLexSIMDLevel();
+void setLexSIMDLevel(LexSIMDLevel);
+LexSIMDLevel getLexSIMDLevel();
+const LexKernels& getLexKernels();
+
+#endif
\ No newline at end of file
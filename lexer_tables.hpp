@@ -0,0 +1,178 @@
+#ifndef __LEXER_TABLES_HPP
+#define __LEXER_TABLES_HPP
+
+#include <cstdint>
+#include <string_view>
+
+#include "lexer.hpp"
+
+/**
+ * Lookup tables used by the lexer, all generated at compile time from the spellings below.
+ *
+ * Keywords are matched by a perfect hash over (first char, second char, last char, length)
+ * so each identifier costs one hash and at most one short compare.
+ * Operators & punctuation are matched by a DFA (really just a trie) whose transitions are
+ * indexed by a compressed character class, so at most 3 table steps are taken per operator.
+ */
+
+struct TokenSpelling {
+    std::string_view spelling;
+    TokenType type;
+};
+
+/************* KEYWORDS *************/
+
+constexpr TokenSpelling KEYWORDS[] = {
+    {"bool", TYPE_BOOL}, {"char", TYPE_CHAR}, {"double", TYPE_DOUBLE}, {"int", TYPE_INT}, {"string", TYPE_STR},
+    {"if", IF}, {"elif", ELIF}, {"else", ELSE}, {"for", FOR}, {"while", WHILE}, {"return", RETURN},
+    {"true", LIT_BOOL}, {"false", LIT_BOOL}, {"null", LIT_NULL}
+};
+constexpr size_t NUM_KEYWORDS = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+
+constexpr unsigned int KEYWORD_HASH_BITS = 5;
+constexpr size_t KEYWORD_TABLE_SIZE = 1 << KEYWORD_HASH_BITS;
+
+// packs the chars that distinguish every keyword (word must be non-empty)
+constexpr uint32_t keywordKey(std::string_view word) {
+    const size_t len = word.size();
+    return (uint32_t)(unsigned char)word[0] |
+           (uint32_t)(unsigned char)word[len > 1 ? 1 : 0] << 8 |
+           (uint32_t)(unsigned char)word[len-1] << 16 |
+           (uint32_t)(len & 0xFF) << 24;
+}
+
+constexpr uint32_t keywordHash(uint32_t key, uint32_t seed) {
+    return (key * seed) >> (32 - KEYWORD_HASH_BITS);
+}
+
+// finds a multiplier that maps every keyword to its own slot
+constexpr uint32_t findKeywordSeed() {
+    for (uint32_t seed = 1; seed < 100000; seed += 2) {
+        bool used[KEYWORD_TABLE_SIZE] = {};
+        bool isPerfect = true;
+        for (size_t i = 0; i < NUM_KEYWORDS && isPerfect; i++) {
+            const uint32_t slot = keywordHash(keywordKey(KEYWORDS[i].spelling), seed);
+            isPerfect = !used[slot];
+            used[slot] = true;
+        }
+        if (isPerfect) return seed;
+    }
+    return 0;
+}
+
+constexpr uint32_t KEYWORD_SEED = findKeywordSeed();
+static_assert(KEYWORD_SEED != 0, "no perfect hash found for the keyword table");
+
+struct KeywordTable {
+    TokenSpelling slots[KEYWORD_TABLE_SIZE];
+};
+
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table = {};
+    for (size_t i = 0; i < KEYWORD_TABLE_SIZE; i++)
+        table.slots[i] = {"", IDENTIFIER};
+    for (size_t i = 0; i < NUM_KEYWORDS; i++)
+        table.slots[keywordHash(keywordKey(KEYWORDS[i].spelling), KEYWORD_SEED)] = KEYWORDS[i];
+    return table;
+}
+
+constexpr KeywordTable KEYWORD_TABLE = buildKeywordTable();
+
+// returns the keyword's token type, or IDENTIFIER if word isn't a keyword
+constexpr TokenType lookupKeyword(std::string_view word) {
+    const TokenSpelling& slot = KEYWORD_TABLE.slots[keywordHash(keywordKey(word), KEYWORD_SEED)];
+    return slot.spelling == word ? slot.type : IDENTIFIER;
+}
+
+/************* OPERATORS & PUNCTUATION *************/
+
+constexpr TokenSpelling OPERATORS[] = {
+    {";", SEMICOLON}, {".", DOT}, {",", COMMA},
+    {"(", LPAREN}, {")", RPAREN}, {"[", LBRACKET}, {"]", RBRACKET}, {"{", LBRACE}, {"}", RBRACE},
+    {"<", OP_LT}, {"<=", OP_LTE}, {">", OP_GT}, {">=", OP_GTE}, {"<<", OP_LSHIFT}, {">>", OP_RSHIFT},
+    {"++", OP_INC}, {"--", OP_DEC}, {"+", OP_ADD}, {"-", OP_SUB}, {"*", OP_MUL}, {"/", OP_DIV}, {"%", OP_MOD},
+    {"|", OP_BIT_OR}, {"&", OP_BIT_AND}, {"~", OP_BIT_NOT}, {"^", OP_BIT_XOR},
+    {"||", OP_BOOL_OR}, {"&&", OP_BOOL_AND}, {"!", OP_BOOL_NOT}, {"==", OP_EQ}, {"!=", OP_NEQ},
+    {"=", ASSIGN}, {"+=", ASSIGN_ADD}, {"-=", ASSIGN_SUB}, {"*=", ASSIGN_MUL}, {"/=", ASSIGN_DIV}, {"%=", ASSIGN_MOD},
+    {"<<=", ASSIGN_LSHIFT}, {">>=", ASSIGN_RSHIFT},
+    {"|=", ASSIGN_BIT_OR}, {"&=", ASSIGN_BIT_AND}, {"~=", ASSIGN_BIT_NOT}, {"^=", ASSIGN_BIT_XOR}
+};
+constexpr size_t NUM_OPERATORS = sizeof(OPERATORS) / sizeof(OPERATORS[0]);
+
+constexpr size_t OP_DFA_MAX_STATES = 64;
+constexpr size_t OP_DFA_MAX_CLASSES = 32;
+
+struct OperatorDFA {
+    uint8_t charClass[256]; // 0 for chars that can't appear in an operator
+    uint8_t next[OP_DFA_MAX_STATES][OP_DFA_MAX_CLASSES]; // 0 is the start state, so also "no transition"
+    int16_t accept[OP_DFA_MAX_STATES]; // token type accepted in each state, -1 if none
+    size_t numStates;
+    size_t numClasses;
+};
+
+constexpr OperatorDFA buildOperatorDFA() {
+    OperatorDFA dfa = {};
+    dfa.numStates = 1;
+    dfa.numClasses = 1;
+    for (size_t i = 0; i < OP_DFA_MAX_STATES; i++)
+        dfa.accept[i] = -1;
+
+    for (size_t i = 0; i < NUM_OPERATORS; i++) {
+        size_t state = 0;
+        for (const char c : OPERATORS[i].spelling) {
+            uint8_t& cls = dfa.charClass[(unsigned char)c];
+            if (cls == 0) cls = (uint8_t)dfa.numClasses++;
+
+            uint8_t& nextState = dfa.next[state][cls];
+            if (nextState == 0) nextState = (uint8_t)dfa.numStates++;
+            state = nextState;
+        }
+        dfa.accept[state] = (int16_t)OPERATORS[i].type;
+    }
+    return dfa;
+}
+
+constexpr OperatorDFA OPERATOR_DFA = buildOperatorDFA();
+static_assert(OPERATOR_DFA.numStates <= OP_DFA_MAX_STATES, "operator DFA has too many states");
+static_assert(OPERATOR_DFA.numClasses <= OP_DFA_MAX_CLASSES, "operator DFA has too many char classes");
+
+// finds the longest operator starting at src[i], returns its length (0 if none)
+constexpr size_t matchOperator(std::string_view src, size_t i, TokenType& type) {
+    size_t state = 0, matched = 0;
+    for (size_t j = i; j < src.size(); j++) {
+        const uint8_t cls = OPERATOR_DFA.charClass[(unsigned char)src[j]];
+        if (cls == 0 || (state = OPERATOR_DFA.next[state][cls]) == 0) break;
+        if (OPERATOR_DFA.accept[state] != -1) {
+            type = (TokenType)OPERATOR_DFA.accept[state];
+            matched = j - i + 1;
+        }
+    }
+    return matched;
+}
+
+/************* FIXED SPELLINGS *************/
+
+constexpr size_t NUM_TOKEN_TYPES = (size_t)ASSIGN_BIT_XOR + 1; // ASSIGN_BIT_XOR is the last TokenType
+
+// length of every token type that is always spelled the same way (0 for the rest)
+// lets packed token storage skip the length of keywords & operators
+struct FixedLengthTable {
+    uint8_t lengths[NUM_TOKEN_TYPES];
+};
+
+constexpr FixedLengthTable buildFixedLengthTable() {
+    FixedLengthTable table = {};
+    for (size_t i = 0; i < NUM_KEYWORDS; i++)
+        if (KEYWORDS[i].type != LIT_BOOL) // true/false share a type
+            table.lengths[KEYWORDS[i].type] = (uint8_t)KEYWORDS[i].spelling.size();
+    for (size_t i = 0; i < NUM_OPERATORS; i++)
+        table.lengths[OPERATORS[i].type] = (uint8_t)OPERATORS[i].spelling.size();
+    return table;
+}
+
+constexpr FixedLengthTable FIXED_LENGTH_TABLE = buildFixedLengthTable();
+
+static_assert(lookupKeyword("while") == WHILE && lookupKeyword("whale") == IDENTIFIER, "keyword table is broken");
+static_assert(lookupKeyword("iffy") == IDENTIFIER && lookupKeyword("integer") == IDENTIFIER, "keyword table is broken");
+
+#endif
\ No newline at end of file
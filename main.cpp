@@ -1,3 +1,5 @@
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -7,29 +9,73 @@
 #include "errors.hpp"
 
 int main(int argc, char* argv[]) {
-    // 1. extract paths from args
-    if (argc != 4) {
-        std::cerr << "Invalid usage: target -o output\n";
-        exit(EXIT_FAILURE);
+    // 1. extract paths & flags from args
+    std::string inPath, outPath;
+    CompileOptions options;
+    bool isUsingNASM = false; // write assembly & hand it to nasm & ld instead of writing the ELF directly
+    bool isObjectOnly = false; // stop at the object file
+    for (int i = 1; i < argc; i++) {
+        const std::string arg( argv[i] );
+        if (arg == "-o" && i+1 < argc) {
+            outPath = argv[++i];
+        } else if (arg == "-c") {
+            isObjectOnly = true;
+        } else if (arg == "-j" && i+1 < argc) {
+            options.numThreads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg.size() == 3 && arg[0] == '-' && arg[1] == 'O' && arg[2] >= '0' && arg[2] <= '9') {
+            options.optLevel = arg[2] - '0';
+        } else if (arg == "--stream") {
+            options.isStreaming = true;
+        } else if (arg == "--report-tail-calls") {
+            options.isReportingTailCalls = true;
+        } else if (arg == "--dump-ir") {
+            options.isDumpingIR = true;
+        } else if (arg == "--report-spills") {
+            options.isReportingSpills = true;
+        } else if (arg == "--report-peephole") {
+            options.isReportingPeephole = true;
+        } else if (arg == "--nasm") {
+            isUsingNASM = true;
+        } else if (arg[0] != '-' && inPath.empty()) {
+            inPath = arg;
+        } else {
+            inPath.clear(); // invalid arg
+            break;
+        }
     }
 
-    std::string inPath( argv[1] );
-    std::string outPath( argv[3] );
+    if (inPath.empty() || outPath.empty()) {
+        std::cerr << "Invalid usage: target -o output [-c] [-j threads] [-O<level>] [--stream] [--report-tail-calls] [--dump-ir] [--report-spills] [--report-peephole] [--nasm]\n";
+        exit(EXIT_FAILURE);
+    }
 
-    // 2. compile source files
+    // 2. compile source files, straight to the object file or executable unless NASM is assembling
+    // whatever an earlier run left at the paths this one writes goes first, so a failed compile
+    // can't leave a stale executable behind
     const std::string asmPath = outPath + ".asm";
     const std::string objPath = outPath + ".o";
+    if (isUsingNASM) options.outputFormat = OutputFormat::ASM;
+    else if (isObjectOnly) options.outputFormat = OutputFormat::OBJECT;
+    const std::string compiledPath = isUsingNASM ? asmPath : isObjectOnly ? objPath : outPath;
+    std::remove(compiledPath.c_str());
+    if (isUsingNASM) {
+        std::remove(objPath.c_str());
+        if (!isObjectOnly) std::remove(outPath.c_str());
+    }
 
     try {
-        compileSrc(inPath, asmPath);
+        compileSrc(inPath, compiledPath, options);
     } catch (DTException& e) {
-        std::cout << e.what() << '\n';
+        std::cerr << e.what() << '\n';
+        std::remove(compiledPath.c_str()); // the assembly file is created before compiling starts
+        return EXIT_FAILURE;
     }
+    if (!isUsingNASM) return EXIT_SUCCESS;
 
     // 3. invoke NASM to assemble
-    std::system(("nasm -f elf64 " + asmPath).c_str());
+    if (std::system(("nasm -f elf64 " + asmPath).c_str()) != 0) return EXIT_FAILURE;
 
     // 4. invoke GNU linker
-    std::system(("ld " + objPath + " -o " + outPath).c_str());
-    return 0;
+    if (!isObjectOnly && std::system(("ld " + objPath + " -o " + outPath).c_str()) != 0) return EXIT_FAILURE;
+    return EXIT_SUCCESS;
 }
\ No newline at end of file
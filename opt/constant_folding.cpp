@@ -0,0 +1,149 @@
+#include <cstdint>
+
+#include "constant_folding.hpp"
+#include "../ast/ast_nodes.hpp"
+#include "../ast/ast_visitor.hpp"
+
+bool getConstant(const ASTNode* pNode, Constant& out) {
+    switch (pNode->nodeType()) {
+        case ASTNodeType::LIT_INT: out = {TYPE_INT, static_cast<const ASTIntLiteral*>(pNode)->val, 0}; return true;
+        case ASTNodeType::LIT_CHAR: out = {TYPE_CHAR, (signed char)static_cast<const ASTCharLiteral*>(pNode)->val, 0}; return true;
+        case ASTNodeType::LIT_BOOL: out = {TYPE_BOOL, static_cast<const ASTBoolLiteral*>(pNode)->val, 0}; return true;
+        case ASTNodeType::LIT_DOUBLE: out = {TYPE_DOUBLE, 0, static_cast<const ASTDoubleLiteral*>(pNode)->val}; return true;
+        default: return false;
+    }
+}
+
+ASTNode* makeLiteral(TokenType type, const Constant& val, const ASTNode& at, ASTArena& arena) {
+    switch (type) {
+        case TYPE_DOUBLE:
+            return arena.make<ASTDoubleLiteral>(val.asDouble(), Token{LIT_DOUBLE, at.raw, at.err, SYMBOL_NONE, {}}, arena);
+        case TYPE_CHAR:
+            return arena.make<ASTCharLiteral>((char)val.i, Token{LIT_CHAR, at.raw, at.err, SYMBOL_NONE, {}}, arena);
+        case TYPE_BOOL:
+            return arena.make<ASTBoolLiteral>(val.i != 0, Token{LIT_BOOL, at.raw, at.err, SYMBOL_NONE, {}}, arena);
+        default:
+            return arena.make<ASTIntLiteral>(val.i, Token{LIT_INT, at.raw, at.err, SYMBOL_NONE, {}}, arena);
+    }
+}
+
+// int arithmetic is done unsigned so it wraps like the hardware instead of overflowing
+static inline long long wrapAdd(long long a, long long b) { return (long long)((uint64_t)a + (uint64_t)b); }
+static inline long long wrapSub(long long a, long long b) { return (long long)((uint64_t)a - (uint64_t)b); }
+static inline long long wrapMul(long long a, long long b) { return (long long)((uint64_t)a * (uint64_t)b); }
+
+// each handler returns the replacement for its node, whose children are already folded
+// (through dispatchPostorder(), or by the caller of foldNode())
+class ConstantFolder : public ASTVisitor<ConstantFolder, ASTNode*> {
+    public:
+        ConstantFolder(ASTArena& arena) : arena(arena) {};
+
+        ASTNode* visitNode(ASTNode& node) {
+            adoptChildren(node);
+            return &node;
+        };
+
+        ASTNode* visitUnaryExpr(ASTUnaryExpr& expr) {
+            adoptChildren(expr);
+            Constant val;
+            if (!getConstant(expr.at(0), val)) return &expr;
+
+            switch (expr.opType()) {
+                case OP_ADD:
+                    return val.type == TYPE_DOUBLE ? makeDouble(expr, val.d) : makeInt(expr, val.i);
+                case OP_SUB:
+                    return val.type == TYPE_DOUBLE ? makeDouble(expr, -val.d) : makeInt(expr, wrapSub(0, val.i));
+                case OP_BOOL_NOT: return makeBool(expr, val.i == 0);
+                case OP_BIT_NOT: return makeInt(expr, ~val.i);
+                default: return &expr; // ++ & -- have an identifier operand
+            }
+        };
+
+        ASTNode* visitBinExpr(ASTBinExpr& expr) {
+            adoptChildren(expr);
+            const TokenType op = expr.opType();
+            if (isTokenAssignOp(op)) return &expr;
+
+            Constant left, right;
+            const bool isLeftConstant = getConstant(expr.at(0), left);
+
+            // a constant left side can decide && & || alone, the right side is never evaluated then
+            if (isLeftConstant && ((op == OP_BOOL_AND && left.i == 0) || (op == OP_BOOL_OR && left.i != 0)))
+                return makeBool(expr, op == OP_BOOL_OR);
+            if (!isLeftConstant || !getConstant(expr.at(1), right)) return &expr;
+
+            if (left.type == TYPE_DOUBLE || right.type == TYPE_DOUBLE)
+                return foldDouble(expr, left.asDouble(), right.asDouble());
+            return foldInt(expr, left.i, right.i);
+        };
+    private:
+        // puts the folded children in place
+        void adoptChildren(ASTNode& node) {
+            if (pChildResults == nullptr) return; // foldNode()
+            for (size_t i = 0; i < node.size(); i++)
+                if (pChildResults[i] != node.at(i)) node.setChild(i, pChildResults[i]);
+        };
+
+        ASTNode* foldInt(ASTBinExpr& expr, long long a, long long b) {
+            switch (expr.opType()) {
+                case OP_ADD: return makeInt(expr, wrapAdd(a, b));
+                case OP_SUB: return makeInt(expr, wrapSub(a, b));
+                case OP_MUL: return makeInt(expr, wrapMul(a, b));
+                case OP_DIV: case OP_MOD:
+                    if (b == 0 || (a == INT64_MIN && b == -1)) return &expr; // idiv faults, keep it
+                    return makeInt(expr, expr.opType() == OP_DIV ? a / b : a % b);
+                case OP_LSHIFT: return makeInt(expr, (long long)((uint64_t)a << (b & 63))); // shl masks the count
+                case OP_RSHIFT: return makeInt(expr, a >> (b & 63)); // sar
+                case OP_BIT_AND: return makeInt(expr, a & b);
+                case OP_BIT_OR: return makeInt(expr, a | b);
+                case OP_BIT_XOR: return makeInt(expr, a ^ b);
+                case OP_LT: return makeBool(expr, a < b);
+                case OP_LTE: return makeBool(expr, a <= b);
+                case OP_GT: return makeBool(expr, a > b);
+                case OP_GTE: return makeBool(expr, a >= b);
+                case OP_EQ: return makeBool(expr, a == b);
+                case OP_NEQ: return makeBool(expr, a != b);
+                case OP_BOOL_AND: return makeBool(expr, a != 0 && b != 0);
+                case OP_BOOL_OR: return makeBool(expr, a != 0 || b != 0);
+                default: return &expr;
+            }
+        };
+
+        // doubles fold with the host's IEEE arithmetic, which is what the SSE instructions do
+        ASTNode* foldDouble(ASTBinExpr& expr, double a, double b) {
+            switch (expr.opType()) {
+                case OP_ADD: return makeDouble(expr, a + b);
+                case OP_SUB: return makeDouble(expr, a - b);
+                case OP_MUL: return makeDouble(expr, a * b);
+                case OP_DIV: return makeDouble(expr, a / b);
+                case OP_LT: return makeBool(expr, a < b);
+                case OP_LTE: return makeBool(expr, a <= b);
+                case OP_GT: return makeBool(expr, a > b);
+                case OP_GTE: return makeBool(expr, a >= b);
+                case OP_EQ: return makeBool(expr, a == b);
+                case OP_NEQ: return makeBool(expr, a != b);
+                default: return &expr;
+            }
+        };
+
+        ASTNode* makeInt(const ASTNode& node, long long val) { return makeLiteral(TYPE_INT, {TYPE_INT, val, 0}, node, arena); };
+        ASTNode* makeDouble(const ASTNode& node, double val) { return makeLiteral(TYPE_DOUBLE, {TYPE_DOUBLE, 0, val}, node, arena); };
+        ASTNode* makeBool(const ASTNode& node, bool val) { return makeLiteral(TYPE_BOOL, {TYPE_BOOL, val, 0}, node, arena); };
+
+        ASTArena& arena;
+};
+
+void foldConstants(AST& ast) {
+    ConstantFolder folder(ast.arena);
+    folder.dispatchPostorder(*ast.pRoot);
+}
+
+ASTNode* foldConstants(ASTNode& node, ASTArena& arena) {
+    ConstantFolder folder(arena);
+    return folder.dispatchPostorder(node);
+}
+
+ASTNode* foldNode(ASTNode& node, ASTArena& arena) {
+    ConstantFolder folder(arena);
+    return folder.dispatch(node);
+}
\ No newline at end of file
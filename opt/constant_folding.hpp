@@ -0,0 +1,36 @@
+#ifndef __CONSTANT_FOLDING_HPP
+#define __CONSTANT_FOLDING_HPP
+
+#include "../lexer.hpp"
+#include "../ast/ast.hpp"
+#include "../ast/ast_nodes.hpp"
+
+// value of a foldable literal
+struct Constant {
+    TokenType type; // TYPE_INT, TYPE_CHAR, TYPE_BOOL or TYPE_DOUBLE
+    long long i; // ints, chars & bools
+    double d;
+
+    double asDouble() const { return type == TYPE_DOUBLE ? d : (double)i; };
+};
+
+// false if the node isn't a foldable literal
+bool getConstant(const ASTNode*, Constant&);
+
+// the constant converted to type (as allowed by isTypeAssignable), then as a literal of that type
+// the literal takes over at's source location for errors
+ASTNode* makeLiteral(TokenType type, const Constant&, const ASTNode& at, ASTArena&);
+
+// replaces unary & binary expressions over literals with the literal they evaluate to
+// runs after checkSemantics(), folded values follow x86-64 semantics exactly (wrapping 64 bit
+// ints, truncating division, masked shift counts, IEEE doubles), anything that would trap at
+// runtime (division by 0, INT64_MIN / -1) is left for the program to do
+void foldConstants(AST&);
+
+// folds the subtree at node, returns what replaces it (node itself if it isn't a constant)
+ASTNode* foldConstants(ASTNode& node, ASTArena&);
+
+// folds node alone, for passes that fold as they go, its children must already be folded
+ASTNode* foldNode(ASTNode& node, ASTArena&);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include <unordered_set>
+#include <vector>
+
+#include "dead_code.hpp"
+#include "../ast/ast_nodes.hpp"
+#include "../ast/ast_visitor.hpp"
+
+// adds every function a subtree calls to the worklist, through dispatchSubtree()
+class CallCollector : public ConstASTVisitor<CallCollector> {
+    public:
+        CallCollector(std::vector<const ASTFunction*>& worklist) : worklist(worklist) {};
+
+        void visitCall(const ASTCall& call) { worklist.push_back(call.pFunction); };
+    private:
+        std::vector<const ASTFunction*>& worklist;
+};
+
+// drops the statements after the first return
+static void truncateAfterReturn(ASTFunction& func) {
+    for (size_t i = 0; i < func.size(); i++) {
+        if (func.at(i)->nodeType() == ASTNodeType::RETURN) {
+            while (func.size() > i + 1) func.pop();
+            return;
+        }
+    }
+}
+
+void eliminateDeadCode(AST& ast) {
+    ASTNode& root = *ast.pRoot;
+    const symbol_t mainSymbol = SymbolTable::intern("main");
+
+    // 1. unreachable statements go first so their calls don't count
+    // 2. roots are main & anything global initializers call, which run before it
+    std::vector<const ASTFunction*> worklist;
+    CallCollector collector(worklist);
+    for (size_t i = 0; i < root.size(); i++) {
+        ASTNode* pNode = root.at(i);
+        if (pNode->nodeType() == ASTNodeType::FUNCTION) {
+            ASTFunction& func = *static_cast<ASTFunction*>(pNode);
+            truncateAfterReturn(func);
+            if (func.getName() == mainSymbol && func.getNumParams() == 0) worklist.push_back(&func);
+        } else {
+            collector.dispatchSubtree(*pNode);
+        }
+    }
+
+    // 3. walk the call graph
+    std::unordered_set<const ASTFunction*> reachable;
+    while (!worklist.empty()) {
+        const ASTFunction* pFunc = worklist.back();
+        worklist.pop_back();
+        if (reachable.insert(pFunc).second)
+            collector.dispatchSubtree(*pFunc);
+    }
+
+    // 4. drop the rest
+    for (size_t i = 0; i < root.size(); i++)
+        if (root.at(i)->nodeType() == ASTNodeType::FUNCTION && reachable.count(static_cast<const ASTFunction*>(root.at(i))) == 0)
+            root.setChild(i, nullptr);
+    root.removeNullChildren();
+}
\ No newline at end of file
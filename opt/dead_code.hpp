@@ -0,0 +1,12 @@
+#ifndef __DEAD_CODE_HPP
+#define __DEAD_CODE_HPP
+
+#include "../ast/ast.hpp"
+
+// drops code that can never run, runs after checkSemantics()
+// 1. statements after a function's first return (function bodies are straight-line code)
+// 2. functions unreachable in the call graph rooted at main & the global initializers,
+//    string literals only they used go with them since FlatAST only collects what's left
+void eliminateDeadCode(AST&);
+
+#endif
\ No newline at end of file
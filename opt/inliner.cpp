@@ -0,0 +1,477 @@
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "inliner.hpp"
+#include "../ast/ast_nodes.hpp"
+#include "../ast/ast_visitor.hpp"
+
+/************* CALL GRAPH *************/
+
+// collects the calls in a subtree, through dispatchSubtree()
+class CallFinder : public ConstASTVisitor<CallFinder> {
+    public:
+        CallFinder(std::vector<const ASTCall*>& calls) : calls(calls) {};
+
+        void visitCall(const ASTCall& call) { calls.push_back(&call); };
+    private:
+        std::vector<const ASTCall*>& calls;
+};
+
+// # of nodes in a subtree
+class NodeCounter : public ConstASTVisitor<NodeCounter> {
+    public:
+        size_t count(const ASTNode& node) {
+            numNodes = 0;
+            dispatchSubtree(node);
+            return numNodes;
+        };
+
+        void visitNode(const ASTNode&) { numNodes++; };
+    private:
+        size_t numNodes = 0;
+};
+
+struct CallGraph {
+    std::vector<ASTFunction*> functions; // in source order
+    std::unordered_map<const ASTFunction*, uint32_t> ids; // index in functions
+    std::vector<std::vector<uint32_t>> callees;
+    std::vector<uint32_t> numCallSites;
+    std::vector<uint8_t> isRecursive;
+    std::vector<uint32_t> order; // callees before callers (reverse topological order of the SCCs)
+};
+
+static void buildCallGraph(ASTNode& root, CallGraph& graph) {
+    for (size_t i = 0; i < root.size(); i++) {
+        if (root.at(i)->nodeType() == ASTNodeType::FUNCTION) {
+            ASTFunction* pFunc = static_cast<ASTFunction*>(root.at(i));
+            graph.ids.emplace(pFunc, (uint32_t)graph.functions.size());
+            graph.functions.push_back(pFunc);
+        }
+    }
+
+    const size_t len = graph.functions.size();
+    graph.callees.resize(len);
+    graph.numCallSites.assign(len, 0);
+    std::vector<const ASTCall*> calls;
+    CallFinder finder(calls);
+    for (size_t i = 0; i < root.size(); i++) {
+        calls.clear();
+        finder.dispatchSubtree(*root.at(i));
+        const bool isFunction = root.at(i)->nodeType() == ASTNodeType::FUNCTION;
+        for (const ASTCall* pCall : calls) {
+            const uint32_t callee = graph.ids.at(pCall->pFunction);
+            graph.numCallSites[callee]++;
+            if (isFunction) graph.callees[graph.ids.at(static_cast<const ASTFunction*>(root.at(i)))].push_back(callee);
+        }
+    }
+
+    // Tarjan's SCCs w/ an explicit stack, SCCs complete callees first
+    // a function is recursive if its SCC has a cycle (more than one member or a self call)
+    const uint32_t UNVISITED = UINT32_MAX;
+    std::vector<uint32_t> index(len, UNVISITED), low(len, 0);
+    std::vector<uint8_t> isOnStack(len, false);
+    std::vector<uint32_t> sccStack;
+    struct Frame {
+        uint32_t v;
+        size_t nextEdge;
+    };
+    std::vector<Frame> dfs;
+    uint32_t counter = 0;
+    graph.isRecursive.assign(len, false);
+
+    for (uint32_t start = 0; start < len; start++) {
+        if (index[start] != UNVISITED) continue;
+        index[start] = low[start] = counter++;
+        sccStack.push_back(start);
+        isOnStack[start] = true;
+        dfs.push_back({start, 0});
+
+        while (!dfs.empty()) {
+            Frame& frame = dfs.back();
+            const uint32_t v = frame.v;
+            if (frame.nextEdge < graph.callees[v].size()) {
+                const uint32_t w = graph.callees[v][frame.nextEdge++];
+                if (w == v) graph.isRecursive[v] = true;
+                if (index[w] == UNVISITED) {
+                    index[w] = low[w] = counter++;
+                    sccStack.push_back(w);
+                    isOnStack[w] = true;
+                    dfs.push_back({w, 0}); // invalidates frame
+                } else if (isOnStack[w]) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+
+            if (low[v] == index[v]) { // v roots an SCC
+                const size_t sccStart = std::find(sccStack.begin(), sccStack.end(), v) - sccStack.begin();
+                const bool isCycle = sccStack.size() - sccStart > 1;
+                for (size_t i = sccStart; i < sccStack.size(); i++) {
+                    const uint32_t member = sccStack[i];
+                    isOnStack[member] = false;
+                    if (isCycle) graph.isRecursive[member] = true;
+                    graph.order.push_back(member);
+                }
+                sccStack.resize(sccStart);
+            }
+            dfs.pop_back();
+            if (!dfs.empty()) low[dfs.back().v] = std::min(low[dfs.back().v], low[v]);
+        }
+    }
+}
+
+/************* CLONING *************/
+
+// deep copies a callee's statements with its slots moved up by slotBase, through
+// dispatchPostorder(), each handler copies its node & adds its children's copies
+class BodyCloner : public ConstASTVisitor<BodyCloner, ASTNode*> {
+    public:
+        BodyCloner(ASTArena& arena, slot_t slotBase) : arena(arena), slotBase(slotBase) {};
+
+        ASTNode* visitNode(const ASTNode& node) { return withChildren(node, arena.make<ASTNode>(tokenFor(node, IDENTIFIER), arena)); };
+        ASTNode* visitReturn(const ASTReturn& node) { return withChildren(node, arena.make<ASTReturn>(tokenFor(node, RETURN), arena)); };
+        ASTNode* visitVariable(const ASTVariable& var) {
+            ASTVariable* pVar = arena.make<ASTVariable>(var.getName(), tokenFor(var, var.getType()), arena);
+            pVar->slot = moveSlot(var.slot);
+            return withChildren(var, pVar);
+        };
+        ASTNode* visitIdentifier(const ASTIdentifier& identifier) {
+            ASTIdentifier* pIdentifier = arena.make<ASTIdentifier>(Token{IDENTIFIER, identifier.raw, identifier.err, identifier.getName(), {}}, arena);
+            pIdentifier->valueType = identifier.valueType;
+            pIdentifier->slot = moveSlot(identifier.slot);
+            return pIdentifier;
+        };
+        ASTNode* visitExpr(const ASTExpr& expr) {
+            ASTExpr* pExpr = arena.make<ASTExpr>(tokenFor(expr, IDENTIFIER), arena);
+            pExpr->valueType = expr.valueType;
+            return withChildren(expr, pExpr);
+        };
+        ASTNode* visitUnaryExpr(const ASTUnaryExpr& expr) {
+            ASTUnaryExpr* pExpr = arena.make<ASTUnaryExpr>(tokenFor(expr, expr.opType()), arena);
+            pExpr->valueType = expr.valueType;
+            pExpr->setIsPostOperator(expr.isPostOperator());
+            return withChildren(expr, pExpr);
+        };
+        ASTNode* visitBinExpr(const ASTBinExpr& expr) {
+            ASTBinExpr* pExpr = arena.make<ASTBinExpr>(tokenFor(expr, expr.opType()), arena);
+            pExpr->valueType = expr.valueType;
+            return withChildren(expr, pExpr);
+        };
+        ASTNode* visitCall(const ASTCall& call) {
+            ASTCall* pCall = arena.make<ASTCall>(Token{IDENTIFIER, call.raw, call.err, call.getName(), {}}, arena);
+            pCall->valueType = call.valueType;
+            pCall->pFunction = call.pFunction;
+            return withChildren(call, pCall);
+        };
+        ASTNode* visitBoolLiteral(const ASTBoolLiteral& literal) { return arena.make<ASTBoolLiteral>(literal.val, tokenFor(literal, LIT_BOOL), arena); };
+        ASTNode* visitCharLiteral(const ASTCharLiteral& literal) { return arena.make<ASTCharLiteral>(literal.val, tokenFor(literal, LIT_CHAR), arena); };
+        ASTNode* visitDoubleLiteral(const ASTDoubleLiteral& literal) { return arena.make<ASTDoubleLiteral>(literal.val, tokenFor(literal, LIT_DOUBLE), arena); };
+        ASTNode* visitIntLiteral(const ASTIntLiteral& literal) { return arena.make<ASTIntLiteral>(literal.val, tokenFor(literal, LIT_INT), arena); };
+        ASTNode* visitStringLiteral(const ASTStringLiteral& literal) { return arena.make<ASTStringLiteral>(literal.val, tokenFor(literal, LIT_STR), arena); };
+        ASTNode* visitNullLiteral(const ASTNullLiteral& literal) { return arena.make<ASTNullLiteral>(tokenFor(literal, LIT_NULL), arena); };
+    private:
+        ASTNode* withChildren(const ASTNode& node, ASTNode* pCopy) {
+            for (size_t i = 0; i < node.size(); i++)
+                pCopy->push(pChildResults[i]);
+            return pCopy;
+        };
+
+        static Token tokenFor(const ASTNode& node, TokenType type) { return {type, node.raw, node.err, SYMBOL_NONE, {}}; };
+        slot_t moveSlot(slot_t slot) const { return isSlotGlobal(slot) ? slot : slot + slotBase; };
+
+        ASTArena& arena;
+        slot_t slotBase;
+};
+
+/************* INLINING *************/
+
+// where a call sits, so it can be replaced
+struct CallSite {
+    ASTNode* pParent;
+    size_t index;
+    ASTCall* pCall;
+};
+
+// type of the value a node evaluates to, as annotated by the semantic pass
+static TokenType getValueType(const ASTNode& node) {
+    switch (node.nodeType()) {
+        case ASTNodeType::EXPR: case ASTNodeType::UNARY_EXPR: case ASTNodeType::BIN_EXPR: case ASTNodeType::CALL:
+            return static_cast<const ASTExpr&>(node).valueType;
+        case ASTNodeType::IDENTIFIER: return static_cast<const ASTIdentifier&>(node).valueType;
+        case ASTNodeType::LIT_BOOL: return TYPE_BOOL;
+        case ASTNodeType::LIT_CHAR: return TYPE_CHAR;
+        case ASTNodeType::LIT_DOUBLE: return TYPE_DOUBLE;
+        default: return node.nodeType() == ASTNodeType::LIT_INT ? TYPE_INT : TYPE_STR;
+    }
+}
+
+// locals written anywhere in a subtree, through dispatchSubtree()
+class LocalWriteFinder : public ConstASTVisitor<LocalWriteFinder> {
+    public:
+        LocalWriteFinder(std::vector<slot_t>& slots) : slots(slots) {};
+
+        void visitUnaryExpr(const ASTUnaryExpr& expr) {
+            if (expr.opType() == OP_INC || expr.opType() == OP_DEC) add(*expr.at(0));
+        };
+        void visitBinExpr(const ASTBinExpr& expr) {
+            if (isTokenAssignOp(expr.opType())) add(*expr.at(0));
+        };
+    private:
+        void add(const ASTNode& target) {
+            const slot_t slot = static_cast<const ASTIdentifier&>(target).slot;
+            if (!isSlotGlobal(slot)) slots.push_back(slot);
+        };
+
+        std::vector<slot_t>& slots;
+};
+
+// walks a statement in evaluation order up to the first call that can be hoisted in front of it
+// everything evaluated before the call has to be pure & independent of what the hoisted code
+// does: no side effects, no calls, no global reads (the callee may write them) & no reads of
+// locals that the call's args write
+// the path to the node being searched is kept on a staged stack (see ast_visitor.hpp)
+template <typename CanInline>
+class HoistableCallFinder {
+    public:
+        HoistableCallFinder(const CanInline& canInline) : canInline(canInline) {};
+
+        // true once site is set
+        bool search(ASTNode& statement) {
+            enter(statement);
+            while (!stack.empty()) {
+                Pending& pending = stack.back();
+                ASTNode& node = *pending.pNode;
+                if (pending.next == node.size()) {
+                    leave(pending);
+                    stack.pop_back();
+                    continue;
+                }
+
+                const size_t i = pending.next++;
+                if (i == 1 && isShortCircuit(node)) isConditional = true; // the right side may not run
+                ASTNode& child = *node.at(i);
+                if (child.nodeType() == ASTNodeType::CALL) {
+                    ASTCall& call = static_cast<ASTCall&>(child);
+                    if (!isConditional && isPure && canInline(call) && !doArgsWriteRead(call)) {
+                        site = {&node, i, &call};
+                        return true;
+                    }
+                }
+                enter(child); // invalidates pending
+            }
+            return false;
+        };
+
+        CallSite site = {nullptr, 0, nullptr};
+    private:
+        // a node whose children are being searched
+        struct Pending {
+            ASTNode* pNode;
+            size_t next; // child searched next
+            bool wasConditional; // isConditional outside the node
+        };
+
+        // what evaluating node does before its children, which are then searched in order
+        void enter(ASTNode& node) {
+            size_t first = 0;
+            switch (node.nodeType()) {
+                case ASTNodeType::IDENTIFIER:
+                    read(static_cast<const ASTIdentifier&>(node));
+                    return;
+                case ASTNodeType::UNARY_EXPR: {
+                    const TokenType op = static_cast<const ASTUnaryExpr&>(node).opType();
+                    if (op == OP_INC || op == OP_DEC) {
+                        isPure = false;
+                        return;
+                    }
+                    break;
+                }
+                case ASTNodeType::BIN_EXPR: {
+                    const TokenType op = static_cast<const ASTBinExpr&>(node).opType();
+                    if (isTokenAssignOp(op)) {
+                        if (op != ASSIGN) read(static_cast<const ASTIdentifier&>(*node.at(0))); // compound reads the target first
+                        first = 1;
+                    }
+                    break;
+                }
+                default: break;
+            }
+            stack.push_back({&node, first, isConditional});
+        };
+
+        // what evaluating node does after its children
+        void leave(const Pending& pending) {
+            const ASTNode& node = *pending.pNode;
+            if (node.nodeType() == ASTNodeType::CALL || isAssignment(node)) isPure = false;
+            isConditional = pending.wasConditional;
+        };
+
+        void read(const ASTIdentifier& identifier) {
+            if (isSlotGlobal(identifier.slot)) isPure = false;
+            else localsRead.push_back(identifier.slot);
+        };
+
+        static bool isAssignment(const ASTNode& node) {
+            return node.nodeType() == ASTNodeType::BIN_EXPR && isTokenAssignOp(static_cast<const ASTBinExpr&>(node).opType());
+        };
+
+        static bool isShortCircuit(const ASTNode& node) {
+            if (node.nodeType() != ASTNodeType::BIN_EXPR) return false;
+            const TokenType op = static_cast<const ASTBinExpr&>(node).opType();
+            return op == OP_BOOL_AND || op == OP_BOOL_OR;
+        };
+
+        bool doArgsWriteRead(const ASTCall& call) const {
+            if (localsRead.empty()) return false;
+            std::vector<slot_t> written;
+            LocalWriteFinder writes(written);
+            for (size_t i = 0; i < call.size(); i++) writes.dispatchSubtree(*call.at(i));
+            for (slot_t slot : written)
+                if (std::find(localsRead.begin(), localsRead.end(), slot) != localsRead.end()) return true;
+            return false;
+        };
+
+        const CanInline& canInline;
+        bool isPure = true; // if everything evaluated so far is
+        bool isConditional = false; // inside the right side of && or ||
+        std::vector<slot_t> localsRead;
+        std::vector<Pending> stack;
+};
+
+class Inliner {
+    public:
+        Inliner(ASTArena& arena, CallGraph& graph) : arena(arena), graph(graph), sizes(graph.functions.size(), 0) {};
+
+        void run() {
+            for (uint32_t id : graph.order) {
+                inlineInto(*graph.functions[id]);
+                sizes[id] = countBody(*graph.functions[id]);
+            }
+        };
+    private:
+        size_t countBody(const ASTFunction& func) const {
+            NodeCounter counter;
+            size_t count = 0;
+            for (size_t i = 0; i < func.size(); i++) count += counter.count(*func.at(i));
+            return count;
+        };
+
+        // size & benefit heuristic
+        bool shouldInline(const ASTCall& call, const ASTFunction& caller, size_t callerSize) const {
+            const uint32_t callee = graph.ids.at(call.pFunction);
+            if (call.pFunction == &caller || graph.isRecursive[callee] || callerSize > INLINE_MAX_CALLER_NODES) return false;
+
+            size_t budget = INLINE_BASE_BUDGET;
+            for (size_t i = 0; i < call.size(); i++)
+                if (isConstant(*call.at(i))) budget += INLINE_CONSTANT_ARG_BONUS;
+            if (graph.numCallSites[callee] == 1) budget += INLINE_SINGLE_CALL_BONUS;
+            return sizes[callee] <= budget;
+        };
+
+        static bool isConstant(const ASTNode& node) {
+            const ASTNodeType type = node.nodeType();
+            return type == ASTNodeType::LIT_BOOL || type == ASTNodeType::LIT_CHAR || type == ASTNodeType::LIT_DOUBLE || type == ASTNodeType::LIT_INT;
+        };
+
+        void inlineInto(ASTFunction& func) {
+            std::vector<ASTNode*> body;
+            size_t callerSize = countBody(func);
+            for (size_t i = 0; i < func.size(); i++)
+                inlineStatement(func, func.at(i), callerSize, body);
+
+            while (func.size() > 0) func.pop();
+            for (ASTNode* pStatement : body) func.push(pStatement);
+        };
+
+        // appends the statement to body after hoisting whatever it calls out in front of it
+        // the hoisted statements are searched the same way (ex. calls in the args)
+        void inlineStatement(ASTFunction& func, ASTNode* pStatement, size_t& callerSize, std::vector<ASTNode*>& body) {
+            auto canInline = [&](const ASTCall& call) { return shouldInline(call, func, callerSize); };
+            while (true) { // searched again after each call it loses
+                HoistableCallFinder<decltype(canInline)> finder(canInline);
+                if (!finder.search(*pStatement)) break;
+
+                std::vector<ASTNode*> hoisted;
+                callerSize += hoist(func, finder.site, hoisted);
+                for (ASTNode* pHoisted : hoisted)
+                    inlineStatement(func, pHoisted, callerSize, body);
+            }
+            body.push_back(pStatement);
+        };
+
+        // appends the callee's body to out & replaces the call with the local holding its result
+        // returns the # of nodes added
+        size_t hoist(ASTFunction& caller, const CallSite& site, std::vector<ASTNode*>& out) {
+            const ASTCall& call = *site.pCall;
+            const ASTFunction& callee = *call.pFunction;
+            const size_t outStart = out.size();
+
+            // every slot of the callee gets a fresh one in the caller, params first
+            const slot_t slotBase = (slot_t)caller.numSlots;
+            caller.numSlots += callee.numSlots;
+            const arena_vector<param_t>& params = callee.getParams();
+            for (size_t i = 0; i < params.size(); i++) {
+                ASTVariable* pParam = arena.make<ASTVariable>(params[i].first, Token{params[i].second, call.raw, call.err, params[i].first, {}}, arena);
+                pParam->slot = slotBase + (slot_t)i;
+                pParam->push(wrap(call.at(i)));
+                out.push_back(pParam);
+            }
+
+            // the body, its return's expression becomes the result's initializer
+            BodyCloner cloner(arena, slotBase);
+            ASTNode* pResultValue = nullptr;
+            for (size_t i = 0; i < callee.size(); i++) {
+                const ASTNode& statement = *callee.at(i);
+                if (statement.nodeType() == ASTNodeType::RETURN) {
+                    if (statement.size() > 0) pResultValue = cloner.dispatchPostorder(*statement.at(0));
+                    break;
+                }
+                out.push_back(cloner.dispatchPostorder(statement));
+            }
+            const TokenType returnType = callee.getReturnType();
+            if (pResultValue == nullptr) { // falling off the end (or a bare return) returns 0
+                const Token zero = {IDENTIFIER, call.raw, call.err, SYMBOL_NONE, {}};
+                if (returnType == TYPE_DOUBLE) pResultValue = arena.make<ASTDoubleLiteral>(0.0, zero, arena);
+                else if (returnType == TYPE_STR) pResultValue = arena.make<ASTNullLiteral>(zero, arena);
+                else pResultValue = arena.make<ASTIntLiteral>(0, zero, arena);
+                pResultValue = wrap(pResultValue);
+            }
+
+            const slot_t resultSlot = (slot_t)caller.numSlots++;
+            ASTVariable* pResult = arena.make<ASTVariable>(callee.getName(), Token{returnType, call.raw, call.err, callee.getName(), {}}, arena);
+            pResult->slot = resultSlot;
+            pResult->push(pResultValue); // already wrapped, like the return's
+            out.push_back(pResult);
+
+            ASTIdentifier* pRead = arena.make<ASTIdentifier>(Token{IDENTIFIER, call.raw, call.err, callee.getName(), {}}, arena);
+            pRead->valueType = returnType;
+            pRead->slot = resultSlot;
+            site.pParent->setChild(site.index, pRead);
+
+            NodeCounter counter;
+            size_t added = 0;
+            for (size_t i = outStart; i < out.size(); i++) added += counter.count(*out[i]);
+            return added;
+        };
+
+        // expression wrapper, as the parser puts around initializers
+        ASTNode* wrap(ASTNode* pValue) {
+            ASTExpr* pExpr = arena.make<ASTExpr>(Token{IDENTIFIER, pValue->raw, pValue->err, SYMBOL_NONE, {}}, arena);
+            pExpr->valueType = getValueType(*pValue);
+            pExpr->push(pValue);
+            return pExpr;
+        };
+
+        ASTArena& arena;
+        CallGraph& graph;
+        std::vector<size_t> sizes; // body node counts, final once a function has been inlined into
+};
+
+void inlineCalls(AST& ast) {
+    CallGraph graph;
+    buildCallGraph(*ast.pRoot, graph);
+    Inliner inliner(ast.arena, graph);
+    inliner.run();
+}
\ No newline at end of file
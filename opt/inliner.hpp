@@ -0,0 +1,24 @@
+#ifndef __INLINER_HPP
+#define __INLINER_HPP
+
+#include "../ast/ast.hpp"
+
+// a callee is inlined if its body is at most this many nodes...
+#define INLINE_BASE_BUDGET 16
+// ...plus this much per literal argument (each one lets folding collapse part of the body)
+#define INLINE_CONSTANT_ARG_BONUS 8
+// ...plus this much if it's the only call to it (the callee is dropped afterwards)
+#define INLINE_SINGLE_CALL_BONUS 48
+// callers stop taking in bodies once they're this big
+#define INLINE_MAX_CALLER_NODES 4096
+
+// splices the bodies of small, non-recursive functions into their callers, runs after
+// eliminateDeadCode() (which leaves a return only as a body's last statement)
+// function bodies are straight-line code, so a call is inlined by hoisting it in front of its
+// statement: the args become fresh locals standing in for the params, then the callee's own
+// locals (also fresh), then its return value goes into one more local that replaces the call
+// only calls nothing before them in the statement can tell apart from hoisting are inlined,
+// callees are done before callers so inlined bodies are already inlined themselves
+void inlineCalls(AST&);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,474 @@
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "local_dataflow.hpp"
+#include "constant_folding.hpp"
+#include "../ast/ast_nodes.hpp"
+#include "../ast/ast_visitor.hpp"
+
+// type of the value a node evaluates to, as annotated by the semantic pass
+static TokenType getValueType(const ASTNode& node) {
+    switch (node.nodeType()) {
+        case ASTNodeType::EXPR: case ASTNodeType::UNARY_EXPR: case ASTNodeType::BIN_EXPR: case ASTNodeType::CALL:
+            return static_cast<const ASTExpr&>(node).valueType;
+        case ASTNodeType::IDENTIFIER: return static_cast<const ASTIdentifier&>(node).valueType;
+        case ASTNodeType::LIT_BOOL: return TYPE_BOOL;
+        case ASTNodeType::LIT_CHAR: return TYPE_CHAR;
+        case ASTNodeType::LIT_DOUBLE: return TYPE_DOUBLE;
+        default: return node.nodeType() == ASTNodeType::LIT_INT ? TYPE_INT : TYPE_STR;
+    }
+}
+
+// the variable an assignment or ++/-- writes to
+static const ASTIdentifier& getTarget(ASTNode& expr) {
+    return *static_cast<const ASTIdentifier*>(expr.at(0));
+}
+
+static inline bool isIncDec(const ASTNode& node) {
+    if (node.nodeType() != ASTNodeType::UNARY_EXPR) return false;
+    const TokenType op = static_cast<const ASTUnaryExpr&>(node).opType();
+    return op == OP_INC || op == OP_DEC;
+}
+
+static inline bool isAssignment(const ASTNode& node) {
+    return node.nodeType() == ASTNodeType::BIN_EXPR && isTokenAssignOp(static_cast<const ASTBinExpr&>(node).opType());
+}
+
+// whether evaluating a subtree writes to any variable (calls may write globals)
+// answers are worked out through dispatchPostorder() & kept per node, so asking about every
+// operator of a deep expression top down stays linear, a subtree mustn't change once asked about
+class SideEffectFinder : public ConstASTVisitor<SideEffectFinder, uint8_t> {
+    public:
+        bool hasSideEffects(const ASTNode& root) {
+            const auto it = known.find(&root);
+            return it != known.end() ? it->second : dispatchPostorder(root);
+        };
+
+        uint8_t visitNode(const ASTNode& node) {
+            bool isAnyWrite = isIncDec(node) || isAssignment(node) || node.nodeType() == ASTNodeType::CALL;
+            for (size_t i = 0; i < node.size(); i++)
+                isAnyWrite = isAnyWrite || pChildResults[i];
+            known.emplace(&node, isAnyWrite);
+            return isAnyWrite;
+        };
+    private:
+        std::unordered_map<const ASTNode*, bool> known;
+};
+
+// a value per local slot, changes made after a mark are logged so a branch that may not run
+// (the right side of && & ||) costs what it changed rather than a copy of every slot
+template <typename T>
+class SlotValues {
+    public:
+        SlotValues(size_t numSlots, const T& init) : values(numSlots, init) {};
+
+        const T& operator[](slot_t slot) const { return values[slot]; };
+
+        void set(slot_t slot, const T& val) {
+            if (numMarks > 0) undoLog.push_back({slot, values[slot]});
+            values[slot] = val;
+        };
+
+        // resets every slot, only between statements (never while marked)
+        void fill(const T& val) { std::fill(values.begin(), values.end(), val); };
+
+        size_t mark() {
+            numMarks++;
+            return undoLog.size();
+        };
+
+        // every slot changed since the mark becomes merge(value at the mark, value now),
+        // which is itself a change for any mark still open
+        template <typename Merge>
+        void merge(size_t mark, Merge merge) {
+            std::vector<std::pair<slot_t, T>> changed;
+            for (size_t i = mark; i < undoLog.size(); i++)
+                changed.push_back({undoLog[i].first, values[undoLog[i].first]});
+            for (size_t i = undoLog.size(); i-- > mark;)
+                values[undoLog[i].first] = undoLog[i].second;
+            undoLog.resize(mark);
+            numMarks--;
+            for (const std::pair<slot_t, T>& change : changed)
+                set(change.first, merge(values[change.first], change.second));
+        };
+    private:
+        std::vector<T> values;
+        std::vector<std::pair<slot_t, T>> undoLog; // slot & its value before each change
+        size_t numMarks = 0;
+};
+
+// what a handler of a ResumableWalker does next
+struct WalkStep {
+    enum Kind : uint8_t { CHILD, REPLACE, DONE } kind;
+    ASTNode* pNode; // CHILD: walked before the handler runs again, REPLACE: walked in the node's place, DONE: what replaces the node
+    bool isUsed; // CHILD & REPLACE, if pNode's value is used
+};
+
+// walks a subtree from a staged stack (see ast_visitor.hpp), a handler runs when its node is
+// reached & again each time a child it asked for is done (step() counts its runs before this
+// one, pChild is what replaces that child)
+template <typename Derived>
+class ResumableWalker : public ASTVisitor<Derived, WalkStep> {
+    public:
+        // returns what replaces root
+        ASTNode* walk(ASTNode& root, bool isUsed = true) {
+            stack.push_back({&root, isUsed, 0, 0});
+            ASTNode* pResult = nullptr;
+            while (!stack.empty()) {
+                Pending& pending = stack.back();
+                isValueUsed = pending.isUsed;
+                pChild = pResult;
+                const WalkStep next = this->dispatch(*pending.pNode);
+                pending.step++;
+                switch (next.kind) {
+                    case WalkStep::CHILD: stack.push_back({next.pNode, next.isUsed, 0, 0}); break;
+                    case WalkStep::REPLACE: pending = {next.pNode, next.isUsed, 0, 0}; break;
+                    case WalkStep::DONE:
+                        pResult = next.pNode;
+                        stack.pop_back();
+                        break;
+                }
+            }
+            return pResult;
+        };
+    protected:
+        static WalkStep child(ASTNode& node, bool isUsed = true) { return {WalkStep::CHILD, &node, isUsed}; };
+        static WalkStep replaceWith(ASTNode& node, bool isUsed) { return {WalkStep::REPLACE, &node, isUsed}; };
+        static WalkStep done(ASTNode* pNode) { return {WalkStep::DONE, pNode, false}; };
+
+        size_t step() const { return stack.back().step; };
+        size_t& saved() { return stack.back().saved; }; // kept between the runs of a node's handler
+
+        ASTNode* pChild = nullptr;
+        bool isValueUsed = true; // if the node being visited has its value used
+    private:
+        struct Pending {
+            ASTNode* pNode;
+            bool isUsed;
+            size_t step;
+            size_t saved;
+        };
+        std::vector<Pending> stack;
+};
+
+/************* PROPAGATION *************/
+
+// what's known about a local's value at a point in the function
+struct LocalFact {
+    enum Kind : uint8_t { UNKNOWN, CONSTANT, COPY } kind = UNKNOWN;
+    Constant val = {TYPE_INT, 0, 0}; // CONSTANT, already converted to the local's type
+    slot_t source = 0; // COPY, the local holding the same value
+    symbol_t sourceName = SYMBOL_NONE;
+
+    bool operator==(const LocalFact& other) const {
+        return kind == other.kind && source == other.source && val.type == other.val.type &&
+               val.i == other.val.i && std::memcmp(&val.d, &other.val.d, sizeof(double)) == 0;
+    };
+    bool operator!=(const LocalFact& other) const { return !(*this == other); };
+};
+
+// walks a function body in evaluation order, folding each expression once its operands are done
+class LocalPropagator : public ResumableWalker<LocalPropagator> {
+    public:
+        LocalPropagator(ASTArena& arena, size_t numSlots) : arena(arena), facts(numSlots, LocalFact()), copies(numSlots) {};
+
+        void propagate(ASTFunction& func) {
+            for (size_t i = 0; i < func.size(); i++) {
+                ASTNode& statement = *func.at(i);
+                switch (statement.nodeType()) {
+                    case ASTNodeType::VARIABLE: {
+                        ASTVariable& var = static_cast<ASTVariable&>(statement);
+                        ASTNode& init = *var.at(0);
+                        init.setChild(0, walk(*init.at(0)));
+                        record(var.slot, var.getType(), *init.at(0));
+                        break;
+                    }
+                    case ASTNodeType::RETURN: case ASTNodeType::EXPR:
+                        for (size_t j = 0; j < statement.size(); j++)
+                            statement.setChild(j, walk(*statement.at(j)));
+                        break;
+                    default: break;
+                }
+            }
+        };
+
+        // every child in order
+        WalkStep visitNode(ASTNode& node) {
+            const size_t i = step();
+            if (i > 0) node.setChild(i - 1, pChild);
+            return i < node.size() ? child(*node.at(i)) : done(&node);
+        };
+
+        WalkStep visitIdentifier(ASTIdentifier& identifier) {
+            if (isSlotGlobal(identifier.slot)) return done(&identifier);
+            const LocalFact& fact = facts[identifier.slot];
+            if (fact.kind == LocalFact::CONSTANT)
+                return done(makeLiteral(identifier.valueType, fact.val, identifier, arena));
+            if (fact.kind == LocalFact::COPY) {
+                ASTIdentifier* pCopy = arena.make<ASTIdentifier>(Token{IDENTIFIER, identifier.raw, identifier.err, fact.sourceName, {}}, arena);
+                pCopy->valueType = identifier.valueType;
+                pCopy->slot = fact.source;
+                return done(pCopy);
+            }
+            return done(&identifier);
+        };
+
+        WalkStep visitUnaryExpr(ASTUnaryExpr& expr) {
+            if (isIncDec(expr)) { // the operand is written, not read through
+                kill(getTarget(expr).slot);
+                return done(&expr);
+            }
+            if (step() == 0) return child(*expr.at(0));
+            expr.setChild(0, pChild);
+            return done(foldNode(expr, arena));
+        };
+
+        WalkStep visitBinExpr(ASTBinExpr& expr) {
+            const TokenType op = expr.opType();
+            if (isTokenAssignOp(op)) {
+                // the right side is evaluated before the store
+                if (step() == 0) return child(*expr.right());
+                expr.setChild(1, pChild);
+                const ASTIdentifier& target = getTarget(expr);
+                kill(target.slot);
+                if (op == ASSIGN) record(target.slot, target.valueType, *expr.right());
+                return done(&expr);
+            }
+
+            // the right side of && & || may not run, so whatever it changes is unknown afterwards
+            const bool isShortCircuit = op == OP_BOOL_AND || op == OP_BOOL_OR;
+            switch (step()) {
+                case 0: return child(*expr.left());
+                case 1:
+                    expr.setChild(0, pChild);
+                    if (isShortCircuit) saved() = facts.mark();
+                    return child(*expr.right());
+                default:
+                    expr.setChild(1, pChild);
+                    if (isShortCircuit) {
+                        facts.merge(saved(), [](const LocalFact& before, const LocalFact& after) {
+                            return before == after ? before : LocalFact();
+                        });
+                    }
+                    return done(foldNode(expr, arena));
+            }
+        };
+    private:
+        // slot was written, it & any copies of it are unknown
+        void kill(slot_t slot) {
+            if (isSlotGlobal(slot)) return;
+            facts.set(slot, LocalFact());
+            for (const slot_t copy : copies[slot])
+                if (facts[copy].kind == LocalFact::COPY && facts[copy].source == slot) facts.set(copy, LocalFact());
+            copies[slot].clear();
+        };
+
+        // slot (of type) was just set to value
+        void record(slot_t slot, TokenType type, const ASTNode& value) {
+            if (isSlotGlobal(slot)) return;
+            LocalFact fact;
+
+            Constant val;
+            if (getConstant(&value, val)) {
+                // stored the way convertValue() would store it
+                if (type == TYPE_DOUBLE) val.d = val.asDouble();
+                else if (type == TYPE_CHAR) val.i = (signed char)val.i;
+                val.type = type;
+                fact.kind = LocalFact::CONSTANT;
+                fact.val = val;
+            } else if (value.nodeType() == ASTNodeType::IDENTIFIER) {
+                const ASTIdentifier& source = static_cast<const ASTIdentifier&>(value);
+                if (!isSlotGlobal(source.slot) && source.slot != slot && source.valueType == type) {
+                    fact.kind = LocalFact::COPY;
+                    fact.source = source.slot;
+                    fact.sourceName = source.getName();
+                    copies[source.slot].push_back(slot);
+                }
+            }
+            facts.set(slot, fact);
+        };
+
+        ASTArena& arena;
+        SlotValues<LocalFact> facts;
+        // slot -> the locals recorded as copies of it, so a write only visits those
+        // (entries go stale once the copy is overwritten, kill() checks them)
+        std::vector<std::vector<slot_t>> copies;
+};
+
+/************* DEAD STORES *************/
+
+// walks a function body backwards tracking which locals are read later on
+// each handler ends w/ what replaces its node, nullptr if the node can go entirely
+// (only possible when its value isn't used & it has no side effects left)
+class DeadStoreEliminator : public ResumableWalker<DeadStoreEliminator> {
+    public:
+        DeadStoreEliminator(size_t numSlots) : live(numSlots, false) {};
+
+        void eliminate(ASTFunction& func) {
+            for (size_t i = func.size(); i-- > 0;) {
+                ASTNode& statement = *func.at(i);
+                switch (statement.nodeType()) {
+                    case ASTNodeType::RETURN:
+                        live.fill(false); // nothing after it runs
+                        if (statement.size() > 0) statement.setChild(0, walk(*statement.at(0), true));
+                        break;
+                    case ASTNodeType::VARIABLE: {
+                        ASTVariable& var = static_cast<ASTVariable&>(statement);
+                        if (isLive(var.slot)) {
+                            live.set(var.slot, false);
+                            var.setChild(0, walk(*var.at(0), true));
+                        } else { // never read, only its initializer's side effects are kept
+                            func.setChild(i, walk(*var.at(0), false));
+                        }
+                        break;
+                    }
+                    case ASTNodeType::EXPR:
+                        func.setChild(i, walk(statement, false));
+                        break;
+                    default: break;
+                }
+            }
+            func.removeNullChildren();
+        };
+
+        // leaves
+        WalkStep visitNode(ASTNode& node) { return done(isValueUsed ? &node : nullptr); };
+
+        WalkStep visitIdentifier(ASTIdentifier& identifier) {
+            if (!isValueUsed) return done(nullptr); // the read goes too
+            if (!isSlotGlobal(identifier.slot)) live.set(identifier.slot, true);
+            return done(&identifier);
+        };
+
+        WalkStep visitExpr(ASTExpr& expr) {
+            if (step() == 0) return child(*expr.at(0), isValueUsed);
+            if (pChild == nullptr) return done(nullptr);
+            expr.setChild(0, pChild);
+            return done(&expr);
+        };
+
+        // always kept, only locals are tracked & a callee can't see those, args go last to first
+        WalkStep visitCall(ASTCall& call) {
+            const size_t i = step();
+            if (i > 0) call.setChild(call.size() - i, pChild);
+            return i < call.size() ? child(*call.at(call.size() - 1 - i), true) : done(&call);
+        };
+
+        WalkStep visitUnaryExpr(ASTUnaryExpr& expr) {
+            if (isIncDec(expr)) {
+                const slot_t slot = getTarget(expr).slot;
+                if (!isValueUsed && !isLive(slot)) return done(nullptr);
+                if (!isSlotGlobal(slot)) live.set(slot, true); // read, then written
+                return done(&expr);
+            }
+            if (step() == 0) return child(*expr.at(0), isValueUsed);
+            if (!isValueUsed) return done(pChild); // only the operand's side effects matter
+            expr.setChild(0, pChild);
+            return done(&expr);
+        };
+
+        WalkStep visitBinExpr(ASTBinExpr& expr) {
+            const TokenType op = expr.opType();
+
+            if (isTokenAssignOp(op)) {
+                const ASTIdentifier& target = getTarget(expr);
+                if (step() == 0) {
+                    // a dead store leaves just its right side, which has to stand in for the
+                    // assignment's value if that's used
+                    const bool isUnread = !isLive(target.slot);
+                    if (isUnread && (!isValueUsed || (op == ASSIGN && getValueType(*expr.right()) == target.valueType)))
+                        return replaceWith(*expr.right(), isValueUsed);
+
+                    if (!isSlotGlobal(target.slot)) live.set(target.slot, false);
+                    return child(*expr.right(), true);
+                }
+                expr.setChild(1, pChild);
+                if (op != ASSIGN && !isSlotGlobal(target.slot)) live.set(target.slot, true); // compound reads it first
+                return done(&expr);
+            }
+
+            // the right side of && & || may not run, so whatever was live after it still is before it
+            const bool isShortCircuit = op == OP_BOOL_AND || op == OP_BOOL_OR;
+            switch (step()) {
+                case 0:
+                    if (!isValueUsed && !sideEffects.hasSideEffects(expr)) return done(nullptr);
+                    if (isShortCircuit) {
+                        saved() = live.mark();
+                        return child(*expr.right(), true);
+                    }
+
+                    // with the value unused, a side without side effects can go
+                    if (!isValueUsed && !sideEffects.hasSideEffects(*expr.right())) return replaceWith(*expr.left(), false);
+                    if (!isValueUsed && !sideEffects.hasSideEffects(*expr.left())) return replaceWith(*expr.right(), false);
+                    return child(*expr.right(), true); // reverse evaluation order
+                case 1:
+                    expr.setChild(1, pChild);
+                    if (isShortCircuit) live.merge(saved(), [](uint8_t after, uint8_t before) -> uint8_t { return after | before; });
+                    return child(*expr.left(), true);
+                default:
+                    expr.setChild(0, pChild);
+                    return done(&expr);
+            }
+        };
+    private:
+        // globals are always live, anything may read them
+        bool isLive(slot_t slot) const { return isSlotGlobal(slot) || live[slot]; };
+
+        SlotValues<uint8_t> live;
+        SideEffectFinder sideEffects; // asked before a node's subtree is walked, so never stale
+};
+
+/************* SLOTS *************/
+
+// renumbers the locals still referenced in a function so they're contiguous again
+class SlotCompactor : public ASTVisitor<SlotCompactor> {
+    public:
+        SlotCompactor(size_t numSlots) : slots(numSlots, UNUSED) {};
+
+        void compact(ASTFunction& func) {
+            // params keep the first slots
+            for (size_t i = 0; i < func.getNumParams(); i++) slots[i] = USED;
+            isMarking = true;
+            dispatchSubtree(func);
+
+            slot_t next = 0;
+            for (slot_t& slot : slots)
+                if (slot == USED) slot = next++;
+            isMarking = false;
+            dispatchSubtree(func);
+            func.numSlots = next;
+        };
+
+        void visitVariable(ASTVariable& var) { update(var.slot); };
+        void visitIdentifier(ASTIdentifier& identifier) { update(identifier.slot); };
+    private:
+        static constexpr slot_t UNUSED = (slot_t)-1, USED = (slot_t)-2;
+
+        void update(slot_t& slot) {
+            if (isSlotGlobal(slot)) return;
+            if (isMarking) slots[slot] = USED;
+            else slot = slots[slot];
+        };
+
+        std::vector<slot_t> slots; // old slot -> new slot
+        bool isMarking = true;
+};
+
+void propagateLocals(AST& ast) {
+    for (size_t i = 0; i < ast.pRoot->size(); i++) {
+        ASTNode* pNode = ast.pRoot->at(i);
+        if (pNode->nodeType() != ASTNodeType::FUNCTION) continue;
+        ASTFunction& func = *static_cast<ASTFunction*>(pNode);
+
+        LocalPropagator propagator(ast.arena, func.numSlots);
+        propagator.propagate(func);
+        DeadStoreEliminator eliminator(func.numSlots);
+        eliminator.eliminate(func);
+        foldConstants(func, ast.arena); // dead stores may have left constants behind
+        SlotCompactor compactor(func.numSlots);
+        compactor.compact(func);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#ifndef __LOCAL_DATAFLOW_HPP
+#define __LOCAL_DATAFLOW_HPP
+
+#include "../ast/ast.hpp"
+
+// dataflow over the locals of each function body (straight-line code, so one pass each way):
+// 1. forward, constants & copies from initializers & assignments replace later reads
+//    (with the expressions folded again as they become constant)
+// 2. backward, stores to locals that are never read again are dropped along with
+//    declarations that end up unused, keeping any side effects of their values (then folded again)
+// 3. the surviving locals are renumbered so the frame only holds what's left
+// globals are never touched, runs after checkSemantics()
+void propagateLocals(AST&);
+
+#endif
\ No newline at end of file
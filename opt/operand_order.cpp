@@ -0,0 +1,57 @@
+#include <algorithm>
+
+#include "operand_order.hpp"
+#include "../ast/ast_nodes.hpp"
+#include "../ast/ast_visitor.hpp"
+
+// label of a subtree
+struct Need {
+    unsigned registers; // # of registers it takes to evaluate
+    bool isPure; // no side effects, so it can be evaluated in any order with its siblings
+};
+
+// labels bottom up through dispatchPostorder(), marking the binaries to evaluate right first on the way
+class OperandOrderer : public ASTVisitor<OperandOrderer, Need> {
+    public:
+        // statements & anything else that isn't an expression
+        Need visitNode(ASTNode& node) {
+            Need need = {1, true};
+            for (size_t i = 0; i < node.size(); i++)
+                need = {std::max(need.registers, pChildResults[i].registers), need.isPure && pChildResults[i].isPure};
+            return need;
+        };
+
+        Need visitUnaryExpr(ASTUnaryExpr& expr) {
+            const Need operand = pChildResults[0];
+            const bool isWrite = expr.opType() == OP_INC || expr.opType() == OP_DEC;
+            return {operand.registers, operand.isPure && !isWrite};
+        };
+
+        Need visitBinExpr(ASTBinExpr& expr) {
+            const Need left = pChildResults[0], right = pChildResults[1];
+            const TokenType op = expr.opType();
+            const bool isPure = left.isPure && right.isPure;
+
+            // plain assignment only evaluates its right, && & || decide whether the right runs at all
+            if (op == ASSIGN) return {right.registers, false};
+            if (op == OP_BOOL_AND || op == OP_BOOL_OR) return {std::max(left.registers, right.registers), isPure};
+
+            const unsigned registers = left.registers == right.registers ? left.registers + 1 : std::max(left.registers, right.registers);
+            if (isTokenAssignOp(op)) return {registers, false}; // the variable is read before the right runs
+            expr.isRightFirst = isPure && right.registers > left.registers;
+            return {registers, isPure};
+        };
+
+        // the callee may write globals, so a call is never moved
+        Need visitCall(ASTCall& call) {
+            unsigned registers = 1;
+            for (size_t i = 0; i < call.size(); i++)
+                registers = std::max(registers, pChildResults[i].registers);
+            return {registers, false};
+        };
+};
+
+void orderOperands(AST& ast) {
+    OperandOrderer orderer;
+    orderer.dispatchPostorder(*ast.pRoot);
+}
\ No newline at end of file
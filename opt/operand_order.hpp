@@ -0,0 +1,13 @@
+#ifndef __OPERAND_ORDER_HPP
+#define __OPERAND_ORDER_HPP
+
+#include "../ast/ast.hpp"
+
+// Sethi-Ullman labelling, each expression is labelled with the # of registers it needs
+// (leaves need 1, a binary needs the larger of its operands' or one more if they tie) & binaries
+// whose right operand needs more are marked to evaluate it first, keeping fewer values live
+// only operands without side effects (no assignments, ++/-- or calls) are swapped, so the
+// order stays unobservable, && & || always go left first, runs after checkSemantics()
+void orderOperands(AST&);
+
+#endif
\ No newline at end of file
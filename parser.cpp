@@ -1,149 +1,237 @@
+#include <cstdint>
+#include <exception>
 #include <iostream>
+#include <vector>
 
 #include "parser.hpp"
 #include "lexer.hpp" // for Tokens & types
+#include "token_stream.hpp"
+#include "token_store.hpp"
+#include "thread_pool.hpp"
 #include "ast/ast.hpp"
 #include "ast/ast_nodes.hpp"
 #include "errors.hpp"
 #include "exp_parser.hpp"
 
-const Token* peekBack(const std::vector<Token>& tokens, size_t i) {
-    return (i == 0) ? nullptr : &(tokens[i-1]);
-}
-
-const Token* peek(const std::vector<Token>& tokens, size_t i) {
-    return (i+1 == tokens.size()) ? nullptr : &(tokens[i+1]);
+// consumes the next token, which must be of the given type
+const Token& expect(TokenStream& stream, TokenType type) {
+    const Token* pToken = stream.peek();
+    if (pToken == nullptr) throw DTSyntaxException(stream.last().err, stream.last().raw);
+    if (pToken->type != type) throw DTSyntaxException(pToken->err, pToken->raw);
+    return stream.next();
 }
 
 // for function definitions
-ASTNode* parseFunction(const std::vector<Token>& tokens, size_t start, size_t endParen, size_t endBrace) {
-    ASTFunction* pNode = new ASTFunction(tokens[start+1].raw, tokens[start]); // name & return type
-    
+ASTNode* parseFunction(TokenStream& stream, ASTArena& arena) {
+    const Token typeToken = stream.next();
+    const Token nameToken = stream.next();
+    ASTFunction* pNode = arena.make<ASTFunction>(nameToken.symbol, typeToken, arena); // name & return type
+
     // extract params between parenthesis
-    std::vector<std::pair<std::string, TokenType>> params; // name & param type
-    for (size_t i = start+3; i < endParen; i += 3) {
+    stream.next(); // (
+    while (true) {
+        const Token* pToken = stream.peek();
+        if (pToken == nullptr) throw DTUnclosedGroupException(nameToken.err);
+        if (pToken->type == RPAREN) break;
+
         // verify typename, name, and comma are present
-        if (!isTokenPrimitiveType(tokens[i].type))
-            throw DTSyntaxException(tokens[i].err, tokens[i].raw);
-        if (tokens[i+1].type != IDENTIFIER)
-            throw DTSyntaxException(tokens[i+1].err, tokens[i+1].raw);
-        if (i+2 != endParen && tokens[i+2].type != COMMA)
-            throw DTSyntaxException(tokens[i+2].err, tokens[i+2].raw);
-
-        pNode->appendParam({tokens[i+1].raw, tokens[i].type}); // append param
+        if (!isTokenPrimitiveType(pToken->type))
+            throw DTSyntaxException(pToken->err, pToken->raw);
+        const TokenType paramType = stream.next().type;
+
+        pToken = stream.peek();
+        if (pToken == nullptr) throw DTUnclosedGroupException(nameToken.err);
+        if (pToken->type != IDENTIFIER)
+            throw DTSyntaxException(pToken->err, pToken->raw);
+        pNode->appendParam({stream.next().symbol, paramType}); // append param
+
+        pToken = stream.peek();
+        if (pToken == nullptr) throw DTUnclosedGroupException(nameToken.err);
+        if (pToken->type != RPAREN) expect(stream, COMMA);
     }
+    stream.next(); // )
 
-    parse(tokens, endParen+2, endBrace-1, pNode); // parse body (ignore braces)
+    // parse body
+    const Token openBrace = expect(stream, LBRACE);
+    parse(stream, pNode, arena);
+    if (stream.atEnd()) throw DTUnclosedGroupException(openBrace.err);
+    stream.next(); // }
     return pNode;
 }
 
 // for variable declarations
-ASTNode* parseDeclaration(const std::vector<Token>& tokens, size_t start, size_t end) {
-    ASTNode* pNode = new ASTVariable(tokens[start+1].raw, tokens[start]);
-    pNode->push( parseExpresion(tokens, start+3, end) ); // parse subsequent expression w/o end semi
+ASTNode* parseDeclaration(TokenStream& stream, ASTArena& arena) {
+    const Token typeToken = stream.next();
+    ASTNode* pNode = arena.make<ASTVariable>(stream.next().symbol, typeToken, arena);
+    stream.next(); // =
+    pNode->push( parseExpresion(stream, arena) ); // parse subsequent expression w/o end semi
+    expect(stream, SEMICOLON);
     return pNode;
 }
 
 // for parsing a return & its expression
-ASTNode* parseReturn(const std::vector<Token>& tokens, size_t start, size_t end) {
-    ASTReturn* pNode = new ASTReturn(tokens[start]);
-    try {
-        pNode->push(parseExpresion(tokens, start+1, end-1)); // parse subsequent expression w/o end semi
-    } catch (DTException& e) {
-        delete pNode;
-        throw;
-    }
+ASTNode* parseReturn(TokenStream& stream, ASTArena& arena) {
+    const Token returnToken = stream.next();
+    ASTReturn* pNode = arena.make<ASTReturn>(returnToken, arena);
+    const Token* pNext = stream.peek();
+    if (pNext != nullptr && pNext->type != SEMICOLON)
+        pNode->push(parseExpresion(stream, arena)); // parse subsequent expression w/o end semi
+
+    // handle missing semicolon
+    if (stream.atEnd()) throw DTSyntaxException(returnToken.err, returnToken.raw);
+    expect(stream, SEMICOLON);
+    return pNode;
+}
+
+// for expressions evaluated for their side effects (ex. x += 2;)
+ASTNode* parseExpressionStatement(TokenStream& stream, ASTArena& arena) {
+    ASTNode* pNode = parseExpresion(stream, arena);
+    if (stream.atEnd()) throw DTSyntaxException(stream.last().err, stream.last().raw);
+    expect(stream, SEMICOLON);
     return pNode;
 }
 
 // master parse method, calls other specific methods based on tokens present & their semantic validity
-void parse(const std::vector<Token>& tokens, size_t start, size_t end, ASTNode* pHead) {
-    try {
-        for (size_t i = start; i <= end; i++) {
-            const Token* pNext = peek(tokens, i);
-            const Token& token = tokens[i];
-            switch (tokens[i].type) {
-                case TokenType::TYPE_BOOL: case TokenType::TYPE_CHAR: case TokenType::TYPE_DOUBLE:
-                case TokenType::TYPE_INT: case TokenType::TYPE_STR: {
-                    // check for identifier after
-                    const Token* pNextNext = peek(tokens, i+1);
-                    if (pNext == nullptr || pNext->type != IDENTIFIER) throw DTSyntaxException(token.err, token.raw);
-                    
-                    // check for either function or variable declaration
-                    bool isFunction = false;
-                    if (pNextNext == nullptr) throw DTSyntaxException(pNext->err, pNext->raw);
-                    else if (pNextNext->type == LPAREN) isFunction = true;
-                    else if (pNextNext->type != ASSIGN) throw DTSyntaxException(pNext->err, pNext->raw);
-                    
-                    if (isFunction) {
-                        // find closing parenthesis )
-                        size_t parensOpen = 0, start = i;
-                        i += 2; // skip type & identifier
-                        do {
-                            if (tokens[i].type == RPAREN) parensOpen--;
-                            else if (tokens[i].type == LPAREN) parensOpen++;
-                            i++;
-                        } while (i <= end && parensOpen > 0);
-                        size_t endParen = i-1;
-
-                        if (parensOpen > 0)
-                            throw DTUnclosedGroupException(pNext->err);
-                        else if (i <= end && tokens[i].type != LBRACE)
-                            throw DTSyntaxException(tokens[i].err, tokens[i].raw);
-
-                        // find closing brace }
-                        size_t bracesOpen = 0;
-                        do {
-                            if (tokens[i].type == RBRACE) bracesOpen--;
-                            else if (tokens[i].type == LBRACE) bracesOpen++;
-                            i++;
-                        } while (i <= end && bracesOpen > 0);
-                        size_t endBrace = i-1;
-
-                        if (bracesOpen > 0) throw DTUnclosedGroupException(tokens[endParen+1].err);
-
-                        // parse as function
-                        pHead->push(parseFunction(tokens, start, endParen, endBrace));
-                    } else {
-                        // look for terminating semicolon
-                        size_t start = i;
-                        i += 2; // skip type & identifier
-                        while (i <= end && tokens[i].type != SEMICOLON) i++;
-
-                        if (i > end)
-                            throw DTSyntaxException(tokens[i-1].err, tokens[i-1].raw);
-
-                        // parse as variable declaration
-                        pHead->push(parseDeclaration(tokens, start, i-1));
-                    }
-                    break;
-                }
-                case TokenType::RETURN: {
-                    // find closing semicolon
-                    size_t start = i;
-                    while (i <= end && tokens[i].type != TokenType::SEMICOLON) i++;
-                    if (i > end) throw DTSyntaxException(tokens[start].err, tokens[start].raw); // handle missing semicolon
-                    pHead->push(parseReturn(tokens, start, i));
-                    break;
-                }
-                default: break; // TODO: suppress compiler errors
+// parses statements into pHead until the stream ends or an unmatched } is reached (left unconsumed)
+void parse(TokenStream& stream, ASTNode* pHead, ASTArena& arena) {
+    const Token* pToken;
+    while ((pToken = stream.peek()) != nullptr) {
+        const Token& token = *pToken;
+        switch (token.type) {
+            case TokenType::TYPE_BOOL: case TokenType::TYPE_CHAR: case TokenType::TYPE_DOUBLE:
+            case TokenType::TYPE_INT: case TokenType::TYPE_STR: {
+                // check for identifier after
+                const Token* pNext = stream.peek(1);
+                if (pNext == nullptr || pNext->type != IDENTIFIER) throw DTSyntaxException(token.err, token.raw);
+
+                // check for either function or variable declaration
+                const Token* pNextNext = stream.peek(2);
+                if (pNextNext == nullptr) throw DTSyntaxException(pNext->err, pNext->raw);
+                else if (pNextNext->type == LPAREN) pHead->push(parseFunction(stream, arena));
+                else if (pNextNext->type == ASSIGN) pHead->push(parseDeclaration(stream, arena));
+                else throw DTSyntaxException(pNext->err, pNext->raw);
+                break;
             }
+            case TokenType::RETURN:
+                pHead->push(parseReturn(stream, arena));
+                break;
+            case TokenType::IDENTIFIER: case TokenType::OP_INC: case TokenType::OP_DEC:
+                pHead->push(parseExpressionStatement(stream, arena));
+                break;
+            case TokenType::IF: case TokenType::ELIF: case TokenType::ELSE: case TokenType::WHILE: case TokenType::FOR:
+                throw DTUnsupportedException(token.err, token.raw); // rather than dropping their bodies
+            case TokenType::RBRACE: return; // end of the enclosing block
+            case TokenType::LPAREN: case TokenType::LBRACKET: case TokenType::LBRACE:
+                throw DTSyntaxException(token.err, token.raw); // no statement starts w/ a group
+            default: stream.next(); break; // TODO: suppress compiler errors
         }
-    } catch (DTException& e) {
-        delete pHead;
-        throw;
     }
 }
 
-AST* buildAST(const std::vector<Token>& tokens) {
-    ASTNode* pHead = new ASTNode({TokenType::IDENTIFIER, "", {0, 1, 0}});
-    AST* ast = new AST( pHead );
+// a failed parse frees every node made so far along with the AST's arena
+AST* buildAST(TokenStream& stream) {
+    AST* ast = new AST();
+    ast->pRoot = ast->arena.make<ASTNode>(Token{TokenType::IDENTIFIER, "", {0, 0}, SYMBOL_NONE, {}}, ast->arena);
     try {
-        parse(tokens, 0, tokens.size()-1, pHead);
+        parse(stream, ast->pRoot, ast->arena);
+
+        // a } left over at the top level has no opening brace
+        if (!stream.atEnd()) {
+            const Token& token = *stream.peek();
+            throw DTSyntaxException(token.err, token.raw);
+        }
     } catch (DTException& e) {
-        ast->pRoot = nullptr; // parse function already deletes pHead, so just delete the AST
         delete ast;
         throw;
     }
     return ast;
+}
+
+// returns the end of the function definition starting at token i, or i if there isn't one
+// (ex. TYPE IDENTIFIER ( ... ) { ... }), the store's groups must be matched
+static size_t functionEnd(const TokenStore& tokens, size_t i) {
+    const size_t len = tokens.size();
+    if (i + 2 >= len || !isTokenPrimitiveType(tokens.type(i)) ||
+        tokens.type(i+1) != IDENTIFIER || tokens.type(i+2) != LPAREN)
+        return i;
+    const size_t bodyStart = tokens.match(i+2) + 1;
+    if (bodyStart >= len || tokens.type(bodyStart) != LBRACE) return i;
+    return tokens.match(bodyStart) + 1;
+}
+
+// parses top-level definitions on the pool, the tokens are cut into batches of whole
+// definitions (found in O(1) each through the bracket table) that are parsed like any other
+// token range into their own arenas, then attached to the root in source order
+// if any batch fails the whole file is parsed again on this thread, so the error reported is
+// always the first one in source order, exactly as if it had been parsed serially
+AST* buildAST(const TokenStore& tokens, ThreadPool& pool) {
+    const size_t len = tokens.size();
+    if (pool.size() == 1) {
+        StoreTokenStream stream(tokens);
+        return buildAST(stream);
+    }
+
+    // 1. find where the batches may be cut, which is only around function definitions
+    // (anything else is kept with its neighbors, groups are skipped so only the top level is cut)
+    const size_t targetSize = len / (pool.size() * PARSE_BATCHES_PER_THREAD) + 1;
+    std::vector<size_t> cuts = {0};
+    for (size_t i = 0; i < len;) {
+        const size_t end = functionEnd(tokens, i);
+        if (end != i) {
+            if (i - cuts.back() >= targetSize) cuts.push_back(i);
+            if (end - cuts.back() >= targetSize) cuts.push_back(end);
+            i = end;
+        } else {
+            i = isTokenGroupOpen(tokens.type(i)) ? tokens.match(i) + 1 : i + 1;
+        }
+    }
+    if (cuts.back() != len) cuts.push_back(len);
+
+    // 2. parse each batch into a head node of its own
+    AST* ast = new AST();
+    ast->pRoot = ast->arena.make<ASTNode>(Token{TokenType::IDENTIFIER, "", {0, 0}, SYMBOL_NONE, {}}, ast->arena);
+
+    const size_t numBatches = cuts.size() - 1;
+    std::vector<ASTArena*> arenas;
+    for (size_t i = 0; i < numBatches; i++)
+        arenas.push_back(&ast->addArena());
+    std::vector<ASTNode*> heads(numBatches, nullptr);
+    std::vector<uint8_t> isFailed(numBatches, false); // not vector<bool>, batches write their own slot concurrently
+    std::vector<std::exception_ptr> errors(numBatches); // anything else a batch threw (ex. bad_alloc), tasks mustn't throw
+
+    pool.run(numBatches, [&](size_t b) {
+        ASTArena& arena = *arenas[b];
+        try {
+            StoreTokenStream stream(tokens, cuts[b], cuts[b+1]);
+            ASTNode* pHead = arena.make<ASTNode>(Token{TokenType::IDENTIFIER, "", {0, 0}, SYMBOL_NONE, {}}, arena);
+            parse(stream, pHead, arena);
+            if (stream.atEnd()) heads[b] = pHead; // stopping early means a stray }
+            else isFailed[b] = true;
+        } catch (DTException& e) {
+            isFailed[b] = true;
+        } catch (...) {
+            errors[b] = std::current_exception();
+        }
+    });
+
+    // 3. report errors the way a serial parse would, after anything that wasn't a syntax error
+    for (size_t b = 0; b < numBatches; b++) {
+        if (errors[b]) {
+            delete ast;
+            std::rethrow_exception(errors[b]);
+        }
+    }
+    for (size_t b = 0; b < numBatches; b++) {
+        if (isFailed[b]) {
+            delete ast;
+            StoreTokenStream stream(tokens);
+            return buildAST(stream);
+        }
+    }
+
+    // 4. stitch
+    for (ASTNode* pHead : heads)
+        for (size_t i = 0; i < pHead->size(); i++)
+            ast->pRoot->push(pHead->at(i));
+    return ast;
 }
\ No newline at end of file
@@ -1,16 +1,23 @@
 #ifndef __PARSER_HPP
 #define __PARSER_HPP
 
-#include <vector>
-
 #include "lexer.hpp" // for Tokens & types
+#include "token_stream.hpp"
+#include "token_store.hpp"
 #include "ast/ast.hpp"
 #include "ast/ast_nodes.hpp"
 
+// top-level definitions are split into this many batches per thread when parsing in parallel
+#define PARSE_BATCHES_PER_THREAD 4
+
+class ThreadPool; // thread_pool.hpp
+
 // external methods
-AST* buildAST(const std::vector<Token>&);
+AST* buildAST(TokenStream&);
+AST* buildAST(const TokenStore&, ThreadPool&);
 
 // internal use methods
-void parse(const std::vector<Token>&, size_t, size_t, ASTNode*);
+void parse(TokenStream&, ASTNode*, ASTArena&);
+const Token& expect(TokenStream&, TokenType);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,274 @@
+#include <string>
+
+#include "semantics.hpp"
+#include "errors.hpp"
+#include "ast/ast_visitor.hpp"
+
+/************* SCOPES *************/
+
+void SymbolScopes::pop() {
+    const size_t start = scopeStarts.back();
+    scopeStarts.pop_back();
+    while (shadowed.size() > start) {
+        const Shadowed& entry = shadowed.back();
+        if (entry.isShadowing) symbols.insert(entry.name, entry.previous);
+        else symbols.erase(entry.name);
+        shadowed.pop_back();
+    }
+}
+
+bool SymbolScopes::declare(symbol_t name, TokenType type, slot_t slot) {
+    SymbolInfo* pPrevious = symbols.find(name);
+    if (pPrevious != nullptr && pPrevious->depth == depth()) return false;
+
+    if (pPrevious != nullptr) shadowed.push_back({name, true, *pPrevious});
+    else shadowed.push_back({name, false, {}});
+    symbols.insert(name, {type, slot, depth()});
+    return true;
+}
+
+/************* TYPES *************/
+
+const char* getTypeName(const TokenType type) {
+    switch (type) {
+        case TYPE_INT: return "int";
+        case TYPE_DOUBLE: return "double";
+        case TYPE_CHAR: return "char";
+        case TYPE_BOOL: return "bool";
+        case TYPE_STR: return "string";
+        default: return "?";
+    }
+}
+
+// true if a value of type from can be stored in a variable of type to w/o a cast
+bool isTypeAssignable(const TokenType to, const TokenType from) {
+    return to == from || (to == TYPE_DOUBLE && (from == TYPE_INT || from == TYPE_CHAR)) ||
+           (to == TYPE_INT && (from == TYPE_CHAR || from == TYPE_BOOL)) || (to == TYPE_CHAR && from == TYPE_INT);
+}
+
+static inline bool isTypeNumeric(const TokenType type) {
+    return type == TYPE_INT || type == TYPE_DOUBLE || type == TYPE_CHAR;
+}
+
+static inline bool isTypeIntegral(const TokenType type) {
+    return type == TYPE_INT || type == TYPE_CHAR;
+}
+
+// the binary operator a compound assignment applies (ex. OP_ADD for +=), the token itself if none
+TokenType getCompoundOp(const TokenType type) {
+    switch (type) {
+        case ASSIGN_ADD: return OP_ADD;
+        case ASSIGN_SUB: return OP_SUB;
+        case ASSIGN_MUL: return OP_MUL;
+        case ASSIGN_DIV: return OP_DIV;
+        case ASSIGN_MOD: return OP_MOD;
+        case ASSIGN_LSHIFT: return OP_LSHIFT;
+        case ASSIGN_RSHIFT: return OP_RSHIFT;
+        case ASSIGN_BIT_OR: return OP_BIT_OR;
+        case ASSIGN_BIT_AND: return OP_BIT_AND;
+        case ASSIGN_BIT_XOR: return OP_BIT_XOR;
+        default: return type;
+    }
+}
+
+// result type of a binary operator, TYPE_* or IDENTIFIER if the operands don't fit it
+static TokenType getBinaryResultType(const TokenType op, const TokenType left, const TokenType right) {
+    switch (op) {
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV:
+            if (!isTypeNumeric(left) || !isTypeNumeric(right)) break;
+            return left == TYPE_DOUBLE || right == TYPE_DOUBLE ? TYPE_DOUBLE : TYPE_INT;
+        case OP_MOD: case OP_LSHIFT: case OP_RSHIFT: case OP_BIT_OR: case OP_BIT_AND: case OP_BIT_XOR:
+            if (!isTypeIntegral(left) || !isTypeIntegral(right)) break;
+            return TYPE_INT;
+        case OP_LT: case OP_LTE: case OP_GT: case OP_GTE:
+            if (!isTypeNumeric(left) || !isTypeNumeric(right)) break;
+            return TYPE_BOOL;
+        case OP_EQ: case OP_NEQ:
+            if ((isTypeNumeric(left) && isTypeNumeric(right)) || (left == right))
+                return TYPE_BOOL;
+            break;
+        case OP_BOOL_AND: case OP_BOOL_OR:
+            if ((left != TYPE_BOOL && !isTypeIntegral(left)) || (right != TYPE_BOOL && !isTypeIntegral(right))) break;
+            return TYPE_BOOL;
+        default: break;
+    }
+    return IDENTIFIER;
+}
+
+/************* CHECKER *************/
+
+// each handler checks its subtree & returns the type of the value it evaluates to
+// expressions are the exception, visitExpr() walks them through dispatchPostorder(), their
+// handlers only check one node & find their operands' types in pChildResults
+class SemanticChecker : public ASTVisitor<SemanticChecker, TokenType> {
+    public:
+        SemanticChecker(const SymbolMap<ASTFunction*>& functions) : functions(functions) {};
+
+        // the root, every top-level declaration is a global
+        TokenType visitNode(ASTNode& root) {
+            scopes.push();
+            for (size_t i = 0; i < root.size(); i++) {
+                if (root.at(i)->nodeType() == ASTNodeType::EXPR)
+                    throw DTSemanticException(root.at(i)->err, "Expressions can only be evaluated inside functions");
+                dispatch(*root.at(i));
+            }
+            scopes.pop();
+            return TYPE_INT;
+        };
+
+        TokenType visitFunction(ASTFunction& func) {
+            if (pFunction != nullptr)
+                throw DTSemanticException(func.err, "Functions can't be defined inside other functions");
+            pFunction = &func;
+            nextLocal = 0;
+
+            scopes.push();
+            for (const param_t& param : func.getParams())
+                if (!scopes.declare(param.first, param.second, nextLocal++))
+                    throw DTSemanticException(func.err, "Duplicate parameter '" + std::string(SymbolTable::name(param.first)) + '\'');
+            visitChildren(func);
+            scopes.pop();
+
+            func.numSlots = nextLocal;
+            pFunction = nullptr;
+            return func.getReturnType();
+        };
+
+        TokenType visitVariable(ASTVariable& var) {
+            // the initializer can't see the variable it's initializing
+            const TokenType initType = dispatch(*var.at(0));
+            if (!isTypeAssignable(var.getType(), initType))
+                throw DTSemanticException(var.at(0)->err, std::string("Cannot assign ") + getTypeName(initType) + " to " + getTypeName(var.getType()));
+
+            var.slot = pFunction != nullptr ? nextLocal++ : (nextGlobal++ | SLOT_GLOBAL_FLAG);
+            if (!scopes.declare(var.getName(), var.getType(), var.slot))
+                throw DTSemanticException(var.err, "Redeclaration of '" + std::string(SymbolTable::name(var.getName())) + '\'');
+            return var.getType();
+        };
+
+        TokenType visitReturn(ASTReturn& ret) {
+            if (pFunction == nullptr)
+                throw DTSemanticException(ret.err, "Return outside of a function");
+            const TokenType returnType = pFunction->getReturnType();
+            if (ret.size() > 0) {
+                const TokenType type = dispatch(*ret.at(0));
+                if (!isTypeAssignable(returnType, type))
+                    throw DTSemanticException(ret.at(0)->err, std::string("Cannot return ") + getTypeName(type) + " from a function returning " + getTypeName(returnType));
+            }
+            return returnType;
+        };
+
+        // wrapper around a whole expression, every node is visited after its operands
+        TokenType visitExpr(ASTExpr& expr) {
+            expr.valueType = dispatchPostorder(*expr.at(0));
+            return expr.valueType;
+        };
+
+        TokenType visitIdentifier(ASTIdentifier& identifier) {
+            const SymbolInfo* pInfo = scopes.lookup(identifier.getName());
+            if (pInfo == nullptr)
+                throw DTSemanticException(identifier.err, "Undeclared identifier '" + std::string(identifier.raw) + '\'');
+            identifier.valueType = pInfo->type;
+            identifier.slot = pInfo->slot;
+            return pInfo->type;
+        };
+
+        TokenType visitUnaryExpr(ASTUnaryExpr& expr) {
+            const TokenType type = pChildResults[0];
+            TokenType result = IDENTIFIER;
+            switch (expr.opType()) {
+                case OP_ADD: case OP_SUB:
+                    if (isTypeNumeric(type)) result = type == TYPE_DOUBLE ? TYPE_DOUBLE : TYPE_INT;
+                    break;
+                case OP_BOOL_NOT:
+                    if (type == TYPE_BOOL || isTypeIntegral(type)) result = TYPE_BOOL;
+                    break;
+                case OP_BIT_NOT:
+                    if (isTypeIntegral(type)) result = TYPE_INT;
+                    break;
+                case OP_INC: case OP_DEC:
+                    if (isTypeNumeric(type)) result = type;
+                    break;
+                default: break;
+            }
+            if (result == IDENTIFIER)
+                throw DTSemanticException(expr.err, "Operator '" + std::string(expr.raw) + "' can't be applied to " + getTypeName(type));
+            expr.valueType = result;
+            return result;
+        };
+
+        TokenType visitBinExpr(ASTBinExpr& expr) {
+            const TokenType left = pChildResults[0], right = pChildResults[1];
+            const TokenType op = expr.opType();
+
+            TokenType result;
+            if (op == ASSIGN) {
+                result = isTypeAssignable(left, right) ? left : IDENTIFIER;
+            } else if (isTokenAssignOp(op)) { // compound, the result has to fit back into the left
+                const TokenType binaryOp = getCompoundOp(op);
+                result = binaryOp != op && isTypeAssignable(left, getBinaryResultType(binaryOp, left, right)) ? left : IDENTIFIER;
+            } else {
+                result = getBinaryResultType(op, left, right);
+            }
+
+            if (result == IDENTIFIER)
+                throw DTSemanticException(expr.err, "Operator '" + std::string(expr.raw) + "' can't be applied to " + getTypeName(left) + " and " + getTypeName(right));
+            expr.valueType = result;
+            return result;
+        };
+
+        TokenType visitCall(ASTCall& call) {
+            ASTFunction* const* ppFunction = functions.find(call.getName());
+            if (ppFunction == nullptr)
+                throw DTSemanticException(call.err, "Undeclared function '" + std::string(call.raw) + '\'');
+            ASTFunction& func = **ppFunction;
+
+            const arena_vector<param_t>& params = func.getParams();
+            if (call.size() != params.size())
+                throw DTSemanticException(call.err, "Function '" + std::string(call.raw) + "' takes " + std::to_string(params.size()) +
+                                                    " arguments, got " + std::to_string(call.size()));
+            for (size_t i = 0; i < call.size(); i++) {
+                const TokenType type = pChildResults[i];
+                if (!isTypeAssignable(params[i].second, type))
+                    throw DTSemanticException(call.at(i)->err, std::string("Cannot pass ") + getTypeName(type) + " as " + getTypeName(params[i].second));
+            }
+
+            call.pFunction = &func;
+            call.valueType = func.getReturnType();
+            return call.valueType;
+        };
+
+        TokenType visitBoolLiteral(ASTBoolLiteral&) { return TYPE_BOOL; };
+        TokenType visitCharLiteral(ASTCharLiteral&) { return TYPE_CHAR; };
+        TokenType visitDoubleLiteral(ASTDoubleLiteral&) { return TYPE_DOUBLE; };
+        TokenType visitIntLiteral(ASTIntLiteral&) { return TYPE_INT; };
+        TokenType visitStringLiteral(ASTStringLiteral&) { return TYPE_STR; };
+        TokenType visitNullLiteral(ASTNullLiteral&) { return TYPE_STR; }; // null is the empty string pointer
+    private:
+        const SymbolMap<ASTFunction*>& functions; // every function by name, calls can come before definitions
+        SymbolScopes scopes;
+        ASTFunction* pFunction = nullptr; // function being checked, nullptr at the top level
+        slot_t nextLocal = 0, nextGlobal = 0;
+};
+
+void checkSemantics(AST& ast, const int fileIndex) {
+    // functions can be called before they're defined, so index them all first
+    SymbolMap<ASTFunction*> functions;
+    const symbol_t mainSymbol = SymbolTable::intern("main");
+    bool hasMain = false;
+    for (size_t i = 0; i < ast.pRoot->size(); i++) {
+        ASTNode* pNode = ast.pRoot->at(i);
+        if (pNode->nodeType() != ASTNodeType::FUNCTION) continue;
+
+        ASTFunction& func = *static_cast<ASTFunction*>(pNode);
+        if (functions.find(func.getName()) != nullptr)
+            throw DTSemanticException(func.err, "Redefinition of function '" + std::string(SymbolTable::name(func.getName())) + '\'');
+        functions.insert(func.getName(), &func);
+        hasMain |= func.getName() == mainSymbol && func.getNumParams() == 0 && func.getReturnType() == TYPE_INT;
+    }
+
+    SemanticChecker checker(functions);
+    checker.dispatch(*ast.pRoot);
+
+    if (!hasMain) throw DTSemanticException({0, fileIndex}, "No int main() function defined");
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef __SEMANTICS_HPP
+#define __SEMANTICS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "lexer.hpp"
+#include "symbols.hpp"
+#include "ast/ast.hpp"
+#include "ast/ast_nodes.hpp"
+
+// what a name in scope refers to
+struct SymbolInfo {
+    TokenType type; // declared type
+    slot_t slot;
+    uint32_t depth; // scope depth it was declared at
+};
+
+// nested scopes over one flat SymbolMap
+// each declaration logs what it shadowed so popping a scope just replays the log backwards,
+// so lookups stay a single probe no matter how deeply scopes are nested
+class SymbolScopes {
+    public:
+        void push() { scopeStarts.push_back(shadowed.size()); };
+        void pop();
+
+        // false if name is already declared in the current scope
+        bool declare(symbol_t name, TokenType type, slot_t slot);
+        const SymbolInfo* lookup(symbol_t name) const { return symbols.find(name); };
+        uint32_t depth() const { return (uint32_t)scopeStarts.size(); };
+    private:
+        struct Shadowed {
+            symbol_t name;
+            bool isShadowing; // false if name wasn't in scope before
+            SymbolInfo previous;
+        };
+
+        SymbolMap<SymbolInfo> symbols;
+        std::vector<Shadowed> shadowed;
+        std::vector<size_t> scopeStarts; // size of shadowed when each open scope was pushed
+};
+
+// type checks the AST & annotates it for codegen, throws a DTSemanticException on the first error
+// every expression gets its value type & every variable (& identifier) its storage slot
+void checkSemantics(AST&, const int fileIndex);
+
+// helpers shared with later passes
+const char* getTypeName(const TokenType);
+bool isTypeAssignable(const TokenType to, const TokenType from);
+TokenType getCompoundOp(const TokenType); // ex. OP_ADD for ASSIGN_ADD
+
+#endif
\ No newline at end of file
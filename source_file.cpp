@@ -0,0 +1,56 @@
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "source_file.hpp"
+
+SourceFile::SourceFile(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        _isOpen = true;
+        len = (size_t)info.st_size;
+
+        // mmap fails on empty files, which are just an empty view anyways
+        if (len == 0) {
+            close(fd);
+            return;
+        }
+
+        void* pMap = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (pMap != MAP_FAILED) {
+            madvise(pMap, len, MADV_SEQUENTIAL); // the lexer makes a single forward pass
+            data = static_cast<const char*>(pMap);
+            isMapped = true;
+            close(fd); // the mapping holds its own reference to the file
+            return;
+        }
+    }
+    close(fd);
+
+    // fallback for anything that can't be mapped, read the whole stream at once
+    std::ifstream inHandle( path, std::ios::binary );
+    if (!inHandle.is_open()) {
+        _isOpen = false;
+        return;
+    }
+
+    std::ostringstream buffer;
+    buffer << inHandle.rdbuf();
+    fallback = buffer.str();
+    data = fallback.data();
+    len = fallback.size();
+    _isOpen = true;
+}
+
+SourceFile::~SourceFile() {
+    if (isMapped)
+        munmap(const_cast<char*>(data), len);
+}
\ No newline at end of file
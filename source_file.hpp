@@ -0,0 +1,29 @@
+#ifndef __SOURCE_FILE_HPP
+#define __SOURCE_FILE_HPP
+
+#include <string>
+#include <string_view>
+
+// read-only view over an entire source file
+// the file is mmap'd once so tokens can reference their text in place instead of copying it,
+// so a SourceFile must outlive every Token (and AST node) created from it
+class SourceFile {
+    public:
+        SourceFile(const std::string& path);
+        ~SourceFile();
+
+        SourceFile(const SourceFile&) = delete;
+        SourceFile& operator=(const SourceFile&) = delete;
+
+        bool isOpen() const { return _isOpen; };
+        std::string_view view() const { return std::string_view(data, len); };
+        size_t size() const { return len; };
+    private:
+        const char* data = nullptr;
+        size_t len = 0;
+        bool _isOpen = false;
+        bool isMapped = false; // false if the contents were read into fallback instead
+        std::string fallback; // for files that can't be mapped (ex. pipes)
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "symbols.hpp"
+
+#define SYMBOL_BLOCK_SIZE 65536
+
+std::unordered_map<std::string_view, symbol_t> SymbolTable::ids = {{"", SYMBOL_NONE}};
+std::vector<std::string_view> SymbolTable::names = {""};
+std::vector<std::unique_ptr<char[]>> SymbolTable::blocks = std::vector<std::unique_ptr<char[]>>();
+char* SymbolTable::pBlock = nullptr;
+size_t SymbolTable::blockUsed = 0;
+
+symbol_t SymbolTable::intern(std::string_view str) {
+    auto it = ids.find(str);
+    if (it != ids.end()) return it->second;
+
+    // copy the name into stable storage so it outlives the source buffer
+    const std::string_view name = store(str);
+    const symbol_t id = (symbol_t)names.size();
+    names.push_back(name);
+    ids.emplace(name, id);
+    return id;
+}
+
+// copies str into the current block, names are packed together instead of allocated one by one
+std::string_view SymbolTable::store(std::string_view str) {
+    const size_t len = str.size();
+    char* pDest;
+    if (len > SYMBOL_BLOCK_SIZE / 4) { // big names get a block to themselves
+        blocks.push_back(std::make_unique<char[]>(len));
+        pDest = blocks.back().get();
+    } else {
+        if (pBlock == nullptr || blockUsed + len > SYMBOL_BLOCK_SIZE) {
+            blocks.push_back(std::make_unique<char[]>(SYMBOL_BLOCK_SIZE));
+            pBlock = blocks.back().get();
+            blockUsed = 0;
+        }
+        pDest = pBlock + blockUsed;
+        blockUsed += len;
+    }
+    std::memcpy(pDest, str.data(), len);
+    return std::string_view(pDest, len);
+}
+
+symbol_t SymbolBatch::intern(std::string_view str) {
+    auto it = ids.find(str);
+    if (it != ids.end()) return it->second;
+
+    const symbol_t id = (symbol_t)names.size();
+    names.push_back(str);
+    ids.emplace(str, id);
+    return id;
+}
+
+std::vector<symbol_t> SymbolBatch::commit() const {
+    std::vector<symbol_t> globalIds;
+    globalIds.reserve(names.size());
+    for (const std::string_view name : names)
+        globalIds.push_back(SymbolTable::intern(name));
+    return globalIds;
+}
\ No newline at end of file
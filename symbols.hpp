@@ -0,0 +1,112 @@
+#ifndef __SYMBOLS_HPP
+#define __SYMBOLS_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+typedef uint32_t symbol_t;
+
+#define SYMBOL_NONE 0 // id of the empty string, used for tokens that aren't identifiers
+
+// compiler-wide string interner
+// the lexer interns every identifier once, after which names are passed around & compared as ids
+class SymbolTable {
+    public:
+        static symbol_t intern(std::string_view);
+        static std::string_view name(symbol_t id) { return names[id]; };
+        static size_t size() { return names.size(); };
+    private:
+        static std::string_view store(std::string_view);
+
+        static std::unordered_map<std::string_view, symbol_t> ids;
+        static std::vector<std::string_view> names; // indexed by id, views into blocks
+        static std::vector<std::unique_ptr<char[]>> blocks; // backing storage for every name
+        static char* pBlock; // block that small names are currently packed into
+        static size_t blockUsed;
+};
+
+// flat open-addressing hash map keyed by symbol id (linear probing, SYMBOL_NONE marks empty slots)
+// lookups touch one contiguous array instead of chasing std::unordered_map's bucket lists
+template <typename V>
+class SymbolMap {
+    public:
+        SymbolMap() : entries(16) {};
+
+        V* find(symbol_t key) {
+            for (size_t i = indexOf(key);; i = (i + 1) & mask()) {
+                if (entries[i].key == key) return &entries[i].value;
+                if (entries[i].key == SYMBOL_NONE) return nullptr;
+            }
+        };
+        const V* find(symbol_t key) const { return const_cast<SymbolMap*>(this)->find(key); };
+
+        // inserts or overwrites key's value
+        V& insert(symbol_t key, const V& value) {
+            if ((count + 1) * 4 > entries.size() * 3) grow(); // keep the load under 75%
+            size_t i = indexOf(key);
+            while (entries[i].key != SYMBOL_NONE && entries[i].key != key) i = (i + 1) & mask();
+            if (entries[i].key == SYMBOL_NONE) count++;
+            entries[i] = {key, value};
+            return entries[i].value;
+        };
+
+        // removes key, shifting later entries of its probe run back so no tombstones are needed
+        void erase(symbol_t key) {
+            size_t i = indexOf(key);
+            while (entries[i].key != key) {
+                if (entries[i].key == SYMBOL_NONE) return;
+                i = (i + 1) & mask();
+            }
+            for (size_t j = (i + 1) & mask(); entries[j].key != SYMBOL_NONE; j = (j + 1) & mask()) {
+                const size_t home = indexOf(entries[j].key);
+                // move j into the hole at i unless its home slot lies cyclically in (i, j]
+                if (((j - home) & mask()) >= ((j - i) & mask())) {
+                    entries[i] = entries[j];
+                    i = j;
+                }
+            }
+            entries[i].key = SYMBOL_NONE;
+            count--;
+        };
+
+        size_t size() const { return count; };
+        void clear() { entries.assign(entries.size(), Entry()); count = 0; };
+    private:
+        struct Entry {
+            symbol_t key = SYMBOL_NONE;
+            V value = V();
+        };
+
+        size_t mask() const { return entries.size() - 1; };
+        size_t indexOf(symbol_t key) const { return (size_t)((key * 2654435769u) >> 7) & mask(); }; // Fibonacci hash
+
+        void grow() {
+            std::vector<Entry> old( entries.size() * 2 );
+            old.swap(entries);
+            count = 0;
+            for (const Entry& entry : old)
+                if (entry.key != SYMBOL_NONE) insert(entry.key, entry.value);
+        };
+
+        std::vector<Entry> entries; // size is always a power of 2
+        size_t count = 0;
+};
+
+// interner local to one thread, for lexing chunks of a file in parallel
+// ids are only meaningful within the batch until commit() folds its names into the SymbolTable
+class SymbolBatch {
+    public:
+        symbol_t intern(std::string_view);
+
+        // interns every name in the order it was first seen & returns the global id of each local id
+        // batches committed in source order give the same ids as interning the file serially
+        std::vector<symbol_t> commit() const;
+    private:
+        std::unordered_map<std::string_view, symbol_t> ids = {{"", SYMBOL_NONE}};
+        std::vector<std::string_view> names = {""}; // views into the source, copied by commit()
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../lexer.hpp"
+#include "../lexer_simd.hpp"
+#include "../errors.hpp"
+
+#define MAX_REPORTED 20 // mismatches printed in full, the rest are only counted
+
+// lexes a corpus at every LexSIMDLevel the host supports & checks that each gives exactly the
+// token stream (or error) the scalar kernels do
+// the corpus is built around the 16 & 32 byte steps of the vector kernels, so every run
+// (whitespace, identifiers, comments, string contents) ends at each position within a step
+
+// everything lexing one input produced
+struct LexResult {
+    std::vector<Token> tokens;
+    std::string error; // message of the exception that stopped lexing, empty if there wasn't one
+};
+
+static LexResult lex(std::string_view src, LexSIMDLevel level, int fileIndex) {
+    setLexSIMDLevel(level); // kernels are picked when the lexer is made
+    Lexer lexer(src, fileIndex);
+    LexResult result;
+    try {
+        Token token;
+        while (lexer.next(token))
+            result.tokens.push_back(token);
+    } catch (DTException& e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+static bool isSameToken(const Token& a, const Token& b) {
+    if (a.type != b.type || a.raw.data() != b.raw.data() || a.raw.size() != b.raw.size() ||
+        a.err.offset != b.err.offset || a.symbol != b.symbol) return false;
+    switch (a.type) {
+        case LIT_INT: return a.value.i == b.value.i;
+        case LIT_DOUBLE: return std::memcmp(&a.value.d, &b.value.d, sizeof(double)) == 0;
+        case LIT_CHAR: return a.value.c == b.value.c;
+        case LIT_BOOL: return a.value.b == b.value.b;
+        default: return true;
+    }
+}
+
+// src w/ control chars & non-ASCII bytes escaped, for failure messages
+static std::string printable(std::string_view src) {
+    std::string out;
+    for (const unsigned char c : src) {
+        if (c == '\n') out += "\\n";
+        else if (c == '\\') out += "\\\\";
+        else if (c >= ' ' && c < 0x7F) out += (char)c;
+        else {
+            const char* const HEX = "0123456789abcdef";
+            out += "\\x";
+            out += HEX[c >> 4];
+            out += HEX[c & 0xF];
+        }
+    }
+    return out;
+}
+
+// runs of each kind the kernels scan, placed at every offset within a vector step
+static void addBoundaryCases(std::vector<std::string>& corpus) {
+    const char SPACES[] = " \t\r\n\v\f";
+    for (size_t pad = 0; pad <= 66; pad++) {
+        const std::string spaces(pad, ' ');
+        const std::string ident = "x" + std::string(pad, 'a');
+        std::string mixedSpace;
+        for (size_t i = 0; i < pad; i++) mixedSpace += SPACES[i % 6];
+        std::string mixedIdent = "_";
+        for (size_t i = 0; i < pad; i++) mixedIdent += "zAZ09_$aq"[i % 9];
+
+        // identifiers & keywords ending in each position, w/ & w/o anything after them
+        corpus.push_back(ident);
+        corpus.push_back(ident + "+1;");
+        corpus.push_back(spaces + mixedIdent + "(int)");
+        corpus.push_back("int " + ident + " = " + mixedIdent + ";\n");
+
+        // whitespace runs
+        corpus.push_back(mixedSpace);
+        corpus.push_back(mixedSpace + "return");
+        corpus.push_back("a" + spaces + "b" + mixedSpace + "c");
+
+        // comments running up to a newline or the end of the file
+        corpus.push_back("# " + ident);
+        corpus.push_back("#" + spaces + "\"\\ '\n" + ident);
+        corpus.push_back(spaces + "# comment" + std::string(pad, '#') + "\nint x = 1;");
+
+        // string contents w/ a quote, backslash or newline at each position
+        const std::string text(pad, 'q');
+        corpus.push_back('"' + text + '"');
+        corpus.push_back('"' + text + "\\\"" + text + '"');
+        corpus.push_back('"' + text + "\\\\\" + " + ident);
+        corpus.push_back("string s = \"" + text + "\\n\\t" + spaces + "\";");
+        corpus.push_back('"' + text + "\\" + text + "\\" + '"'); // escaped quote, so unclosed
+        corpus.push_back('"' + text + '\n' + "\"x\""); // newline, so unclosed
+        corpus.push_back('"' + text + '\\'); // backslash at the end of the file
+        corpus.push_back(spaces + "'a' '\\n' \"" + text + "\" '" + (char)('a' + pad % 26) + '\'');
+    }
+}
+
+// a small program, once as written & once on a single line
+static void addProgramCases(std::vector<std::string>& corpus) {
+    const std::string program =
+        "# sums a few things\n"
+        "int $counter_1 = 0;\n"
+        "string greeting = \"Hello, \\\"World\\\"!\\n\\tescaped \\\\ backslash # not a comment\";\n"
+        "double ratio = 1.25;\n"
+        "int main() {\n"
+        "\tint aVeryLongIdentifierThatCrossesSeveralVectorSteps_0123456789 = 40 << 2;\n"
+        "    char c = '\\''; char d = 'x'; bool b = true && !false;\n"
+        "    aVeryLongIdentifierThatCrossesSeveralVectorSteps_0123456789 >>= 1; # shift\r\n"
+        "    return aVeryLongIdentifierThatCrossesSeveralVectorSteps_0123456789 % 7 != 2;\n"
+        "}\n";
+    corpus.push_back(program);
+    std::string oneLine = program;
+    for (char& c : oneLine)
+        if (c == '\n') c = ' ';
+    corpus.push_back(oneLine);
+}
+
+// random mixes of the chars the lexer cares about, including bytes >= 0x80 which the
+// vector kernels compare unsigned
+static void addRandomCases(std::vector<std::string>& corpus) {
+    static const char* const PIECES[] = {
+        "a", "Z", "_", "$", "q9", "return", "int", " ", "  ", "\t", "\n", "\r\n", "#", "\"", "\\",
+        "\\\"", "'", "'a'", "'\\n'", "1", "2.5", ".5", "+", "<<=", "!=", "&&", ";", "(", ")", "{", "}",
+        "\x80", "\xC0", "\xE9", "\xFF", "\x7F"
+    };
+    const size_t numPieces = sizeof(PIECES) / sizeof(PIECES[0]);
+    std::mt19937 rng(2024); // fixed so failures reproduce
+    for (int n = 0; n < 4000; n++) {
+        std::string src;
+        const size_t numParts = rng() % 120;
+        for (size_t i = 0; i < numParts; i++) {
+            // mostly long runs of one kind so the vector loops get to step
+            const char* pPiece = PIECES[rng() % numPieces];
+            const size_t repeats = rng() % 4 == 0 ? rng() % 40 : 1;
+            for (size_t r = 0; r < repeats; r++) src += pPiece;
+        }
+        corpus.push_back(src);
+    }
+}
+
+int main() {
+    std::vector<std::string> corpus;
+    addBoundaryCases(corpus);
+    addProgramCases(corpus);
+    addRandomCases(corpus);
+
+    const LexSIMDLevel supported = detectLexSIMDLevel();
+    const LexSIMDLevel levels[] = {LexSIMDLevel::SSE2, LexSIMDLevel::AVX2};
+    const char* const LEVEL_NAMES[] = {"scalar", "SSE2", "AVX2"};
+    size_t numFailed = 0, numTokens = 0;
+    for (size_t n = 0; n < corpus.size(); n++) {
+        // lexed from an exactly sized buffer, so reading past the end shows up under a sanitizer
+        const std::vector<char> buffer(corpus[n].begin(), corpus[n].end());
+        const std::string_view src(buffer.data(), buffer.size());
+        const int fileIndex = DTException::registerFile("corpus[" + std::to_string(n) + ']', src);
+        const LexResult expected = lex(src, LexSIMDLevel::SCALAR, fileIndex);
+        numTokens += expected.tokens.size();
+
+        for (const LexSIMDLevel level : levels) {
+            if ((int)level > (int)supported) continue;
+            const LexResult actual = lex(src, level, fileIndex);
+
+            size_t i = 0;
+            while (i < expected.tokens.size() && i < actual.tokens.size() && isSameToken(expected.tokens[i], actual.tokens[i])) i++;
+            if (i == expected.tokens.size() && i == actual.tokens.size() && expected.error == actual.error) continue;
+
+            if (numFailed++ >= MAX_REPORTED) continue;
+            std::cerr << LEVEL_NAMES[(int)level] << " differs from scalar on corpus[" << n << "] at token " << i
+                      << ": \"" << printable(src) << "\"\n";
+        }
+    }
+
+    for (const LexSIMDLevel level : levels)
+        if ((int)level > (int)supported) std::cout << "skipped " << LEVEL_NAMES[(int)level] << ", not supported by this CPU\n";
+    std::cout << corpus.size() << " inputs, " << numTokens << " tokens, " << numFailed << " mismatches\n";
+    return numFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#!/bin/bash
+# checks the ELF writer against nasm & ld: every program in tests/programs is compiled both ways
+# (--nasm & the default direct path) at each opt level, both are run & their exit codes must match
+# usage: tests/nasm_elf_test.sh dtc [work dir], the work dir defaults to a temporary one
+# exits w/ 77 (skipped, not passed) when nasm or ld aren't installed
+
+DTC=$1
+WORK_DIR=${2:-$(mktemp -d)}
+if [ -z "$DTC" ]; then
+    echo "usage: $0 dtc [work dir]"
+    exit 1
+fi
+for tool in nasm ld; do
+    if ! command -v $tool > /dev/null; then
+        echo "skipped, $tool isn't installed"
+        exit 77
+    fi
+done
+mkdir -p "$WORK_DIR" || exit 1
+
+# runs an executable, prints its exit code (or the failure to build it)
+# a miscompiled program may never return, so runs are cut off (exit code 124)
+run() {
+    if [ -x "$1" ]; then
+        timeout 20 "$1" > /dev/null
+        echo $?
+    else
+        echo "not built"
+    fi
+}
+
+numRuns=0
+numFailed=0
+for src in "$(dirname "$0")"/programs/*.dt; do
+    name=$(basename "$src" .dt)
+    for level in -O0 -O1 -O2; do
+        elf="$WORK_DIR/$name$level"
+        nasm="$WORK_DIR/$name$level.nasm"
+        rm -f "$elf" "$nasm"
+        "$DTC" "$src" -o "$elf" $level
+        "$DTC" "$src" -o "$nasm" $level --nasm
+        elfResult=$(run "$elf")
+        nasmResult=$(run "$nasm")
+        numRuns=$((numRuns + 1))
+        if [ "$elfResult" != "$nasmResult" ] || [ "$elfResult" = "not built" ]; then
+            echo "$name $level: $elfResult from the ELF writer, $nasmResult from nasm"
+            numFailed=$((numFailed + 1))
+        fi
+    done
+done
+
+echo "$numRuns programs, $numFailed failed"
+[ $numFailed -eq 0 ]
\ No newline at end of file
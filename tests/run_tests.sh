@@ -0,0 +1,44 @@
+#!/bin/bash
+# builds & runs every test, exits nonzero if any of them fail
+# usage: tests/run_tests.sh [build dir], the build dir defaults to tests/build
+# there are no build files, so everything is compiled here w/ $CXX (g++ unless set)
+
+cd "$(dirname "$0")/.." || exit 1
+BUILD_DIR=${1:-tests/build}
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:-"-std=c++17 -O2 -Wall -pthread"}
+mkdir -p "$BUILD_DIR" || exit 1
+
+numFailed=0
+numSkipped=0
+SKIP_CODE=77 # a test exits w/ this when it can't run here (ex. a tool is missing)
+
+# runs a test, the name is printed w/ whether it passed, failed or was skipped
+check() {
+    local name=$1
+    shift
+    "$@"
+    local result=$?
+    if [ $result -eq 0 ]; then
+        echo "PASS $name"
+    elif [ $result -eq $SKIP_CODE ]; then
+        echo "SKIP $name"
+        numSkipped=$((numSkipped + 1))
+    else
+        echo "FAIL $name"
+        numFailed=$((numFailed + 1))
+    fi
+}
+
+# 1. build
+LEXER_SOURCES="lexer.cpp lexer_simd.cpp symbols.cpp token_store.cpp thread_pool.cpp toolbox.cpp errors.cpp"
+$CXX $CXXFLAGS tests/lexer_simd_test.cpp $LEXER_SOURCES -o "$BUILD_DIR/lexer_simd_test" || exit 1
+$CXX $CXXFLAGS *.cpp ast/*.cpp opt/*.cpp ir/*.cpp x86/*.cpp -o "$BUILD_DIR/dtc" || exit 1
+
+# 2. run
+check lexer_simd "$BUILD_DIR/lexer_simd_test"
+check strength_reduction tests/strength_reduction_test.sh "$BUILD_DIR/dtc" "$BUILD_DIR/strength_reduction"
+check nasm_elf tests/nasm_elf_test.sh "$BUILD_DIR/dtc" "$BUILD_DIR/nasm_elf"
+
+echo "$numFailed failed, $numSkipped skipped"
+[ $numFailed -eq 0 ]
\ No newline at end of file
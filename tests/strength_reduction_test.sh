@@ -0,0 +1,98 @@
+#!/bin/bash
+# checks the strength reduced forms of *, / & % by a constant (shifts & masks, lea, magic numbers)
+# against the generic imul & idiv the same operations compile to when the other side isn't constant
+# one program per constant, each compiled at -O1 & -O2 (where strength reduction runs) & run
+# usage: tests/strength_reduction_test.sh dtc [work dir], the work dir defaults to a temporary one
+
+DTC=$1
+WORK_DIR=${2:-$(mktemp -d)}
+if [ -z "$DTC" ]; then
+    echo "usage: $0 dtc [work dir]"
+    exit 1
+fi
+mkdir -p "$WORK_DIR" || exit 1
+
+INT64_MIN=$((-9223372036854775807 - 1))
+INT64_MAX=9223372036854775807
+
+# sets lit to the value as a literal, INT64_MIN has no positive counterpart to negate
+literal() {
+    if [ "$1" -eq $INT64_MIN ]; then lit="(-9223372036854775807 - 1)"
+    elif [ "$1" -lt 0 ]; then lit="($1)"
+    else lit=$1
+    fi
+}
+
+# 1. constants, around the special cases of each reduction
+constants=()
+for ((c = -70; c <= 70; c++)); do
+    [ $c -ne 0 ] && constants+=($c)
+done
+for ((k = 7; k <= 62; k++)); do
+    constants+=($((1 << k)) $((-(1 << k))) $(((1 << k) + 1)) $(((1 << k) - 1)) $((-(1 << k) - 1)))
+done
+constants+=($INT64_MIN $INT64_MAX $((-INT64_MAX)) 641 6700417 1000000007 -1000000007 2147483647 -2147483648 3486784401 4747561509943)
+
+# operands, the same for every constant (plus a few around it), random ones fixed so failures reproduce
+operands=(0 1 -1 2 -2 3 -3 7 -7 100 -100 2147483648 -2147483648 4294967295 $((1 << 62)) $((-(1 << 62)))
+          $INT64_MAX $INT64_MIN $((INT64_MIN + 1)) 123456789 -123456789 1000000006 -1000000006)
+RANDOM=2024
+for ((i = 0; i < 12; i++)); do
+    val=$(((RANDOM << 48) ^ (RANDOM << 33) ^ (RANDOM << 18) ^ (RANDOM << 3) ^ RANDOM))
+    ((i % 2)) && val=$((-val))
+    operands+=($val)
+done
+
+# 2. a program per constant, the global divisor keeps the second form generic
+# (globals are never propagated), returns how many operands disagree
+writeProgram() {
+    local c=$1 path=$2 lit x
+    literal "$c"
+    local constant=$lit
+    {
+        echo "int gx = 0;"
+        echo "int gc = 0;"
+        echo "int check(int x) {"
+        echo "    int isDivWrong = x / $constant != x / gc;"
+        echo "    int isModWrong = x % $constant != x % gc;"
+        echo "    int isMulWrong = x * $constant != x * gc;"
+        echo "    int isMulLeftWrong = $constant * x != gc * x;"
+        echo "    return isDivWrong + isModWrong + isMulWrong + isMulLeftWrong;"
+        echo "}"
+        echo "int main() {"
+        echo "    gc = $constant;"
+        echo "    int bad = 0;"
+        for x in "${operands[@]}" $((c - 1)) $c $((c + 1)) $((-c)) $((c * 2 + 1)); do
+            [ $c -eq -1 ] && [ $x -eq $INT64_MIN ] && continue # idiv faults on its own
+            literal "$x"
+            echo "    gx = $lit; bad += check(gx);"
+        done
+        echo "    return bad;"
+        echo "}"
+    } > "$path"
+}
+
+# 3. compile & run
+numFailed=0
+for c in "${constants[@]}"; do
+    src="$WORK_DIR/sr.dt"
+    writeProgram "$c" "$src"
+    for level in -O1 -O2; do
+        exe="$WORK_DIR/sr$level"
+        rm -f "$exe"
+        if ! "$DTC" "$src" -o "$exe" $level; then
+            echo "constant $c: failed to compile at $level"
+            numFailed=$((numFailed + 1))
+            continue
+        fi
+        "$exe"
+        result=$?
+        if [ $result -ne 0 ]; then
+            echo "constant $c: exit code $result at $level (the # of mismatches unless it crashed)"
+            numFailed=$((numFailed + 1))
+        fi
+    done
+done
+
+echo "${#constants[@]} constants, ${#operands[@]}+ operands each, $numFailed failed"
+[ $numFailed -eq 0 ]
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(size_t numThreads) {
+    if (numThreads == 0) numThreads = std::max(1u, std::thread::hardware_concurrency());
+    workers.reserve(numThreads - 1);
+    for (size_t i = 1; i < numThreads; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        isClosing = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+void ThreadPool::run(size_t n, const std::function<void(size_t)>& task) {
+    if (n == 0) return;
+    if (workers.empty() || n == 1) { // nothing to hand out
+        for (size_t i = 0; i < n; i++) task(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( mutex );
+        pTask = &task;
+        numTasks = n;
+        numFinished = 0;
+        nextTask.store(0, std::memory_order_relaxed);
+        generation++;
+    }
+    wake.notify_all();
+
+    const size_t finished = drain(); // the caller works too instead of idling
+
+    std::unique_lock<std::mutex> lock( mutex );
+    numFinished += finished;
+    done.wait(lock, [&] { return numFinished == numTasks && numActive == 0; });
+    pTask = nullptr;
+}
+
+size_t ThreadPool::drain() {
+    size_t finished = 0;
+    size_t i;
+    while ((i = nextTask.fetch_add(1, std::memory_order_relaxed)) < numTasks) {
+        (*pTask)(i);
+        finished++;
+    }
+    return finished;
+}
+
+void ThreadPool::workerLoop() {
+    size_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock( mutex );
+            wake.wait(lock, [&] { return isClosing || (generation != seenGeneration && pTask != nullptr); });
+            if (isClosing) return;
+            seenGeneration = generation;
+            numActive++;
+        }
+        const size_t finished = drain();
+
+        std::lock_guard<std::mutex> lock( mutex );
+        numFinished += finished;
+        numActive--;
+        if (numFinished == numTasks && numActive == 0) done.notify_one();
+    }
+}
\ No newline at end of file
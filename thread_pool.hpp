@@ -0,0 +1,46 @@
+#ifndef __THREAD_POOL_HPP
+#define __THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// fixed set of worker threads for data-parallel compiler passes
+// run() hands out task indices to the workers (and the calling thread) until all are done,
+// tasks must not throw, catch inside the task & report back through its output slot instead
+class ThreadPool {
+    public:
+        ThreadPool(size_t numThreads); // total threads including the caller, 0 for one per core
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        size_t size() const { return workers.size() + 1; };
+
+        // calls task(i) for every i in [0, numTasks) & blocks until they've all returned
+        void run(size_t numTasks, const std::function<void(size_t)>& task);
+    private:
+        void workerLoop();
+        size_t drain(); // runs tasks of the current job until none are left, returns how many it ran
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake; // signals workers that a job started or the pool is closing
+        std::condition_variable done; // signals run() that the last task finished
+
+        // current job
+        const std::function<void(size_t)>* pTask = nullptr;
+        size_t numTasks = 0;
+        std::atomic<size_t> nextTask{0};
+        size_t numFinished = 0; // guarded by mutex
+        size_t numActive = 0; // workers inside drain(), a job isn't over until they've all left
+        size_t generation = 0; // bumped per job so workers don't rerun a finished one
+        bool isClosing = false;
+};
+
+#endif
\ No newline at end of file
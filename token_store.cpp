@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <vector>
+
+#include "token_store.hpp"
+#include "lexer.hpp"
+#include "lexer_tables.hpp"
+#include "errors.hpp"
+
+// true for literals that keep an entry in the side table (null is always spelled the same)
+static inline bool hasLiteralEntry(const TokenType type) {
+    return isTokenLiteral(type) && type != LIT_NULL;
+}
+
+void TokenStore::reserve(size_t n) {
+    types.reserve(n);
+    offsets.reserve(n);
+    data.reserve(n);
+}
+
+void TokenStore::push(const Token& token) {
+    types.push_back(token.type);
+    offsets.push_back(token.err.offset);
+    if (token.type == IDENTIFIER) {
+        data.push_back(token.symbol);
+    } else if (hasLiteralEntry(token.type)) {
+        data.push_back((uint32_t)literals.size());
+        literals.push_back({token.value, (uint32_t)token.raw.size()});
+    } else {
+        data.push_back(0);
+    }
+}
+
+void TokenStore::resize(size_t numTokens, size_t numLiterals) {
+    types.resize(numTokens);
+    offsets.resize(numTokens);
+    data.resize(numTokens);
+    literals.resize(numLiterals);
+}
+
+void TokenStore::splice(size_t tokenAt, size_t literalAt, const TokenStore& part, const std::vector<symbol_t>& globalIds) {
+    std::copy(part.types.begin(), part.types.end(), types.begin() + tokenAt);
+    std::copy(part.offsets.begin(), part.offsets.end(), offsets.begin() + tokenAt);
+    std::copy(part.literals.begin(), part.literals.end(), literals.begin() + literalAt);
+
+    // data slots are relative to the part, so point them at the global symbols & literals
+    for (size_t i = 0; i < part.size(); i++) {
+        const TokenType type = part.type(i);
+        if (type == IDENTIFIER)
+            data[tokenAt + i] = globalIds[part.data[i]];
+        else if (hasLiteralEntry(type))
+            data[tokenAt + i] = (uint32_t)literalAt + part.data[i];
+        else
+            data[tokenAt + i] = 0;
+    }
+}
+
+static_assert(RPAREN == LPAREN + 1 && RBRACKET == LBRACKET + 1 && RBRACE == LBRACE + 1,
+              "matchGroups expects every closing bracket right after its opener in TokenType");
+
+void TokenStore::matchGroups() {
+    std::vector<uint32_t> open; // indices of the groups still waiting on their closer
+    const size_t len = size();
+    for (size_t i = 0; i < len; i++) {
+        const TokenType tokenType = type(i);
+        if (isTokenGroupOpen(tokenType)) {
+            open.push_back((uint32_t)i);
+        } else if (isTokenGroupClose(tokenType)) {
+            // closers are always the token right after their opener (ex. LPAREN, RPAREN)
+            // a closer w/o an opener or of the wrong kind for the innermost group is the error,
+            // as the parser would report it
+            if (open.empty() || type(open.back()) + 1 != tokenType)
+                throw DTSyntaxException({offsets[i], fileIndex}, at(i).raw);
+            const uint32_t openIndex = open.back();
+
+            data[openIndex] = (uint32_t)i;
+            data[i] = openIndex;
+            open.pop_back();
+        }
+    }
+    if (!open.empty())
+        throw DTUnclosedGroupException({offsets[open.back()], fileIndex});
+}
+
+Token TokenStore::at(size_t i) const {
+    Token token;
+    token.type = type(i);
+    token.err = {offsets[i], fileIndex};
+    token.symbol = SYMBOL_NONE;
+    token.value = {};
+
+    if (token.type == IDENTIFIER) {
+        token.symbol = data[i];
+        token.raw = src.substr(offsets[i], SymbolTable::name(token.symbol).size());
+    } else if (hasLiteralEntry(token.type)) {
+        const TokenLiteral& literal = literals[data[i]];
+        const bool isQuoted = token.type == LIT_STR || token.type == LIT_CHAR;
+        token.value = literal.value;
+        token.raw = src.substr(offsets[i] + (isQuoted ? 1 : 0), literal.length);
+    } else {
+        token.raw = src.substr(offsets[i], FIXED_LENGTH_TABLE.lengths[token.type]);
+    }
+    return token;
+}
\ No newline at end of file
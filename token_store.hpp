@@ -0,0 +1,52 @@
+#ifndef __TOKEN_STORE_HPP
+#define __TOKEN_STORE_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "lexer.hpp"
+
+// literal side table entry
+struct TokenLiteral {
+    TokenValue value;
+    uint32_t length; // length of the raw text (w/o quotes for strings & chars)
+};
+
+// packed struct-of-arrays storage for a fully tokenized file, ~9 bytes per token
+// tokens are rebuilt on demand by at(), their text is recovered from the source buffer:
+// keywords & operators by their fixed spelling, identifiers from the symbol table and
+// literals from the literal side table
+class TokenStore {
+    public:
+        TokenStore(std::string_view src, const int fileIndex) : src(src), fileIndex(fileIndex) {};
+
+        void reserve(size_t);
+        void push(const Token&);
+
+        // for stitching together stores lexed in parallel, resize to the combined size first
+        // then splice each part in, symbols are remapped through globalIds on the way
+        void resize(size_t numTokens, size_t numLiterals);
+        void splice(size_t tokenAt, size_t literalAt, const TokenStore& part, const std::vector<symbol_t>& globalIds);
+
+        // pairs up every (), [] & {} in one pass, throws on the first group that doesn't balance
+        // must be called again if more tokens are pushed
+        void matchGroups();
+
+        size_t size() const { return types.size(); };
+        size_t numLiterals() const { return literals.size(); };
+        TokenType type(size_t i) const { return (TokenType)types[i]; };
+        uint32_t offset(size_t i) const { return offsets[i]; };
+        uint32_t match(size_t i) const { return data[i]; }; // index of the bracket paired with bracket i
+        Token at(size_t) const;
+    private:
+        std::string_view src;
+        int fileIndex;
+
+        std::vector<uint8_t> types;
+        std::vector<uint32_t> offsets; // byte offset of each token in src
+        std::vector<uint32_t> data; // symbol for IDENTIFIER, index into literals for literals, matching bracket for brackets
+        std::vector<TokenLiteral> literals;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "token_stream.hpp"
+#include "lexer.hpp"
+
+const Token* TokenStream::peek(size_t k) {
+    // fill the ring up to the requested lookahead
+    while (count <= k && !isExhausted) {
+        if (pull(ring[(head + count) & (TOKEN_RING_SIZE-1)]))
+            count++;
+        else
+            isExhausted = true;
+    }
+    return k < count ? &ring[(head + k) & (TOKEN_RING_SIZE-1)] : nullptr;
+}
+
+const Token& TokenStream::next() {
+    peek(); // make sure a token is buffered
+    lastToken = ring[head];
+    head = (head + 1) & (TOKEN_RING_SIZE-1);
+    count--;
+    return lastToken;
+}
+
+bool StoreTokenStream::pull(Token& token) {
+    if (i == end) return false;
+    token = tokens.at(i++);
+    return true;
+}
\ No newline at end of file
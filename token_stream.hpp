@@ -0,0 +1,61 @@
+#ifndef __TOKEN_STREAM_HPP
+#define __TOKEN_STREAM_HPP
+
+#include <string_view>
+
+#include "lexer.hpp"
+#include "token_store.hpp"
+
+#define TOKEN_RING_SIZE 8 // max lookahead the parser may ask for (must be a power of 2)
+
+// pull-based token source for the parser
+// tokens are pulled from the underlying source on demand into a small ring buffer, so the
+// parser only ever holds a constant number of tokens no matter how big the file is
+class TokenStream {
+    public:
+        virtual ~TokenStream() {};
+
+        // returns the token k places ahead without consuming it, nullptr if past the end
+        const Token* peek(size_t k = 0);
+
+        // consumes and returns the next token, the stream must not be at its end
+        const Token& next();
+
+        bool atEnd() { return peek() == nullptr; };
+
+        // the most recently consumed token (for errors at the end of input)
+        const Token& last() const { return lastToken; };
+    protected:
+        // pulls the next token from the underlying source, false if there are none left
+        virtual bool pull(Token&) = 0;
+    private:
+        Token ring[TOKEN_RING_SIZE];
+        size_t head = 0; // index of the next unconsumed token in ring
+        size_t count = 0; // # of buffered tokens
+        bool isExhausted = false;
+        Token lastToken = {TokenType::IDENTIFIER, "", {0, 0}, SYMBOL_NONE, {}};
+};
+
+// lexes tokens on demand straight from the source buffer
+class LexerTokenStream : public TokenStream {
+    public:
+        LexerTokenStream(std::string_view src, const int fileIndex) : lexer(src, fileIndex) {};
+    protected:
+        bool pull(Token& token) { return lexer.next(token); };
+    private:
+        Lexer lexer;
+};
+
+// streams an already tokenized file
+class StoreTokenStream : public TokenStream {
+    public:
+        StoreTokenStream(const TokenStore& tokens) : tokens(tokens), i(0), end(tokens.size()) {};
+        StoreTokenStream(const TokenStore& tokens, size_t start, size_t end) : tokens(tokens), i(start), end(end) {}; // [start, end)
+    protected:
+        bool pull(Token& token);
+    private:
+        const TokenStore& tokens;
+        size_t i, end;
+};
+
+#endif
\ No newline at end of file
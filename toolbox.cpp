@@ -1,10 +1,11 @@
 #include <string>
+#include <string_view>
 
 #include "toolbox.hpp"
 
 // list of escape chars (in JS)
 // https://en.wikipedia.org/wiki/Escape_character#:~:text=%5Bedit%5D-,JavaScript,-%5Bedit%5D
-char escapeChar(const std::string& str) {
+char escapeChar(std::string_view str) {
     switch (str[1]) {
         case '\'': return '\'';
         case '"': return '"';
@@ -18,4 +19,20 @@ char escapeChar(const std::string& str) {
         case '0':
         default: return '\0';
     }
+}
+
+// decodes the escapes in the raw text of a string literal (ex. \n into a newline)
+std::string unescapeString(std::string_view raw) {
+    std::string str;
+    str.reserve(raw.size());
+    const size_t len = raw.size();
+    for (size_t i = 0; i < len; i++) {
+        if (raw[i] == '\\' && i+1 < len) {
+            str.push_back(escapeChar(raw.substr(i, 2)));
+            i++;
+        } else {
+            str.push_back(raw[i]);
+        }
+    }
+    return str;
 }
\ No newline at end of file
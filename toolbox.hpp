@@ -2,7 +2,9 @@
 #define __TOOLBOX_HPP
 
 #include <string>
+#include <string_view>
 
-char escapeChar(const std::string&);
+char escapeChar(std::string_view);
+std::string unescapeString(std::string_view);
 
 #endif
\ No newline at end of file
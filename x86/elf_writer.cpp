@@ -0,0 +1,216 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <elf.h>
+#include <sys/stat.h>
+
+#include "elf_writer.hpp"
+
+#define EXECUTABLE_BASE 0x400000 // where the executable is loaded
+#define PAGE_SIZE 0x1000
+
+static size_t alignUp(size_t val, size_t alignment) { return (val + alignment - 1) & ~(alignment - 1); }
+
+// file contents built up in memory & written in one go
+class ELFBuffer {
+    public:
+        size_t size() const { return bytes.size(); };
+        void padTo(size_t offset) { bytes.resize(offset, 0); };
+        void append(const void* pData, size_t len) {
+            const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+            bytes.insert(bytes.end(), pBytes, pBytes + len);
+        };
+        template <typename T>
+        void append(const T& val) { append(&val, sizeof(T)); };
+        template <typename T>
+        void write(size_t offset, const T& val) { std::memcpy(&bytes[offset], &val, sizeof(T)); };
+
+        bool save(const std::string& path) const {
+            std::ofstream outHandle(path, std::ios::binary | std::ios::trunc);
+            if (!outHandle.is_open()) return false;
+            outHandle.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+            return outHandle.good();
+        };
+    private:
+        std::vector<uint8_t> bytes;
+};
+
+static Elf64_Ehdr makeHeader(uint16_t type) {
+    Elf64_Ehdr header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS64;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_ident[EI_OSABI] = ELFOSABI_SYSV;
+    header.e_type = type;
+    header.e_machine = EM_X86_64;
+    header.e_version = EV_CURRENT;
+    header.e_ehsize = sizeof(Elf64_Ehdr);
+    return header;
+}
+
+// names joined into a string table, returns where the name starts
+static uint32_t addName(std::string& table, const std::string& name) {
+    const uint32_t offset = (uint32_t)table.size();
+    table += name;
+    table += '\0';
+    return offset;
+}
+
+bool writeELFObject(const std::string& path, const X86Object& object) {
+    enum { SECTION_NULL, SECTION_TEXT, SECTION_DATA, SECTION_SYMTAB, SECTION_STRTAB, SECTION_RELA_TEXT, SECTION_SHSTRTAB, NUM_SECTIONS };
+    ELFBuffer buffer;
+    Elf64_Ehdr header = makeHeader(ET_REL);
+    buffer.append(header); // filled in at the end
+
+    // 1. contents
+    buffer.padTo(alignUp(buffer.size(), 16));
+    const size_t textOffset = buffer.size();
+    buffer.append(object.text.data(), object.text.size());
+    buffer.padTo(alignUp(buffer.size(), 8));
+    const size_t dataOffset = buffer.size();
+    buffer.append(object.data.data(), object.data.size());
+
+    // 2. symbols, locals first (sh_info of the table is the first global), ELF's own null symbol goes first
+    std::string strtab(1, '\0');
+    buffer.padTo(alignUp(buffer.size(), 8));
+    const size_t symtabOffset = buffer.size();
+    Elf64_Sym symbol;
+    std::memset(&symbol, 0, sizeof(symbol));
+    buffer.append(symbol);
+    uint32_t firstGlobal = (uint32_t)object.symbols.size() + 1;
+    for (size_t i = 0; i < object.symbols.size(); i++) {
+        const X86Symbol& sym = object.symbols[i];
+        const bool isText = sym.section == X86Section::TEXT;
+        if (sym.isGlobal && firstGlobal > i + 1) firstGlobal = (uint32_t)i + 1;
+        symbol.st_name = addName(strtab, sym.name);
+        symbol.st_info = ELF64_ST_INFO(sym.isGlobal ? STB_GLOBAL : STB_LOCAL, isText ? STT_FUNC : STT_OBJECT);
+        symbol.st_other = STV_DEFAULT;
+        symbol.st_shndx = isText ? SECTION_TEXT : SECTION_DATA;
+        symbol.st_value = sym.offset;
+        buffer.append(symbol);
+    }
+    const size_t symtabSize = buffer.size() - symtabOffset;
+    const size_t strtabOffset = buffer.size();
+    buffer.append(strtab.data(), strtab.size());
+
+    // 3. relocations against the symbols
+    buffer.padTo(alignUp(buffer.size(), 8));
+    const size_t relaOffset = buffer.size();
+    for (const X86Relocation& relocation : object.relocations) {
+        Elf64_Rela rela;
+        rela.r_offset = relocation.offset;
+        rela.r_info = ELF64_R_INFO(relocation.symbol + 1, R_X86_64_PC32);
+        rela.r_addend = relocation.addend;
+        buffer.append(rela);
+    }
+    const size_t relaSize = buffer.size() - relaOffset;
+
+    // 4. section names & headers
+    std::string shstrtab(1, '\0');
+    const uint32_t names[NUM_SECTIONS] = {
+        0, addName(shstrtab, ".text"), addName(shstrtab, ".data"), addName(shstrtab, ".symtab"),
+        addName(shstrtab, ".strtab"), addName(shstrtab, ".rela.text"), addName(shstrtab, ".shstrtab")
+    };
+    const size_t shstrtabOffset = buffer.size();
+    buffer.append(shstrtab.data(), shstrtab.size());
+
+    struct SectionLayout {
+        uint32_t type;
+        uint64_t flags;
+        size_t offset, size;
+        uint32_t link, info;
+        uint64_t alignment, entrySize;
+    };
+    const SectionLayout layouts[NUM_SECTIONS] = {
+        {SHT_NULL, 0, 0, 0, 0, 0, 0, 0},
+        {SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, textOffset, object.text.size(), 0, 0, 16, 0},
+        {SHT_PROGBITS, SHF_ALLOC | SHF_WRITE, dataOffset, object.data.size(), 0, 0, 8, 0},
+        {SHT_SYMTAB, 0, symtabOffset, symtabSize, SECTION_STRTAB, firstGlobal, 8, sizeof(Elf64_Sym)},
+        {SHT_STRTAB, 0, strtabOffset, strtab.size(), 0, 0, 1, 0},
+        {SHT_RELA, SHF_INFO_LINK, relaOffset, relaSize, SECTION_SYMTAB, SECTION_TEXT, 8, sizeof(Elf64_Rela)},
+        {SHT_STRTAB, 0, shstrtabOffset, shstrtab.size(), 0, 0, 1, 0}
+    };
+    buffer.padTo(alignUp(buffer.size(), 8));
+    header.e_shoff = buffer.size();
+    for (size_t i = 0; i < NUM_SECTIONS; i++) {
+        const SectionLayout& layout = layouts[i];
+        Elf64_Shdr section;
+        std::memset(&section, 0, sizeof(section));
+        section.sh_name = names[i];
+        section.sh_type = layout.type;
+        section.sh_flags = layout.flags;
+        section.sh_offset = layout.offset;
+        section.sh_size = layout.size;
+        section.sh_link = layout.link;
+        section.sh_info = layout.info;
+        section.sh_addralign = layout.alignment;
+        section.sh_entsize = layout.entrySize;
+        buffer.append(section);
+    }
+
+    header.e_shentsize = sizeof(Elf64_Shdr);
+    header.e_shnum = NUM_SECTIONS;
+    header.e_shstrndx = SECTION_SHSTRTAB;
+    buffer.write(0, header);
+    return buffer.save(path);
+}
+
+bool writeELFExecutable(const std::string& path, const X86Object& object) {
+    // the headers & text are loaded as one read/execute segment, the data on the pages after it
+    // as a read/write one (left out if there isn't any)
+    const bool hasData = !object.data.empty();
+    const size_t numSegments = hasData ? 2 : 1;
+    const size_t textOffset = alignUp(sizeof(Elf64_Ehdr) + numSegments * sizeof(Elf64_Phdr), 16);
+    const size_t dataOffset = alignUp(textOffset + object.text.size(), PAGE_SIZE);
+    const uint64_t textAddress = EXECUTABLE_BASE + textOffset, dataAddress = EXECUTABLE_BASE + dataOffset;
+
+    // 1. resolve the relocations, each is a 32 bit offset from where it is
+    std::vector<uint8_t> text = object.text;
+    for (const X86Relocation& relocation : object.relocations) {
+        const X86Symbol& sym = object.symbols[relocation.symbol];
+        const uint64_t target = (sym.section == X86Section::TEXT ? textAddress : dataAddress) + sym.offset;
+        const int32_t rel = (int32_t)(target + relocation.addend - (textAddress + relocation.offset));
+        std::memcpy(&text[relocation.offset], &rel, 4);
+    }
+
+    // 2. headers
+    ELFBuffer buffer;
+    Elf64_Ehdr header = makeHeader(ET_EXEC);
+    header.e_entry = textAddress + object.symbols[object.entry].offset;
+    header.e_phoff = sizeof(Elf64_Ehdr);
+    header.e_phentsize = sizeof(Elf64_Phdr);
+    header.e_phnum = (uint16_t)numSegments;
+    buffer.append(header);
+
+    Elf64_Phdr segment;
+    std::memset(&segment, 0, sizeof(segment));
+    segment.p_type = PT_LOAD;
+    segment.p_flags = PF_R | PF_X;
+    segment.p_offset = 0;
+    segment.p_vaddr = segment.p_paddr = EXECUTABLE_BASE;
+    segment.p_filesz = segment.p_memsz = textOffset + text.size();
+    segment.p_align = PAGE_SIZE;
+    buffer.append(segment);
+    if (hasData) {
+        segment.p_flags = PF_R | PF_W;
+        segment.p_offset = dataOffset;
+        segment.p_vaddr = segment.p_paddr = dataAddress;
+        segment.p_filesz = segment.p_memsz = object.data.size();
+        buffer.append(segment);
+    }
+
+    // 3. contents
+    buffer.padTo(textOffset);
+    buffer.append(text.data(), text.size());
+    if (hasData) {
+        buffer.padTo(dataOffset);
+        buffer.append(object.data.data(), object.data.size());
+    }
+    if (!buffer.save(path)) return false;
+    return chmod(path.c_str(), 0755) == 0;
+}
\ No newline at end of file
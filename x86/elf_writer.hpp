@@ -0,0 +1,16 @@
+#ifndef __ELF_WRITER_HPP
+#define __ELF_WRITER_HPP
+
+#include <string>
+
+#include "x86_encoder.hpp"
+
+// relocatable ELF64 object (.text, .data, their symbols & the relocations between them), for
+// linking w/ other objects, returns false if the file couldn't be written
+bool writeELFObject(const std::string& path, const X86Object&);
+
+// static ELF64 executable, the text & data are loaded as 2 segments & the relocations are
+// resolved here, so it runs w/o a linker, returns false if the file couldn't be written
+bool writeELFExecutable(const std::string& path, const X86Object&);
+
+#endif
\ No newline at end of file
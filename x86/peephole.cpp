@@ -0,0 +1,177 @@
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "peephole.hpp"
+
+#define PEEPHOLE_RULE_DESCRIPTION(name, description) description,
+static const char* const RULE_DESCRIPTIONS[] = { PEEPHOLE_RULE_LIST(PEEPHOLE_RULE_DESCRIPTION) };
+#undef PEEPHOLE_RULE_DESCRIPTION
+
+static bool isMemory(const X86Operand& operand) { return operand.kind == X86Operand::MEMORY; }
+
+// 64 bit general purpose registers that may hold values (not rsp or rbp)
+static bool isRegister(const X86Operand& operand) {
+    return operand.isGPR() && operand.size == 8 && operand.reg != Register::RSP && operand.reg != Register::RBP;
+}
+
+static bool isRegister(const X86Operand& operand, Register reg) {
+    return operand.kind == X86Operand::REGISTER && operand.size == 8 && operand.reg == reg;
+}
+
+static bool isImmediate(const X86Operand& operand, int64_t value) {
+    return operand.kind == X86Operand::IMMEDIATE && operand.value == value;
+}
+
+static bool isMove(const std::string& mnemonic) {
+    return mnemonic == "mov" || mnemonic == "movapd" || mnemonic == "movq" || mnemonic == "movsd";
+}
+
+static bool isReadingFlags(const X86Instr& instr) {
+    const std::string& m = instr.mnemonic;
+    return (m[0] == 'j' && m != "jmp") || m.compare(0, 3, "set") == 0 || m.compare(0, 4, "cmov") == 0 || m == "adc" || m == "sbb";
+}
+
+static bool isWritingFlags(const X86Instr& instr) {
+    static const char* const WRITERS[] = {"add", "sub", "and", "or", "xor", "cmp", "test", "neg", "imul", "idiv", "btc", "ucomisd"};
+    const std::string& m = instr.mnemonic;
+    for (const char* writer : WRITERS)
+        if (m == writer) return true;
+    return (m == "shl" || m == "shr" || m == "sar") && instr.operands[1].kind == X86Operand::IMMEDIATE; // a count of 0 in cl leaves them alone
+}
+
+// whether the flags set before instrs[i] are never read, looking ahead to the next instruction
+// that sets them or control leaves the straight line code (flags are never live across that)
+static bool areFlagsDead(const std::vector<X86Instr>& instrs, size_t i) {
+    for (; i < instrs.size(); i++) {
+        const X86Instr& instr = instrs[i];
+        if (instr.isLabel) return true;
+        if (isReadingFlags(instr)) return false;
+        if (isWritingFlags(instr) || instr.mnemonic == "jmp" || instr.mnemonic == "call" || instr.mnemonic == "ret") return true;
+    }
+    return true;
+}
+
+// slides over the code once, each instruction is appended to out & the rules are matched on
+// the end of out (so a rewrite can take part in the next match)
+class PeepholeWindow {
+    public:
+        PeepholeWindow(const std::vector<X86Instr>& instrs, PeepholeStats& stats) : instrs(instrs), stats(stats) {};
+
+        // returns true if any rule fired
+        bool run(std::vector<X86Instr>& out) {
+            for (size_t i = 0; i < instrs.size(); i++) {
+                out.push_back(instrs[i]);
+                while (match(out, i+1)) isChanged = true;
+                trackStack(instrs[i]);
+            }
+            return isChanged;
+        };
+    private:
+        // where rsp is relative to rbp after each instruction, so "mov rsp, rbp" can be seen to do nothing
+        // rsp only moves in balanced pairs inside a function's body, so at each label it's back
+        // where the prologue left it
+        void trackStack(const X86Instr& instr) {
+            const std::string& m = instr.mnemonic;
+            const bool isPrologue = isInPrologue;
+            isInPrologue = false;
+            if (instr.isLabel) {
+                depth = bodyDepth;
+            } else if (m == "mov" && isRegister(instr.operands[0], Register::RBP) && isRegister(instr.operands[1], Register::RSP)) {
+                isFrameKnown = true;
+                isInPrologue = true;
+                depth = bodyDepth = 0;
+            } else if (m == "mov" && isRegister(instr.operands[0], Register::RSP)) {
+                if (isRegister(instr.operands[1], Register::RBP)) depth = 0;
+                else isFrameKnown = false;
+            } else if (m == "push") {
+                depth += 8;
+            } else if (m == "pop") {
+                depth -= 8;
+            } else if ((m == "sub" || m == "add") && isRegister(instr.operands[0], Register::RSP)) {
+                const long long size = instr.operands[1].value;
+                depth += m == "sub" ? size : -size;
+                if (isPrologue && m == "sub") bodyDepth = depth;
+            }
+        };
+
+        // tries every rule on the end of out, next is the index of the first instruction not yet in it
+        bool match(std::vector<X86Instr>& out, size_t next) {
+            X86Instr& last = out.back();
+            X86Instr* pPrev = out.size() >= 2 ? &out[out.size()-2] : nullptr;
+
+            if (last.isLabel) {
+                // a jump to a label right after it, there may be other labels in between
+                size_t j = out.size() - 1;
+                while (j > 0 && out[j-1].isLabel) j--;
+                if (j == 0 || out[j-1].mnemonic[0] != 'j' || out[j-1].operands[0].symbol != last.mnemonic) return false;
+                out.erase(out.begin() + (j-1));
+                return fire(PEEPHOLE_JUMP_TO_NEXT);
+            }
+            const std::string& m = last.mnemonic;
+
+            if (m == "pop" && pPrev != nullptr && !pPrev->isLabel && pPrev->mnemonic == "push") {
+                const X86Operand src = pPrev->operands[0], dst = last.operands[0];
+                if (src != dst && isMemory(src) && isMemory(dst)) return false; // no memory to memory mov
+                out.pop_back();
+                out.pop_back();
+                if (src != dst) out.push_back({"mov", {dst, src}, false});
+                return fire(PEEPHOLE_PUSH_POP);
+            }
+
+            if (isMove(m)) {
+                const X86Operand& dst = last.operands[0];
+                const X86Operand& src = last.operands[1];
+                const bool isUndoing = pPrev != nullptr && !pPrev->isLabel && pPrev->mnemonic == m &&
+                                       pPrev->operands[0] == src && pPrev->operands[1] == dst;
+                const bool isFrameUnused = m == "mov" && isRegister(dst, Register::RSP) && isRegister(src, Register::RBP) && isFrameKnown && depth == 0;
+                if (dst == src || isUndoing || isFrameUnused) {
+                    out.pop_back();
+                    return fire(PEEPHOLE_REDUNDANT_MOVE);
+                }
+                if (m == "mov" && isRegister(dst) && isImmediate(src, 0) && areFlagsDead(instrs, next)) {
+                    const X86Operand dword(dst.reg, 4); // writing the low half zeroes the upper one
+                    last = {"xor", {dword, dword}, false};
+                    return fire(PEEPHOLE_XOR_ZERO);
+                }
+                return false;
+            }
+
+            if (m == "cmp" && isRegister(last.operands[0]) && isImmediate(last.operands[1], 0)) {
+                last.mnemonic = "test";
+                last.operands[1] = last.operands[0];
+                return fire(PEEPHOLE_TEST_ZERO);
+            }
+            return false;
+        };
+
+        bool fire(PeepholeRule rule) {
+            stats.counts[rule]++;
+            return true;
+        };
+
+        const std::vector<X86Instr>& instrs;
+        PeepholeStats& stats;
+        bool isChanged = false;
+
+        bool isFrameKnown = false; // whether a prologue has set rbp yet
+        bool isInPrologue = false; // the last instruction set rbp
+        long long depth = 0; // bytes rsp is below rbp
+        long long bodyDepth = 0; // depth right after the prologue
+};
+
+void optimizePeephole(X86Code& code, PeepholeStats& stats) {
+    bool isChanged = true;
+    while (isChanged) {
+        std::vector<X86Instr> out;
+        out.reserve(code.instrs.size());
+        isChanged = PeepholeWindow(code.instrs, stats).run(out);
+        code.instrs = std::move(out);
+    }
+}
+
+void printPeepholeStats(std::ostream& outStream, const PeepholeStats& stats) {
+    for (size_t i = 0; i < NUM_PEEPHOLE_RULES; i++)
+        outStream << "Peephole rule '" << RULE_DESCRIPTIONS[i] << "' fired " << stats.counts[i] << " times\n";
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef __PEEPHOLE_HPP
+#define __PEEPHOLE_HPP
+
+#include <cstddef>
+#include <ostream>
+
+#include "x86_code.hpp"
+
+// every rule as X(name, description)
+#define PEEPHOLE_RULE_LIST(X) \
+    X(PUSH_POP, "push/pop collapse") /* push a; pop b -> mov b, a (or nothing if a is b) */ \
+    X(XOR_ZERO, "xor zeroing") /* mov reg, 0 -> xor reg32, reg32 where the flags are dead */ \
+    X(REDUNDANT_MOVE, "redundant move") /* mov a, a; a mov undoing the one before; mov rsp, rbp while rsp is rbp */ \
+    X(JUMP_TO_NEXT, "jump to next") /* a jump to the label right after it */ \
+    X(TEST_ZERO, "compare with 0") /* cmp reg, 0 -> test reg, reg */
+
+#define PEEPHOLE_RULE_TAG(name, description) PEEPHOLE_##name,
+enum PeepholeRule {
+    PEEPHOLE_RULE_LIST(PEEPHOLE_RULE_TAG)
+    NUM_PEEPHOLE_RULES
+};
+#undef PEEPHOLE_RULE_TAG
+
+// # of times each rule fired
+struct PeepholeStats {
+    size_t counts[NUM_PEEPHOLE_RULES] = {};
+};
+
+// slides a window of a few instructions over the code, rewriting the patterns the generator
+// leaves behind (it works a value at a time, so it can't see them), until no rule fires
+// relies on how the generator lays out code: rsp is the same at every label & flags are never
+// live across one, jump or call
+void optimizePeephole(X86Code&, PeepholeStats&);
+
+// one line per rule
+void printPeepholeStats(std::ostream&, const PeepholeStats&);
+
+#endif
\ No newline at end of file
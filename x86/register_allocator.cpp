@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "register_allocator.hpp"
+
+// handed out in this order, so values that don't need to survive a call leave the
+// callee-saved registers (which cost a save & restore in the prologue & epilogue) alone
+static const Register CALLER_SAVED_GPRS[] = {
+    Register::RSI, Register::RDI, Register::R8, Register::R9, Register::R10, Register::R11
+};
+static const Register CALLEE_SAVED_GPRS[] = {
+    Register::RBX, Register::R12, Register::R13, Register::R14, Register::R15
+};
+static const Register ALLOCATABLE_XMMS[] = {
+    Register::XMM2, Register::XMM3, Register::XMM4, Register::XMM5, Register::XMM6, Register::XMM7, Register::XMM8,
+    Register::XMM9, Register::XMM10, Register::XMM11, Register::XMM12, Register::XMM13, Register::XMM14, Register::XMM15
+};
+
+// [start, end] in instruction positions: instruction k of the layout reads its args at 2k &
+// writes its value at 2k+1, except for the moves made all at once: phis are written at the
+// start of their block & their args read at the end of the matching pred, params are all
+// written right as the function starts
+struct LiveInterval {
+    uint32_t start = UINT32_MAX;
+    uint32_t end = 0;
+    bool isCrossingCall = false;
+};
+
+class LinearScan {
+    public:
+        LinearScan(const IRFunction& func) : func(func), intervals(func.numVregs()) {
+            allocation.registers.assign(func.numVregs(), Register::RAX);
+            allocation.slots.assign(func.numVregs(), UINT32_MAX);
+            allocation.saveSlots.assign(func.numVregs(), UINT32_MAX);
+            for (const Register reg : CALLER_SAVED_GPRS) isFree[(size_t)reg] = true;
+            for (const Register reg : CALLEE_SAVED_GPRS) isFree[(size_t)reg] = true;
+            for (const Register reg : ALLOCATABLE_XMMS) isFree[(size_t)reg] = true;
+        };
+
+        RegisterAllocation allocate() {
+            buildIntervals();
+            scan();
+            assignSlots();
+            return std::move(allocation);
+        };
+    private:
+        void buildIntervals() {
+            const std::vector<block_id> order = getReversePostorder(func);
+            std::vector<uint32_t> firstPos(func.blocks.size(), 0), lastPos(func.blocks.size(), 0);
+            uint32_t k = 0;
+            for (const block_id b : order) {
+                firstPos[b] = 2*k;
+                k += (uint32_t)func.blocks[b].instrs.size();
+                lastPos[b] = 2*(k-1);
+            }
+
+            auto use = [&](vreg_t v, uint32_t pos) { intervals[v].end = std::max(intervals[v].end, pos); };
+            auto def = [&](vreg_t v, uint32_t pos) {
+                intervals[v].start = std::min(intervals[v].start, pos);
+                intervals[v].end = std::max(intervals[v].end, pos);
+            };
+            for (const block_id b : order) {
+                const IRBlock& block = func.blocks[b];
+                for (size_t i = 0; i < block.instrs.size(); i++) {
+                    const IRInstr& instr = block.instrs[i];
+                    if (isImmediate(instr)) continue; // never defined, so never allocated
+                    const uint32_t pos = firstPos[b] + 2*(uint32_t)i;
+                    if (instr.op == IROp::PHI) {
+                        def(instr.dst, firstPos[b]);
+                        for (size_t j = 0; j < instr.args.size(); j++) use(instr.args[j], lastPos[block.preds[j]]);
+                        continue;
+                    }
+                    if (instr.op == IROp::PARAM) { // moved in all at once on entry, like phis
+                        def(instr.dst, firstPos[b] + 1);
+                        continue;
+                    }
+                    for (const vreg_t arg : instr.args) use(arg, pos);
+                    if (instr.dst != VREG_NONE) def(instr.dst, pos + 1);
+                    if (instr.op == IROp::CALL) callPositions.push_back(pos);
+                }
+            }
+
+            // whatever is live into a loop header has to survive the whole loop, up to its back edge
+            std::vector<std::pair<uint32_t, uint32_t>> loops; // {header start, latch end}
+            for (const block_id b : order)
+                for (size_t i = 0; i < func.blocks[b].numSuccessors(); i++) {
+                    const block_id header = func.blocks[b].successor(i);
+                    if (firstPos[header] <= firstPos[b]) loops.push_back({firstPos[header], lastPos[b] + 1});
+                }
+            bool isChanged = !loops.empty();
+            while (isChanged) {
+                isChanged = false;
+                for (LiveInterval& interval : intervals)
+                    for (const std::pair<uint32_t, uint32_t>& loop : loops)
+                        if (interval.start < loop.first && interval.end >= loop.first && interval.end < loop.second) {
+                            interval.end = loop.second;
+                            isChanged = true;
+                        }
+            }
+
+            // calls are found in layout order, so their positions are sorted
+            for (LiveInterval& interval : intervals) {
+                const auto next = std::upper_bound(callPositions.begin(), callPositions.end(), interval.start);
+                interval.isCrossingCall = next != callPositions.end() && *next < interval.end;
+            }
+        };
+
+        void scan() {
+            std::vector<vreg_t> sorted;
+            for (vreg_t v = 0; v < intervals.size(); v++)
+                if (intervals[v].start != UINT32_MAX) sorted.push_back(v); // immediates & vregs only defined in unreachable blocks aren't
+            std::stable_sort(sorted.begin(), sorted.end(), [&](vreg_t a, vreg_t b) { return intervals[a].start < intervals[b].start; });
+
+            for (const vreg_t v : sorted) {
+                expire(intervals[v].start);
+                const bool isDouble = func.vregTypes[v] == IRType::F64;
+                Register reg;
+                if (pickRegister(v, isDouble, reg)) {
+                    take(v, reg);
+                    continue;
+                }
+
+                // out of registers, spill whichever interval ends last
+                vreg_t victim = v;
+                for (const vreg_t other : active)
+                    if ((func.vregTypes[other] == IRType::F64) == isDouble && intervals[other].end > intervals[victim].end)
+                        victim = other;
+                spill(victim);
+                if (victim != v) take(v, allocation.registers[victim]);
+            }
+        };
+
+        // frees the registers of intervals that ended before pos
+        void expire(uint32_t pos) {
+            size_t kept = 0;
+            for (const vreg_t other : active) {
+                if (intervals[other].end < pos) isFree[(size_t)allocation.registers[other]] = true;
+                else active[kept++] = other;
+            }
+            active.resize(kept);
+        };
+
+        bool pickRegister(vreg_t v, bool isDouble, Register& reg) const {
+            auto pickFrom = [&](const Register* regs, size_t count) {
+                for (size_t i = 0; i < count; i++)
+                    if (isFree[(size_t)regs[i]]) {
+                        reg = regs[i];
+                        return true;
+                    }
+                return false;
+            };
+            if (isDouble) return pickFrom(ALLOCATABLE_XMMS, std::size(ALLOCATABLE_XMMS));
+            if (intervals[v].isCrossingCall)
+                return pickFrom(CALLEE_SAVED_GPRS, std::size(CALLEE_SAVED_GPRS)) || pickFrom(CALLER_SAVED_GPRS, std::size(CALLER_SAVED_GPRS));
+            return pickFrom(CALLER_SAVED_GPRS, std::size(CALLER_SAVED_GPRS)) || pickFrom(CALLEE_SAVED_GPRS, std::size(CALLEE_SAVED_GPRS));
+        };
+
+        void take(vreg_t v, Register reg) {
+            allocation.registers[v] = reg;
+            isFree[(size_t)reg] = false;
+            active.push_back(v);
+            isUsed[(size_t)reg] = true;
+        };
+
+        // the victim's register goes to whoever spilled it
+        void spill(vreg_t v) {
+            allocation.slots[v] = 0; // numbered once they're all known
+            const auto it = std::find(active.begin(), active.end(), v);
+            if (it != active.end()) active.erase(it);
+        };
+
+        // spilled vregs first, then the ones saved around calls, then the callee-saved registers
+        void assignSlots() {
+            uint32_t numSlots = 0;
+            for (vreg_t v = 0; v < intervals.size(); v++)
+                if (allocation.slots[v] != UINT32_MAX) allocation.slots[v] = numSlots++;
+            allocation.numSpilled = numSlots;
+
+            allocation.callSaves.resize(callPositions.size());
+            for (vreg_t v = 0; v < intervals.size(); v++) {
+                const LiveInterval& interval = intervals[v];
+                if (!interval.isCrossingCall || allocation.isSpilled(v) || isRegisterCalleeSaved(allocation.registers[v])) continue;
+                allocation.saveSlots[v] = numSlots++;
+                const size_t first = std::upper_bound(callPositions.begin(), callPositions.end(), interval.start) - callPositions.begin();
+                for (size_t c = first; c < callPositions.size() && callPositions[c] < interval.end; c++)
+                    allocation.callSaves[c].push_back(v);
+            }
+
+            for (const Register reg : CALLEE_SAVED_GPRS)
+                if (isUsed[(size_t)reg]) allocation.calleeSaved.push_back({reg, numSlots++});
+            allocation.numSlots = numSlots;
+        };
+
+        const IRFunction& func;
+        std::vector<LiveInterval> intervals; // of each vreg
+        std::vector<uint32_t> callPositions;
+        std::vector<vreg_t> active; // intervals holding a register
+        bool isFree[32] = {};
+        bool isUsed[32] = {};
+        RegisterAllocation allocation;
+};
+
+RegisterAllocation allocateRegisters(const IRFunction& func) {
+    return LinearScan(func).allocate();
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef __REGISTER_ALLOCATOR_HPP
+#define __REGISTER_ALLOCATOR_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "x86_code.hpp"
+#include "../ir/ir.hpp"
+
+// System V: a callee has to preserve these (& rbp, rsp), every other register may be clobbered by a call
+constexpr bool isRegisterCalleeSaved(Register reg) {
+    return reg == Register::RBX || (reg >= Register::R12 && reg <= Register::R15);
+}
+
+// int constants that fit in 32 bits are used as immediates wherever x86 takes one, so they never need a register
+inline bool isImmediate(const IRInstr& def) {
+    return def.op == IROp::CONST && def.type == IRType::I64 && def.imm.i >= INT32_MIN && def.imm.i <= INT32_MAX;
+}
+
+// where each vreg of a function lives for its whole lifetime: a register, or a stack slot if
+// it was spilled
+// rsp & rbp hold the frame & rax, rcx, rdx, xmm0 & xmm1 are kept as scratch for the
+// instructions that need fixed registers (idiv, shifts, setcc) & for shuffling values,
+// the other 11 general purpose & 14 xmm registers are handed out
+struct RegisterAllocation {
+    std::vector<Register> registers; // of each vreg that isn't spilled
+    std::vector<uint32_t> slots; // stack slot of each spilled vreg, UINT32_MAX if it's in a register
+    std::vector<uint32_t> saveSlots; // where a vreg in a caller-saved register is kept during calls
+    std::vector<std::pair<Register, uint32_t>> calleeSaved; // used & the slot they're saved in by the prologue
+    size_t numSpilled = 0;
+    size_t numSlots = 0; // stack slots used in all
+    // per call in layout order, the vregs in caller-saved registers that are live across it
+    std::vector<std::vector<vreg_t>> callSaves;
+
+    bool isSpilled(vreg_t v) const { return slots[v] != UINT32_MAX; };
+};
+
+// linear scan (Poletto & Sarkar) over one live interval per vreg, numbered along the reverse
+// postorder the backend lays the blocks out in
+// values live across a call prefer callee-saved registers, the rest prefer caller-saved ones,
+// once a register class runs out the interval that ends furthest away is spilled
+RegisterAllocation allocateRegisters(const IRFunction&);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include <cstdint>
+
+#include "strength_reduction.hpp"
+
+// index of the lowest set bit, val must not be 0
+static int countTrailingZeros(uint64_t val) {
+    int k = 0;
+    while ((val & 1) == 0) {
+        val >>= 1;
+        k++;
+    }
+    return k;
+}
+
+// |val| as unsigned, so INT64_MIN doesn't overflow
+static uint64_t magnitude(long long val) {
+    return val < 0 ? 0 - (uint64_t)val : (uint64_t)val;
+}
+
+bool compileMultiplyByConstant(X86Code& code, long long multiplier) {
+    if (multiplier == 0) {
+        code.emit("xor", {X86Operand(Register::RAX, 4), X86Operand(Register::RAX, 4)});
+        return true;
+    }
+
+    // |multiplier| = 2^k * each factor, only worth it if it's at most 2 instructions
+    // (imul has a 3 cycle latency, lea & shifts take 1 each)
+    uint64_t rest = magnitude(multiplier);
+    const int shift = countTrailingZeros(rest);
+    rest >>= shift;
+    int factors[2];
+    int numFactors = 0;
+    while (rest != 1 && numFactors < 2) {
+        if (rest % 9 == 0) factors[numFactors++] = 9;
+        else if (rest % 5 == 0) factors[numFactors++] = 5;
+        else if (rest % 3 == 0) factors[numFactors++] = 3;
+        else return false;
+        rest /= factors[numFactors-1];
+    }
+    if (rest != 1 || numFactors + (shift > 0) + (multiplier < 0) > 2) return false;
+
+    for (int i = 0; i < numFactors; i++)
+        code.emit("lea", {Register::RAX, X86Operand::makeIndexed(Register::RAX, Register::RAX, factors[i] - 1)});
+    if (shift > 0) code.emit("shl", {Register::RAX, X86Operand::makeImmediate(shift)});
+    if (multiplier < 0) code.emit("neg", {Register::RAX}); // x * -c wraps the same as -(x * c)
+    return true;
+}
+
+// rdx = 2^k - 1 if rax is negative, 0 otherwise
+// adding it before shifting rounds toward 0 like idiv does instead of toward -infinity
+static void compileRoundingBias(X86Code& code, int k) {
+    code.emit("mov", {Register::RDX, Register::RAX});
+    if (k > 1) code.emit("sar", {Register::RDX, X86Operand::makeImmediate(63)});
+    code.emit("shr", {Register::RDX, X86Operand::makeImmediate(64 - k)});
+}
+
+// multiplier & shift such that x / divisor = hi64(x * multiplier) >> shift (+ corrections),
+// from Hacker's Delight (10-1), divisor must not be -1, 0 or 1
+struct DivisionMagic {
+    long long multiplier;
+    int shift;
+};
+
+static DivisionMagic getDivisionMagic(long long divisor) {
+    const uint64_t two63 = 1ull << 63;
+    const uint64_t ad = magnitude(divisor);
+    const uint64_t t = two63 + ((uint64_t)divisor >> 63);
+    const uint64_t anc = t - 1 - t % ad; // |nc|
+    int p = 63;
+    uint64_t q1 = two63 / anc, r1 = two63 - q1 * anc; // 2^p / |nc|
+    uint64_t q2 = two63 / ad, r2 = two63 - q2 * ad; // 2^p / |d|
+    uint64_t delta;
+    do {
+        p++;
+        q1 *= 2;
+        r1 *= 2;
+        if (r1 >= anc) {
+            q1++;
+            r1 -= anc;
+        }
+        q2 *= 2;
+        r2 *= 2;
+        if (r2 >= ad) {
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    const long long multiplier = (long long)(q2 + 1);
+    return {divisor < 0 ? -multiplier : multiplier, p - 64};
+}
+
+// rax = rax / divisor for divisors that aren't powers of 2, the dividend is left in rcx
+static void compileMagicDivide(X86Code& code, long long divisor) {
+    const DivisionMagic magic = getDivisionMagic(divisor);
+    code.emit("mov", {Register::RCX, Register::RAX});
+    code.emit("mov", {Register::RAX, X86Operand::makeImmediate(magic.multiplier)});
+    code.emit("imul", {Register::RCX}); // rdx = high half
+    if (divisor > 0 && magic.multiplier < 0) code.emit("add", {Register::RDX, Register::RCX});
+    else if (divisor < 0 && magic.multiplier > 0) code.emit("sub", {Register::RDX, Register::RCX});
+    if (magic.shift > 0) code.emit("sar", {Register::RDX, X86Operand::makeImmediate(magic.shift)});
+    code.emit("mov", {Register::RAX, Register::RDX}); // + 1 if negative, to round toward 0
+    code.emit("shr", {Register::RAX, X86Operand::makeImmediate(63)});
+    code.emit("add", {Register::RAX, Register::RDX});
+}
+
+// a power of 2's exponent, -1 if |val| isn't one (or is 2^63)
+static int getPowerOfTwo(long long val) {
+    const uint64_t mag = magnitude(val);
+    if (mag == 0 || (mag & (mag - 1)) != 0 || mag == (1ull << 63)) return -1;
+    return countTrailingZeros(mag);
+}
+
+bool compileDivideByConstant(X86Code& code, long long divisor) {
+    if (divisor == 0 || divisor == -1 || divisor == INT64_MIN) return false;
+    if (divisor == 1) return true;
+
+    const int k = getPowerOfTwo(divisor);
+    if (k > 0) {
+        compileRoundingBias(code, k);
+        code.emit("add", {Register::RAX, Register::RDX});
+        code.emit("sar", {Register::RAX, X86Operand::makeImmediate(k)});
+        if (divisor < 0) code.emit("neg", {Register::RAX});
+        return true;
+    }
+    compileMagicDivide(code, divisor);
+    return true;
+}
+
+bool compileModuloByConstant(X86Code& code, long long divisor) {
+    if (divisor == 0 || divisor == -1 || divisor == INT64_MIN) return false;
+    if (divisor == 1) {
+        code.emit("xor", {X86Operand(Register::RAX, 4), X86Operand(Register::RAX, 4)});
+        return true;
+    }
+
+    // the remainder takes the dividend's sign, so the divisor's doesn't matter
+    const int k = getPowerOfTwo(divisor);
+    if (k > 0) {
+        // (x + bias) & (2^k - 1) - bias
+        const uint64_t mask = (1ull << k) - 1;
+        compileRoundingBias(code, k);
+        code.emit("add", {Register::RAX, Register::RDX});
+        if (k < 32) {
+            code.emit("and", {Register::RAX, X86Operand::makeImmediate(mask)});
+        } else { // and only takes a 32 bit immediate
+            code.emit("mov", {Register::RCX, X86Operand::makeImmediate(mask)});
+            code.emit("and", {Register::RAX, Register::RCX});
+        }
+        code.emit("sub", {Register::RAX, Register::RDX});
+        return true;
+    }
+
+    // x - (x / d) * d
+    compileMagicDivide(code, divisor);
+    if (divisor >= INT32_MIN && divisor <= INT32_MAX) {
+        code.emit("imul", {Register::RAX, Register::RAX, X86Operand::makeImmediate(divisor)});
+    } else {
+        code.emit("mov", {Register::RDX, X86Operand::makeImmediate(divisor)});
+        code.emit("imul", {Register::RAX, Register::RDX});
+    }
+    code.emit("sub", {Register::RCX, Register::RAX});
+    code.emit("mov", {Register::RAX, Register::RCX});
+    return true;
+}
\ No newline at end of file
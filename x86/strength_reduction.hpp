@@ -0,0 +1,22 @@
+#ifndef __STRENGTH_REDUCTION_HPP
+#define __STRENGTH_REDUCTION_HPP
+
+#include "x86_code.hpp"
+
+// cheaper instruction sequences for int * / % by a constant than the generic imul & idiv
+// each takes the other operand in rax & leaves the result there (rcx & rdx may be clobbered),
+// results match imul / idiv exactly (wrapping, truncating toward 0), divisors that make idiv
+// trap for some dividend (0 & -1) or that don't pay off are left to it
+// returns false without emitting anything if the generic instruction should be used
+
+// shifts & lea (x * 2^k, x * 3/5/9, products of those, negated)
+bool compileMultiplyByConstant(X86Code&, long long multiplier);
+
+// shifts w/ a fix-up so negative dividends round toward 0 for powers of 2, a multiply by the
+// divisor's "magic number" keeping the high half otherwise
+bool compileDivideByConstant(X86Code&, long long divisor);
+
+// a mask w/ the same fix-up for powers of 2, x - (x / d) * d otherwise
+bool compileModuloByConstant(X86Code&, long long divisor);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include <string>
+
+#include "x86_code.hpp"
+
+// register names by number & size
+static const char* const NAMES_64[] = {"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"};
+static const char* const NAMES_32[] = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi", "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"};
+static const char* const NAMES_8[] = {"al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil", "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"};
+
+static std::string getRegisterName(Register reg, uint8_t size) {
+    const uint8_t number = getRegisterNumber(reg);
+    if (isRegisterXMM(reg)) return "xmm" + std::to_string(number);
+    return size == 1 ? NAMES_8[number] : size == 4 ? NAMES_32[number] : NAMES_64[number];
+}
+
+std::string toNASM(const X86Operand& op) {
+    switch (op.kind) {
+        case X86Operand::REGISTER: return getRegisterName(op.reg, op.size);
+        case X86Operand::IMMEDIATE: return std::to_string(op.value);
+        case X86Operand::SYMBOL: return op.symbol;
+        default: break;
+    }
+
+    std::string address = op.size == 1 ? "byte [" : op.size == 8 ? "qword [" : "[";
+    if (op.isRipRelative()) return address + "rel " + op.symbol + ']';
+    address += NAMES_64[getRegisterNumber(op.reg)];
+    if (op.scale != 0) address += '+' + std::string(NAMES_64[getRegisterNumber(op.index)]) + '*' + std::to_string(op.scale);
+    if (op.value > 0) address += '+' + std::to_string(op.value);
+    else if (op.value < 0) address += std::to_string(op.value);
+    return address + ']';
+}
+
+std::string toNASM(const X86Instr& instr) {
+    if (instr.isLabel) return instr.mnemonic + ':';
+    std::string line = instr.mnemonic;
+    for (size_t i = 0; i < instr.operands.size(); i++)
+        line += (i == 0 ? " " : ", ") + toNASM(instr.operands[i]);
+    return line;
+}
+
+void X86Code::write(std::ofstream& outHandle) const {
+    for (const X86Instr& instr : instrs)
+        outHandle << (instr.isLabel ? "" : "    ") << toNASM(instr) << '\n';
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef __X86_CODE_HPP
+#define __X86_CODE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// assembler symbols
+#define ASM_STR_PREFIX "_LS" // LS for "literal string", as _LS0000 for corresponding numeric id in AST
+#define ASM_FUNC_PREFIX "_FD" // FD for "function definition"
+#define ASM_GLOBAL_PREFIX "_GV" // GV for "global variable", as _GV0000 for the global's index
+#define ASM_LABEL_PREFIX "_L" // local jump targets
+#define ASM_INIT_LABEL "_GI" // GI for "global initializers", run from _start before main
+#define ASM_ENTRY_LABEL "_start"
+
+// registers in the order of their numbers in ModRM, SIB & REX, then the xmm registers (numbered the same way)
+enum class Register : uint8_t {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15,
+    XMM0, XMM1, XMM2, XMM3, XMM4, XMM5, XMM6, XMM7,
+    XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15
+};
+
+constexpr bool isRegisterXMM(Register reg) { return reg >= Register::XMM0; }
+
+// the 4 bits ModRM, SIB & REX encode a register with
+constexpr uint8_t getRegisterNumber(Register reg) { return (uint8_t)reg & 15; }
+
+// an instruction operand, kept as what it refers to rather than as text so the peephole pass
+// & the encoder can look at it directly, toNASM() spells it out for the assembly file
+struct X86Operand {
+    enum Kind : uint8_t { REGISTER, IMMEDIATE, MEMORY, SYMBOL };
+
+    Kind kind = REGISTER;
+    uint8_t size = 8; // bytes of the register or of the memory accessed (1, 4 or 8), 0 leaves memory unsized (ex. lea's)
+    Register reg = Register::RAX; // the register, or the base of an address
+    Register index = Register::RAX; // of an address, only if scale isn't 0
+    uint8_t scale = 0; // what index is multiplied by (1, 2, 4 or 8), 0 if there's no index
+    int64_t value = 0; // the immediate, or an address's displacement
+    std::string symbol; // a jump or call target, or what a rip relative address refers to
+
+    // a register (al, eax, rax or xmm0 for size 1, 4 & 8)
+    X86Operand(Register reg, uint8_t size = 8) : size(size), reg(reg) {};
+
+    static X86Operand makeImmediate(int64_t value) {
+        X86Operand op(Register::RAX);
+        op.kind = IMMEDIATE;
+        op.value = value;
+        return op;
+    };
+    // [base+displacement]
+    static X86Operand makeMemory(Register base, int64_t displacement, uint8_t size = 8) {
+        X86Operand op(base, size);
+        op.kind = MEMORY;
+        op.value = displacement;
+        return op;
+    };
+    // [base+index*scale], unsized since only lea takes one
+    static X86Operand makeIndexed(Register base, Register index, uint8_t scale) {
+        X86Operand op = makeMemory(base, 0, 0);
+        op.index = index;
+        op.scale = scale;
+        return op;
+    };
+    // [rel symbol]
+    static X86Operand makeRipRelative(const std::string& symbol, uint8_t size = 8) {
+        X86Operand op = makeMemory(Register::RAX, 0, size);
+        op.symbol = symbol;
+        return op;
+    };
+    // a label
+    static X86Operand makeSymbol(const std::string& symbol) {
+        X86Operand op(Register::RAX);
+        op.kind = SYMBOL;
+        op.symbol = symbol;
+        return op;
+    };
+
+    bool isRipRelative() const { return kind == MEMORY && !symbol.empty(); };
+    bool isXMM() const { return kind == REGISTER && isRegisterXMM(reg); };
+    // a general purpose register (of any size)
+    bool isGPR() const { return kind == REGISTER && !isRegisterXMM(reg); };
+    bool isRegisterOrMemory() const { return kind == REGISTER || kind == MEMORY; };
+
+    bool operator==(const X86Operand& other) const {
+        return kind == other.kind && size == other.size && reg == other.reg && scale == other.scale &&
+               (scale == 0 || index == other.index) && value == other.value && symbol == other.symbol;
+    };
+    bool operator!=(const X86Operand& other) const { return !(*this == other); };
+};
+
+// one line of the .text section, an instruction or a label
+struct X86Instr {
+    std::string mnemonic; // the label's name for labels
+    std::vector<X86Operand> operands; // destination first
+    bool isLabel = false;
+};
+
+// as NASM (ex. "qword [rbp-8]", "r8d" or "_L3")
+std::string toNASM(const X86Operand&);
+// as a line of NASM w/o indentation (ex. "mov rax, 42", or "_L3:" for a label)
+std::string toNASM(const X86Instr&);
+
+// code is collected here instead of being written out right away, so it can still be rewritten
+class X86Code {
+    public:
+        void emit(const std::string& mnemonic, std::vector<X86Operand> operands = {}) {
+            instrs.push_back({mnemonic, std::move(operands), false});
+        };
+        void label(const std::string& name) { instrs.push_back({name, {}, true}); };
+
+        // as NASM, one line each
+        void write(std::ofstream&) const;
+
+        std::vector<X86Instr> instrs;
+};
+
+// everything generated for a module, the code & the data it refers to
+struct X86Program {
+    X86Code text;
+    std::vector<std::string_view> strings; // ASM_STR_PREFIX<i>, null terminated, view into the AST
+    size_t numGlobals = 0; // ASM_GLOBAL_PREFIX<i>, a zeroed qword each
+};
+
+#endif
\ No newline at end of file
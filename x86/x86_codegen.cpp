@@ -0,0 +1,583 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "x86_codegen.hpp"
+#include "peephole.hpp"
+#include "register_allocator.hpp"
+#include "strength_reduction.hpp"
+#include "x86_code.hpp"
+#include "../errors.hpp"
+#include "../symbols.hpp"
+
+#define ASM_STRLEN_SUFFIX "_SZ" // suffix for AST string variables' sizes (ex. string is _LS0, size is _LS0_SZ)
+#define TAB "    "
+
+// integer class params are passed in these, in order (System V)
+static const Register PARAM_REGISTERS[] = {Register::RDI, Register::RSI, Register::RDX, Register::RCX, Register::R8, Register::R9};
+#define NUM_PARAM_REGISTERS 6
+#define NUM_PARAM_XMM_REGISTERS 8
+
+// where each param of a function is passed: a register index, or a stack arg index if isStacked
+struct ParamLocation {
+    bool isStacked;
+    size_t index;
+};
+
+static std::vector<ParamLocation> getParamLocations(const std::vector<IRType>& paramTypes) {
+    std::vector<ParamLocation> locations;
+    size_t numInts = 0, numDoubles = 0, numStacked = 0;
+    for (const IRType type : paramTypes) {
+        if (type == IRType::F64 ? numDoubles < NUM_PARAM_XMM_REGISTERS : numInts < NUM_PARAM_REGISTERS)
+            locations.push_back({false, type == IRType::F64 ? numDoubles++ : numInts++});
+        else
+            locations.push_back({true, numStacked++});
+    }
+    return locations;
+}
+
+// # of a function's params that are passed on the stack
+static size_t countStackParams(const IRFunction& func) {
+    size_t numStacked = 0;
+    for (const ParamLocation& location : getParamLocations(func.paramTypes)) numStacked += location.isStacked;
+    return numStacked;
+}
+
+// memory operand of a stack slot, one 8 byte slot each below the frame's base pointer
+static X86Operand getSlotAddress(uint32_t slot, uint8_t size) {
+    return X86Operand::makeMemory(Register::RBP, -8 * ((int64_t)slot + 1), size);
+}
+
+// a stack arg of the function, above the return address & the caller's base pointer
+static X86Operand getStackArgAddress(size_t index) {
+    return X86Operand::makeMemory(Register::RBP, 16 + 8 * (int64_t)index);
+}
+
+// parts of the scratch registers, for setcc & movzx
+static const X86Operand AL(Register::RAX, 1), CL(Register::RCX, 1), EAX(Register::RAX, 4);
+
+static Register getXMM(size_t i) { return (Register)((size_t)Register::XMM0 + i); }
+
+// a copy from src to dst, all made "at once" (each src is read before any dst is written)
+struct Move {
+    X86Operand dst, src;
+};
+
+// compiles one function, blocks are laid out in reverse postorder so a block's first
+// successor usually comes right after it & its jump can be left out
+class FunctionCompiler {
+    public:
+        FunctionCompiler(X86Code& code, const IRModule& module, const IRFunction& func, size_t& nextLabel, const CodegenOptions& options)
+            : code(code), module(module), func(func), options(options),
+              allocation(allocateRegisters(func)), defs(func.numVregs(), nullptr) {
+            labelBase = nextLabel;
+            nextLabel += func.blocks.size();
+            for (const IRBlock& block : func.blocks)
+                for (const IRInstr& instr : block.instrs)
+                    if (instr.dst != VREG_NONE) defs[instr.dst] = &instr;
+        };
+
+        size_t getNumSpilled() const { return allocation.numSpilled; };
+
+        void compile(const std::string& label) {
+            code.label(label);
+
+            // create stack frame, spill & save slots (kept 16 byte aligned)
+            code.emit("push", {Register::RBP}); // save old base ptr
+            code.emit("mov", {Register::RBP, Register::RSP}); // set new base ptr
+            if (allocation.numSlots > 0)
+                code.emit("sub", {Register::RSP, X86Operand::makeImmediate((allocation.numSlots * 8 + 15) & ~(size_t)15)});
+            for (const std::pair<Register, uint32_t>& saved : allocation.calleeSaved)
+                code.emit("mov", {getSlotAddress(saved.second, 0), saved.first});
+
+            const std::vector<block_id> order = getReversePostorder(func);
+            for (size_t i = 0; i < order.size(); i++) {
+                const block_id b = order[i];
+                nextBlock = i+1 < order.size() ? order[i+1] : UINT32_MAX;
+                if (b != 0) code.label(getBlockLabel(b));
+
+                // a block with a single pred that branched here conditionally takes its phis' values itself
+                const IRBlock& block = func.blocks[b];
+                if (block.preds.size() == 1 && func.blocks[block.preds[0]].terminator().op == IROp::CBR)
+                    compilePhiCopies(b, 0);
+                if (b == 0) compileParams();
+
+                for (size_t j = 0; j < block.instrs.size(); j++) {
+                    const IRInstr& instr = block.instrs[j];
+                    if (instr.op == IROp::CALL && (instr.flags & IR_FLAG_TAIL) && compileTailCall(instr)) break; // the jump replaces the return
+                    compileInstr(b, instr);
+                }
+            }
+        };
+    private:
+        void compileInstr(block_id b, const IRInstr& instr) {
+            const X86Operand dst = instr.dst != VREG_NONE ? operand(instr.dst) : X86Operand(Register::RAX); // unused w/o one
+            switch (instr.op) {
+                case IROp::PARAM: case IROp::PHI: break; // moved in all at once
+                case IROp::CONST:
+                    if (isImmediate(instr)) break; // written straight into the instructions using it
+                    if (instr.type == IRType::F64) {
+                        // there's no immediate form for doubles, so move the bits through rax
+                        int64_t bits;
+                        std::memcpy(&bits, &instr.imm.d, sizeof(bits));
+                        code.emit("mov", {Register::RAX, X86Operand::makeImmediate(bits)});
+                        move(dst, Register::RAX);
+                    } else if (dst.kind != X86Operand::MEMORY) {
+                        code.emit("mov", {dst, X86Operand::makeImmediate(instr.imm.i)});
+                    } else {
+                        code.emit("mov", {Register::RAX, X86Operand::makeImmediate(instr.imm.i)});
+                        move(dst, Register::RAX);
+                    }
+                    break;
+                case IROp::STRING: {
+                    const X86Operand address = X86Operand::makeRipRelative(ASM_STR_PREFIX + std::to_string(instr.imm.i), 0);
+                    code.emit("lea", {dst.kind == X86Operand::MEMORY ? Register::RAX : dst, address});
+                    if (dst.kind == X86Operand::MEMORY) move(dst, Register::RAX);
+                    break;
+                }
+                case IROp::LOAD_GLOBAL: move(dst, getGlobalAddress(instr.imm.i)); break;
+                case IROp::STORE_GLOBAL: move(getGlobalAddress(instr.imm.i), operand(instr.args[0])); break;
+                case IROp::CALL: compileCall(instr); break;
+
+                case IROp::ADD: compileTwoOperand("add", instr, true); break;
+                case IROp::SUB: compileTwoOperand("sub", instr, false); break;
+                case IROp::AND: compileTwoOperand("and", instr, true); break;
+                case IROp::OR: compileTwoOperand("or", instr, true); break;
+                case IROp::XOR: compileTwoOperand("xor", instr, true); break;
+                case IROp::MUL: case IROp::DIV: case IROp::MOD: compileMultiplicative(instr); break;
+                case IROp::SHL: case IROp::SAR: // the count has to be in cl
+                    code.emit("mov", {Register::RCX, operand(instr.args[1])});
+                    move(dst, operand(instr.args[0]));
+                    code.emit(instr.op == IROp::SHL ? "shl" : "sar", {dst, X86Operand(Register::RCX, 1)});
+                    break;
+                case IROp::EQ: compileIntCompare(instr, "sete"); break;
+                case IROp::NE: compileIntCompare(instr, "setne"); break;
+                case IROp::LT: compileIntCompare(instr, "setl"); break;
+                case IROp::LE: compileIntCompare(instr, "setle"); break;
+                case IROp::GT: compileIntCompare(instr, "setg"); break;
+                case IROp::GE: compileIntCompare(instr, "setge"); break;
+                case IROp::NEG: case IROp::NOT:
+                    move(dst, operand(instr.args[0]));
+                    code.emit(instr.op == IROp::NEG ? "neg" : "not", {dst});
+                    break;
+
+                case IROp::FADD: compileTwoOperand("addsd", instr, true); break;
+                case IROp::FSUB: compileTwoOperand("subsd", instr, false); break;
+                case IROp::FMUL: compileTwoOperand("mulsd", instr, true); break;
+                case IROp::FDIV: compileTwoOperand("divsd", instr, false); break;
+                case IROp::FNEG: // flip the sign bit
+                    move(Register::RAX, operand(instr.args[0]));
+                    code.emit("btc", {Register::RAX, X86Operand::makeImmediate(63)});
+                    move(dst, Register::RAX);
+                    break;
+                case IROp::FEQ: case IROp::FNE: case IROp::FLT: case IROp::FLE: case IROp::FGT: case IROp::FGE:
+                    compileDoubleCompare(instr);
+                    break;
+
+                case IROp::ITOF: {
+                    X86Operand src = operand(instr.args[0]);
+                    if (src.kind == X86Operand::IMMEDIATE) {
+                        move(Register::RAX, src);
+                        src = Register::RAX;
+                    }
+                    code.emit("cvtsi2sd", {dst.isXMM() ? dst : Register::XMM0, src});
+                    if (!dst.isXMM()) move(dst, Register::XMM0);
+                    break;
+                }
+                case IROp::SEXT8: { // the low byte comes first in memory
+                    const vreg_t arg = instr.args[0];
+                    if (isImmediate(*defs[arg])) {
+                        move(dst, X86Operand::makeImmediate((signed char)defs[arg]->imm.i));
+                        break;
+                    }
+                    const X86Operand low = allocation.isSpilled(arg) ? getSlotAddress(allocation.slots[arg], 1) :
+                                                                       X86Operand(allocation.registers[arg], 1);
+                    code.emit("movsx", {dst.kind == X86Operand::MEMORY ? Register::RAX : dst, low});
+                    if (dst.kind == X86Operand::MEMORY) move(dst, Register::RAX);
+                    break;
+                }
+
+                case IROp::BR:
+                    compilePhiCopies(instr.targets[0], getPredIndex(instr.targets[0], b));
+                    jumpTo(instr.targets[0]);
+                    break;
+                case IROp::CBR: // the targets have no other preds, so their phis are filled in there
+                    if (isImmediate(*defs[instr.args[0]])) { // decided already
+                        jumpTo(instr.targets[defs[instr.args[0]]->imm.i != 0 ? 0 : 1]);
+                        break;
+                    }
+                    code.emit("cmp", {operand(instr.args[0]), X86Operand::makeImmediate(0)});
+                    if (instr.targets[0] == nextBlock) {
+                        code.emit("je", {X86Operand::makeSymbol(getBlockLabel(instr.targets[1]))});
+                    } else {
+                        code.emit("jne", {X86Operand::makeSymbol(getBlockLabel(instr.targets[0]))});
+                        jumpTo(instr.targets[1]);
+                    }
+                    break;
+                case IROp::RET:
+                    if (!instr.args.empty()) move(func.returnType == IRType::F64 ? Register::XMM0 : Register::RAX, operand(instr.args[0]));
+                    compileEpilogue();
+                    code.emit("ret");
+                    break;
+            }
+        };
+
+        // register or stack slot a vreg lives in (or its value if it's an immediate)
+        X86Operand operand(vreg_t v) const {
+            if (isImmediate(*defs[v])) return X86Operand::makeImmediate(defs[v]->imm.i);
+            if (allocation.isSpilled(v)) return getSlotAddress(allocation.slots[v], 8);
+            return allocation.registers[v];
+        };
+
+        static X86Operand getGlobalAddress(size_t index) {
+            return X86Operand::makeRipRelative(ASM_GLOBAL_PREFIX + std::to_string(index));
+        };
+
+        // copies 8 bytes between registers (general purpose or xmm) & memory
+        void move(const X86Operand& dst, const X86Operand& src) {
+            if (dst == src) return;
+            const bool isMemory = dst.kind == X86Operand::MEMORY || src.kind == X86Operand::MEMORY;
+            if (dst.kind == X86Operand::MEMORY && src.kind == X86Operand::MEMORY) {
+                code.emit("push", {src});
+                code.emit("pop", {dst});
+            } else if (dst.isXMM() && src.isXMM()) {
+                code.emit("movapd", {dst, src});
+            } else if (dst.isXMM() || src.isXMM()) {
+                code.emit(isMemory ? "movsd" : "movq", {dst, src});
+            } else {
+                code.emit("mov", {dst, src});
+            }
+        };
+
+        // sequences moves so no src is overwritten before it's read, a cycle is broken by
+        // parking one of its values in rax (which never holds a vreg)
+        void compileParallelMoves(std::vector<Move> moves) {
+            moves.erase(std::remove_if(moves.begin(), moves.end(), [](const Move& m) { return m.dst == m.src; }), moves.end());
+            while (!moves.empty()) {
+                bool isProgressing = false;
+                for (size_t i = 0; i < moves.size(); i++) {
+                    bool isRead = false;
+                    for (size_t j = 0; j < moves.size() && !isRead; j++)
+                        isRead = j != i && moves[j].src == moves[i].dst;
+                    if (isRead) continue;
+                    move(moves[i].dst, moves[i].src);
+                    moves.erase(moves.begin() + i--);
+                    isProgressing = true;
+                }
+                if (isProgressing) continue;
+
+                const X86Operand parked = moves[0].dst;
+                move(Register::RAX, parked);
+                for (Move& m : moves)
+                    if (m.src == parked) m.src = Register::RAX;
+            }
+        };
+
+        // collapse stack frame
+        void compileEpilogue() {
+            for (const std::pair<Register, uint32_t>& saved : allocation.calleeSaved)
+                code.emit("mov", {saved.first, getSlotAddress(saved.second, 0)});
+            code.emit("mov", {Register::RSP, Register::RBP});
+            code.emit("pop", {Register::RBP});
+        };
+
+        void jumpTo(block_id target) {
+            if (target != nextBlock) code.emit("jmp", {X86Operand::makeSymbol(getBlockLabel(target))});
+        };
+
+        std::string getBlockLabel(block_id b) const { return ASM_LABEL_PREFIX + std::to_string(labelBase + b); };
+
+        size_t getPredIndex(block_id block, block_id pred) const {
+            const std::vector<block_id>& preds = func.blocks[block].preds;
+            size_t i = 0;
+            while (preds[i] != pred) i++;
+            return i;
+        };
+
+        // moves the args from pred i into the phis of a block
+        void compilePhiCopies(block_id b, size_t i) {
+            std::vector<Move> moves;
+            for (const IRInstr& instr : func.blocks[b].instrs) {
+                if (instr.op != IROp::PHI) break;
+                moves.push_back({operand(instr.dst), operand(instr.args[i])});
+            }
+            compileParallelMoves(moves);
+        };
+
+        // copies the params out of their registers (or the caller's frame) to where they're allocated
+        void compileParams() {
+            const std::vector<ParamLocation> locations = getParamLocations(func.paramTypes);
+            std::vector<Move> moves;
+            for (const IRInstr& instr : func.blocks[0].instrs) {
+                if (instr.op != IROp::PARAM) continue;
+                const ParamLocation location = locations[instr.imm.i];
+                const X86Operand src = location.isStacked ? getStackArgAddress(location.index) :
+                                       instr.type == IRType::F64 ? getXMM(location.index) : PARAM_REGISTERS[location.index];
+                moves.push_back({operand(instr.dst), src});
+            }
+            compileParallelMoves(moves);
+        };
+
+        // moves args into the registers they're passed in
+        void loadArgRegisters(const IRInstr& call, const std::vector<ParamLocation>& locations) {
+            std::vector<Move> moves;
+            for (size_t i = 0; i < call.args.size(); i++) {
+                if (locations[i].isStacked) continue;
+                if (func.vregTypes[call.args[i]] == IRType::F64)
+                    moves.push_back({getXMM(locations[i].index), operand(call.args[i])});
+                else
+                    moves.push_back({PARAM_REGISTERS[locations[i].index], operand(call.args[i])});
+            }
+            compileParallelMoves(moves);
+        };
+
+        // System V: the first 6 int class args go into registers, the first 8 doubles into
+        // xmm0-7 & the rest are passed on the stack, the first one on top
+        // every register but rbx, rbp, rsp & r12-15 may be clobbered, so values in the others
+        // that are still needed afterwards are saved around it
+        void compileCall(const IRInstr& call) {
+            const std::vector<vreg_t>& saves = allocation.callSaves[nextCall++];
+            for (const vreg_t v : saves) move(getSlotAddress(allocation.saveSlots[v], 8), operand(v));
+
+            const IRFunction& callee = module.functions[call.imm.i];
+            const std::vector<ParamLocation> locations = getParamLocations(callee.paramTypes);
+            std::vector<size_t> stackArgs;
+            for (size_t i = 0; i < locations.size(); i++)
+                if (locations[i].isStacked) stackArgs.push_back(i);
+
+            // rsp has to be 16 byte aligned at the call, it is whenever nothing's pushed
+            size_t numPushed = stackArgs.size();
+            if (numPushed % 2 != 0) {
+                code.emit("sub", {Register::RSP, X86Operand::makeImmediate(8)});
+                numPushed++;
+            }
+            for (size_t j = stackArgs.size(); j-- > 0;) {
+                const X86Operand arg = operand(call.args[stackArgs[j]]);
+                if (arg.isXMM()) {
+                    code.emit("sub", {Register::RSP, X86Operand::makeImmediate(8)});
+                    code.emit("movsd", {X86Operand::makeMemory(Register::RSP, 0, 0), arg});
+                } else {
+                    code.emit("push", {arg});
+                }
+            }
+            loadArgRegisters(call, locations);
+
+            code.emit("call", {X86Operand::makeSymbol(ASM_FUNC_PREFIX + std::to_string(call.imm.i))});
+            if (numPushed > 0) code.emit("add", {Register::RSP, X86Operand::makeImmediate(8 * numPushed)});
+            move(operand(call.dst), call.type == IRType::F64 ? Register::XMM0 : Register::RAX);
+            for (const vreg_t v : saves) move(operand(v), getSlotAddress(allocation.saveSlots[v], 8));
+        };
+
+        // a call whose value is returned right away: its args take the place of the function's
+        // params, the frame is torn down & it jumps to the callee, which returns straight to the
+        // function's caller
+        // the stack args go where this function's own were (they were moved out on entry),
+        // so it's only done if there's room, returns false if the call has to be made as usual
+        bool compileTailCall(const IRInstr& call) {
+            const IRFunction& callee = module.functions[call.imm.i];
+            if (countStackParams(callee) > countStackParams(func)) return false;
+            nextCall++; // nothing is live across it
+
+            const std::vector<ParamLocation> locations = getParamLocations(callee.paramTypes);
+            for (size_t i = 0; i < locations.size(); i++)
+                if (locations[i].isStacked) move(getStackArgAddress(locations[i].index), operand(call.args[i]));
+            loadArgRegisters(call, locations);
+            compileEpilogue();
+            code.emit("jmp", {X86Operand::makeSymbol(ASM_FUNC_PREFIX + std::to_string(call.imm.i))});
+
+            if (options.isReportingTailCalls) {
+                std::cout << "Tail call to " << SymbolTable::name(callee.name) << " at "
+                          << DTException::getLocation({call.offset, module.fileIndex}) << " compiled as a jump\n";
+            }
+            return true;
+        };
+
+        // dst = args[0] op args[1] for ops of the form "op a, b" (a = a op b)
+        // a can be anything but memory if b is, so memory destinations go through a scratch register
+        void compileTwoOperand(const char* mnemonic, const IRInstr& instr, bool isCommutative) {
+            const X86Operand dst = operand(instr.dst), a = operand(instr.args[0]), b = operand(instr.args[1]);
+            if (dst.kind != X86Operand::MEMORY && dst != b) {
+                move(dst, a);
+                code.emit(mnemonic, {dst, b});
+            } else if (dst.kind != X86Operand::MEMORY && isCommutative) { // dst took over b's register
+                code.emit(mnemonic, {dst, a});
+            } else {
+                const X86Operand scratch = instr.type == IRType::F64 ? Register::XMM0 : Register::RAX;
+                move(scratch, a);
+                code.emit(mnemonic, {scratch, b});
+                move(dst, scratch);
+            }
+        };
+
+        // the value of an int constant, false if v isn't one
+        bool getConstant(vreg_t v, long long& val) const {
+            if (defs[v] == nullptr || defs[v]->op != IROp::CONST) return false;
+            val = defs[v]->imm.i;
+            return true;
+        };
+
+        // * / %, by a constant they only load the other side
+        void compileMultiplicative(const IRInstr& instr) {
+            const X86Operand dst = operand(instr.dst);
+            long long constant;
+            if (getConstant(instr.args[1], constant)) {
+                move(Register::RAX, operand(instr.args[0]));
+                compileIntOpByConstant(instr.op, constant);
+            } else if (instr.op == IROp::MUL && getConstant(instr.args[0], constant)) {
+                move(Register::RAX, operand(instr.args[1]));
+                compileIntOpByConstant(instr.op, constant);
+            } else if (instr.op == IROp::MUL) {
+                compileTwoOperand("imul", instr, true);
+                return;
+            } else {
+                move(Register::RAX, operand(instr.args[0]));
+                code.emit("cqo");
+                code.emit("idiv", {operand(instr.args[1])});
+                if (instr.op == IROp::MOD) code.emit("mov", {Register::RAX, Register::RDX});
+            }
+            move(dst, Register::RAX);
+        };
+
+        // rax = rax op constant, for * / %
+        void compileIntOpByConstant(IROp op, long long constant) {
+            if (options.isStrengthReducing) {
+                if (op == IROp::MUL && compileMultiplyByConstant(code, constant)) return;
+                if (op == IROp::DIV && compileDivideByConstant(code, constant)) return;
+                if (op == IROp::MOD && compileModuloByConstant(code, constant)) return;
+            }
+            code.emit("mov", {Register::RCX, X86Operand::makeImmediate(constant)});
+            if (op == IROp::MUL) {
+                code.emit("imul", {Register::RAX, Register::RCX});
+                return;
+            }
+            code.emit("cqo");
+            code.emit("idiv", {Register::RCX});
+            if (op == IROp::MOD) code.emit("mov", {Register::RAX, Register::RDX});
+        };
+
+        // cmp takes at most one memory operand & an immediate only second
+        void compileIntCompare(const IRInstr& instr, const char* setInstruction) {
+            X86Operand a = operand(instr.args[0]);
+            const X86Operand b = operand(instr.args[1]);
+            if (a.kind == X86Operand::IMMEDIATE || (a.kind == X86Operand::MEMORY && b.kind == X86Operand::MEMORY)) {
+                move(Register::RAX, a);
+                a = Register::RAX;
+            }
+            code.emit("cmp", {a, b});
+            compileSetResult(instr, setInstruction);
+        };
+
+        // unordered (NaN) compares set CF, so only the above forms are false for NaN
+        // ucomisd's first operand has to be a register
+        void compileDoubleCompare(const IRInstr& instr) {
+            X86Operand a = operand(instr.args[0]), b = operand(instr.args[1]);
+            if (instr.op == IROp::FLT || instr.op == IROp::FLE) std::swap(a, b); // a < b is b > a
+            if (!a.isXMM()) {
+                move(Register::XMM0, a);
+                a = Register::XMM0;
+            }
+            code.emit("ucomisd", {a, b});
+            switch (instr.op) {
+                case IROp::FGT: case IROp::FLT: compileSetResult(instr, "seta"); break;
+                case IROp::FGE: case IROp::FLE: compileSetResult(instr, "setae"); break;
+                case IROp::FEQ: // equal & ordered
+                    code.emit("sete", {AL});
+                    code.emit("setnp", {CL});
+                    code.emit("and", {AL, CL});
+                    code.emit("movzx", {EAX, AL});
+                    move(operand(instr.dst), Register::RAX);
+                    break;
+                default: // FNE, not equal or unordered
+                    code.emit("setne", {AL});
+                    code.emit("setp", {CL});
+                    code.emit("or", {AL, CL});
+                    code.emit("movzx", {EAX, AL});
+                    move(operand(instr.dst), Register::RAX);
+                    break;
+            }
+        };
+
+        void compileSetResult(const IRInstr& instr, const char* setInstruction) {
+            code.emit(setInstruction, {AL});
+            code.emit("movzx", {EAX, AL});
+            move(operand(instr.dst), Register::RAX);
+        };
+
+        X86Code& code;
+        const IRModule& module;
+        const IRFunction& func;
+        const CodegenOptions& options;
+        const RegisterAllocation allocation;
+        std::vector<const IRInstr*> defs; // instruction defining each vreg
+        size_t labelBase; // label of block b is labelBase + b
+        block_id nextBlock = UINT32_MAX; // laid out right after the one being compiled
+        size_t nextCall = 0; // index into allocation.callSaves
+};
+
+X86Program generateX86(const IRModule& module, const CodegenOptions& options) {
+    X86Program program;
+    program.strings = module.strings; // their id is their index in source order
+    program.numGlobals = module.globalTypes.size();
+
+    // 1. compile .text section, each function's assembler id is its index in source order
+    X86Code& code = program.text;
+    size_t nextLabel = 0;
+    for (const IRFunction& func : module.functions) {
+        FunctionCompiler compiler(code, module, func, nextLabel, options);
+        compiler.compile(ASM_FUNC_PREFIX + std::to_string(func.index));
+        if (options.isReportingSpills)
+            std::cout << "Spilled " << compiler.getNumSpilled() << " of " << func.numVregs() << " values in " << SymbolTable::name(func.name) << '\n';
+    }
+    FunctionCompiler(code, module, module.init, nextLabel, options).compile(ASM_INIT_LABEL);
+
+    // 2. generate start entry point, which initializes globals in source order before main
+    code.label(ASM_ENTRY_LABEL);
+    code.emit("call", {X86Operand::makeSymbol(ASM_INIT_LABEL)});
+    code.emit("call", {X86Operand::makeSymbol(ASM_FUNC_PREFIX + std::to_string(module.mainIndex))}); // call main
+    code.emit("mov", {Register::RDI, Register::RAX}); // move return value from main function into rdi for sys_exit
+    code.emit("mov", {Register::RAX, X86Operand::makeImmediate(60)}); // specify syscall # for sys_exit
+    code.emit("syscall");
+
+    // 3. clean up
+    if (options.isPeepholeOptimizing) {
+        PeepholeStats stats;
+        optimizePeephole(code, stats);
+        if (options.isReportingPeephole) printPeepholeStats(std::cout, stats);
+    } else if (options.isReportingPeephole) { // no counts to report, rather than all 0s
+        std::cout << "Peephole optimizer is disabled at this optimization level\n";
+    }
+    return program;
+}
+
+void writeASM(std::ofstream& outHandle, const X86Program& program) {
+    outHandle << "global " ASM_ENTRY_LABEL "\n";
+
+    // 1. string literals & globals in .data section
+    outHandle << "section .data\n";
+
+    // 1.A write each string to the output file as null terminated bytes
+    for (size_t i = 0; i < program.strings.size(); i++) {
+        const std::string_view str = program.strings[i];
+        const std::string name = ASM_STR_PREFIX + std::to_string(i);
+
+        // write, as numbers so quotes & control characters don't need escaping
+        outHandle << TAB << name << ": DB ";
+        for (const char c : str)
+            outHandle << (unsigned int)(unsigned char)c << ',';
+        outHandle << "0\n";
+        outHandle << TAB << name + ASM_STRLEN_SUFFIX << " EQU " << str.size() << '\n'; // size
+    }
+
+    // 1.B each global gets a qword, initialized at startup
+    for (size_t i = 0; i < program.numGlobals; i++)
+        outHandle << TAB << ASM_GLOBAL_PREFIX << i << ": DQ 0\n";
+
+    // 2. code
+    outHandle << "section .text\n";
+    program.text.write(outHandle);
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef __X86_CODEGEN_HPP
+#define __X86_CODEGEN_HPP
+
+#include <fstream>
+
+#include "x86_code.hpp"
+#include "../ir/ir.hpp"
+
+// how the code is generated, set from the command line
+struct CodegenOptions {
+    bool isReportingTailCalls = false; // print each call compiled as a jump
+    bool isStrengthReducing = false; // int * / % by constants w/o imul & idiv where there's something cheaper
+    bool isReportingSpills = false; // print how many values of each function didn't get a register
+    bool isPeepholeOptimizing = false; // clean up the instructions generated w/ optimizePeephole()
+    bool isReportingPeephole = false; // print how many times each peephole rule fired
+};
+
+// used to generate x86-64 Linux code from the IR, which must have passed verifyIR()
+// vregs live in the registers allocateRegisters() picked (or their stack slots if spilled) &
+// instructions work on them in place where x86 allows it, going through scratch registers otherwise
+// calls flagged IR_FLAG_TAIL become jumps if the callee's stack args fit in the caller's
+X86Program generateX86(const IRModule&, const CodegenOptions& = {});
+
+// as NASM source, for assembling & linking with the system's tools
+void writeASM(std::ofstream&, const X86Program&);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,330 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "x86_encoder.hpp"
+
+// condition codes, added to the base opcode of jcc & setcc
+static const struct { const char* suffix; uint8_t code; } CONDITIONS[] = {
+    {"o", 0x0}, {"no", 0x1}, {"b", 0x2}, {"ae", 0x3}, {"e", 0x4}, {"ne", 0x5}, {"be", 0x6}, {"a", 0x7},
+    {"s", 0x8}, {"ns", 0x9}, {"p", 0xA}, {"np", 0xB}, {"l", 0xC}, {"ge", 0xD}, {"le", 0xE}, {"g", 0xF}
+};
+
+// "op r/m, r" is (ext << 3) | 1, "op r, r/m" is (ext << 3) | 3 & "op r/m, imm" is 0x81 or 0x83 /ext
+static const struct { const char* mnemonic; uint8_t ext; } ALU_OPS[] = {
+    {"add", 0}, {"or", 1}, {"and", 4}, {"sub", 5}, {"xor", 6}, {"cmp", 7}
+};
+
+// unary group 3 (0xF7 /ext) & shifts (0xC1 /ext ib, 0xD1 /ext by 1, 0xD3 /ext by cl)
+static const struct { const char* mnemonic; uint8_t ext; } UNARY_OPS[] = {{"not", 2}, {"neg", 3}, {"idiv", 7}};
+static const struct { const char* mnemonic; uint8_t ext; } SHIFT_OPS[] = {{"shl", 4}, {"shr", 5}, {"sar", 7}};
+
+// "op xmm, xmm/m64" w/ a mandatory prefix
+static const struct { const char* mnemonic; uint8_t prefix, opcode; } SSE_OPS[] = {
+    {"addsd", 0xF2, 0x58}, {"mulsd", 0xF2, 0x59}, {"subsd", 0xF2, 0x5C}, {"divsd", 0xF2, 0x5E},
+    {"ucomisd", 0x66, 0x2E}, {"movapd", 0x66, 0x28}
+};
+
+static bool fitsInt8(int64_t val) { return val >= INT8_MIN && val <= INT8_MAX; }
+static bool fitsInt32(int64_t val) { return val >= INT32_MIN && val <= INT32_MAX; }
+
+// register number of a register operand or an address's base
+static uint8_t getNumber(const X86Operand& op) { return getRegisterNumber(op.reg); }
+
+// general purpose registers & memory, the operands most instructions take as r/m
+static bool isGPROrMemory(const X86Operand& op) { return op.isGPR() || op.kind == X86Operand::MEMORY; }
+
+// what SIB encodes a scale as (log2), -1 if x86 has no such scale
+static int getScaleBits(uint8_t scale) {
+    switch (scale) {
+        case 1: return 0;
+        case 2: return 1;
+        case 4: return 2;
+        case 8: return 3;
+        default: return -1;
+    }
+}
+
+// an address ModRM & SIB can express: a 64 bit base w/ a 32 bit displacement, or an index that isn't rsp
+static bool isAddressValid(const X86Operand& op) {
+    if (op.isRipRelative()) return true;
+    if (isRegisterXMM(op.reg) || !fitsInt32(op.value)) return false;
+    if (op.scale == 0) return true;
+    return getScaleBits(op.scale) >= 0 && !isRegisterXMM(op.index) && op.index != Register::RSP;
+}
+
+// assembles one instruction at a time into the object's text, jumps are patched at the end
+class Encoder {
+    public:
+        Encoder(X86Object& object) : object(object), text(object.text) {};
+
+        std::string encode(const X86Program& program) {
+            layOutData(program);
+
+            for (const X86Instr& instr : program.text.instrs) {
+                if (instr.isLabel) {
+                    labels[instr.mnemonic] = text.size();
+                    if (instr.mnemonic != ASM_ENTRY_LABEL && instr.mnemonic.compare(0, 2, ASM_LABEL_PREFIX) != 0)
+                        addSymbol(instr.mnemonic, X86Section::TEXT, text.size(), false);
+                    continue;
+                }
+                if (!encodeInstr(instr)) return "can't encode '" + toNASM(instr) + '\'';
+            }
+
+            // the entry point is the only global, so it goes last
+            if (labels.count(ASM_ENTRY_LABEL) == 0) return "no " ASM_ENTRY_LABEL " label";
+            object.entry = (uint32_t)object.symbols.size();
+            addSymbol(ASM_ENTRY_LABEL, X86Section::TEXT, labels[ASM_ENTRY_LABEL], true);
+
+            for (const Fixup& fixup : fixups) {
+                if (labels.count(fixup.label) == 0) return "jump to undefined label " + fixup.label;
+                const int32_t rel = (int32_t)((int64_t)labels[fixup.label] - (int64_t)(fixup.offset + 4));
+                std::memcpy(&text[fixup.offset], &rel, 4);
+            }
+            return "";
+        };
+    private:
+        // a rel32 jump or call to a label that may come later
+        struct Fixup {
+            size_t offset; // of the rel32
+            std::string label;
+        };
+
+        // strings, null terminated, then the globals 8 byte aligned
+        void layOutData(const X86Program& program) {
+            std::vector<uint8_t>& data = object.data;
+            for (size_t i = 0; i < program.strings.size(); i++) {
+                addSymbol(ASM_STR_PREFIX + std::to_string(i), X86Section::DATA, data.size(), false);
+                data.insert(data.end(), program.strings[i].begin(), program.strings[i].end());
+                data.push_back(0);
+            }
+            data.resize((data.size() + 7) & ~(size_t)7, 0);
+            for (size_t i = 0; i < program.numGlobals; i++) {
+                addSymbol(ASM_GLOBAL_PREFIX + std::to_string(i), X86Section::DATA, data.size(), false);
+                data.resize(data.size() + 8, 0);
+            }
+        };
+
+        void addSymbol(const std::string& name, X86Section section, uint64_t offset, bool isGlobal) {
+            symbolIds[name] = (uint32_t)object.symbols.size();
+            object.symbols.push_back({name, section, offset, isGlobal});
+        };
+
+        void emit8(uint8_t byte) { text.push_back(byte); };
+        void emit32(uint32_t val) { for (int i = 0; i < 4; i++) text.push_back((uint8_t)(val >> (8*i))); };
+        void emit64(uint64_t val) { for (int i = 0; i < 8; i++) text.push_back((uint8_t)(val >> (8*i))); };
+        void emitImmediate(int64_t val, size_t size) {
+            if (size == 1) emit8((uint8_t)val);
+            else emit32((uint32_t)val);
+        };
+
+        // opcode w/ a rel32 to label
+        void emitJump(std::initializer_list<uint8_t> opcode, const std::string& label) {
+            for (const uint8_t byte : opcode) emit8(byte);
+            fixups.push_back({text.size(), label});
+            emit32(0);
+        };
+
+        // [prefix] [REX] opcode ModRM [SIB] [disp], reg is a register number or an opcode extension
+        // immSize is the # of immediate bytes the caller emits after, rip relative offsets are from the end
+        // of the instruction, isByte forces a REX for spl, bpl, sil & dil (which are ah-bh w/o one)
+        bool emitModRM(uint8_t prefix, bool isWide, std::initializer_list<uint8_t> opcode, uint8_t reg, const X86Operand& rm,
+                       size_t immSize = 0, bool isByte = false) {
+            if (rm.kind != X86Operand::REGISTER && (rm.kind != X86Operand::MEMORY || !isAddressValid(rm))) return false;
+            const bool isDirect = rm.kind != X86Operand::MEMORY;
+            const uint8_t base = getNumber(rm);
+            uint8_t rex = 0x40 | (isWide << 3) | ((reg >> 3) << 2);
+            if (rm.scale != 0) rex |= (getRegisterNumber(rm.index) >> 3) << 1;
+            if (!rm.isRipRelative()) rex |= base >> 3;
+            const bool isForced = isByte && ((reg >= 4 && reg < 8) || (isDirect && base >= 4 && base < 8));
+
+            if (prefix != 0) emit8(prefix);
+            if (rex != 0x40 || isForced) emit8(rex);
+            for (const uint8_t byte : opcode) emit8(byte);
+
+            const uint8_t regField = (reg & 7) << 3;
+            if (isDirect) {
+                emit8(0xC0 | regField | (base & 7));
+                return true;
+            }
+            if (rm.isRipRelative()) {
+                if (symbolIds.count(rm.symbol) == 0) return false;
+                emit8(0x05 | regField);
+                object.relocations.push_back({text.size(), symbolIds[rm.symbol], -4 - (int64_t)immSize});
+                emit32(0);
+                return true;
+            }
+
+            // rbp & r13 as a base always take a displacement, rsp & r12 need a SIB
+            const uint8_t mod = rm.value == 0 && (base & 7) != 5 ? 0x00 : fitsInt8(rm.value) ? 0x40 : 0x80;
+            if (rm.scale != 0) {
+                emit8(mod | regField | 4);
+                emit8((getScaleBits(rm.scale) << 6) | ((getRegisterNumber(rm.index) & 7) << 3) | (base & 7));
+            } else if ((base & 7) == 4) {
+                emit8(mod | regField | 4);
+                emit8(0x24);
+            } else {
+                emit8(mod | regField | (base & 7));
+            }
+            if (mod == 0x40) emit8((uint8_t)rm.value);
+            else if (mod == 0x80) emit32((uint32_t)rm.value);
+            return true;
+        };
+
+        bool encodeInstr(const X86Instr& instr) {
+            const std::string& m = instr.mnemonic;
+            const std::vector<X86Operand>& ops = instr.operands;
+            const size_t n = ops.size();
+
+            if (n == 0) {
+                if (m == "ret") emit8(0xC3);
+                else if (m == "cqo") { emit8(0x48); emit8(0x99); }
+                else if (m == "syscall") { emit8(0x0F); emit8(0x05); }
+                else return false;
+                return true;
+            }
+
+            const X86Operand& a = ops[0];
+            const bool isWide = !a.isGPR() || a.size == 8; // memory operands are all qwords but movsx's
+            if (n == 1 && a.kind == X86Operand::SYMBOL) {
+                if (m == "jmp") emitJump({0xE9}, a.symbol);
+                else if (m == "call") emitJump({0xE8}, a.symbol);
+                else if (m[0] == 'j' && getCondition(m.substr(1)) >= 0) emitJump({0x0F, (uint8_t)(0x80 + getCondition(m.substr(1)))}, a.symbol);
+                else return false;
+                return true;
+            }
+            if (m.compare(0, 3, "set") == 0 && n == 1 && getCondition(m.substr(3)) >= 0 && a.size == 1)
+                return emitModRM(0, false, {0x0F, (uint8_t)(0x90 + getCondition(m.substr(3)))}, 0, a, 0, true);
+
+            for (const auto& op : ALU_OPS) {
+                if (m != op.mnemonic || n != 2) continue;
+                const X86Operand& b = ops[1];
+                const uint8_t sizeBit = a.size != 1;
+                if (b.kind == X86Operand::IMMEDIATE) {
+                    if (a.size == 1 || !fitsInt32(b.value)) return false;
+                    const size_t immSize = fitsInt8(b.value) ? 1 : 4;
+                    if (!emitModRM(0, isWide, {(uint8_t)(immSize == 1 ? 0x83 : 0x81)}, op.ext, a, immSize)) return false;
+                    emitImmediate(b.value, immSize);
+                    return true;
+                }
+                if (b.isGPR() && isGPROrMemory(a) && (a.kind == X86Operand::MEMORY || a.size == b.size))
+                    return emitModRM(0, isWide, {(uint8_t)((op.ext << 3) | sizeBit)}, getNumber(b), a, 0, a.size == 1);
+                if (a.isGPR() && b.kind == X86Operand::MEMORY)
+                    return emitModRM(0, isWide, {(uint8_t)((op.ext << 3) | 2 | sizeBit)}, getNumber(a), b);
+                return false;
+            }
+            for (const auto& op : UNARY_OPS)
+                if (m == op.mnemonic && n == 1) return emitModRM(0, isWide, {0xF7}, op.ext, a);
+            for (const auto& op : SHIFT_OPS) {
+                if (m != op.mnemonic || n != 2) continue;
+                if (ops[1].isGPR() && ops[1].reg == Register::RCX && ops[1].size == 1) return emitModRM(0, isWide, {0xD3}, op.ext, a);
+                if (ops[1].kind != X86Operand::IMMEDIATE) return false;
+                if (ops[1].value == 1) return emitModRM(0, isWide, {0xD1}, op.ext, a); // shorter form for 1
+                if (!emitModRM(0, isWide, {0xC1}, op.ext, a, 1)) return false;
+                emit8((uint8_t)ops[1].value);
+                return true;
+            }
+            for (const auto& op : SSE_OPS)
+                if (m == op.mnemonic && n == 2 && a.isXMM()) return emitModRM(op.prefix, false, {0x0F, op.opcode}, getNumber(a), ops[1]);
+
+            if (m == "mov" && n == 2) return encodeMove(a, ops[1]);
+            if (m == "push" && n == 1) {
+                if (a.isGPR() && a.size == 8) {
+                    if (getNumber(a) >= 8) emit8(0x41);
+                    emit8(0x50 + (getNumber(a) & 7));
+                } else if (a.kind == X86Operand::IMMEDIATE && fitsInt32(a.value)) {
+                    emit8(fitsInt8(a.value) ? 0x6A : 0x68);
+                    emitImmediate(a.value, fitsInt8(a.value) ? 1 : 4);
+                } else {
+                    return a.kind == X86Operand::MEMORY && emitModRM(0, false, {0xFF}, 6, a); // pushes are 64 bit by default
+                }
+                return true;
+            }
+            if (m == "pop" && n == 1) {
+                if (a.isGPR() && a.size == 8) {
+                    if (getNumber(a) >= 8) emit8(0x41);
+                    emit8(0x58 + (getNumber(a) & 7));
+                    return true;
+                }
+                return a.kind == X86Operand::MEMORY && emitModRM(0, false, {0x8F}, 0, a);
+            }
+            if (m == "test" && n == 2 && ops[1].isGPR() && a.isGPR() && a.size == ops[1].size)
+                return emitModRM(0, isWide, {(uint8_t)(a.size == 1 ? 0x84 : 0x85)}, getNumber(ops[1]), a, 0, a.size == 1);
+            if (m == "lea" && n == 2 && a.isGPR() && ops[1].kind == X86Operand::MEMORY)
+                return emitModRM(0, true, {0x8D}, getNumber(a), ops[1]);
+            if (m == "movsx" && n == 2 && a.isGPR() && (ops[1].kind == X86Operand::MEMORY || ops[1].size == 1))
+                return emitModRM(0, isWide, {0x0F, 0xBE}, getNumber(a), ops[1], 0, true);
+            if (m == "movzx" && n == 2 && a.isGPR() && (ops[1].kind == X86Operand::MEMORY || ops[1].size == 1))
+                return emitModRM(0, isWide, {0x0F, 0xB6}, getNumber(a), ops[1], 0, true);
+            if (m == "imul") {
+                if (n == 1) return emitModRM(0, isWide, {0xF7}, 5, a);
+                if (!a.isGPR()) return false;
+                if (n == 2) return emitModRM(0, isWide, {0x0F, 0xAF}, getNumber(a), ops[1]);
+                if (n != 3 || ops[2].kind != X86Operand::IMMEDIATE || !fitsInt32(ops[2].value)) return false;
+                const size_t immSize = fitsInt8(ops[2].value) ? 1 : 4;
+                if (!emitModRM(0, isWide, {(uint8_t)(immSize == 1 ? 0x6B : 0x69)}, getNumber(a), ops[1], immSize)) return false;
+                emitImmediate(ops[2].value, immSize);
+                return true;
+            }
+            if (m == "btc" && n == 2 && ops[1].kind == X86Operand::IMMEDIATE) {
+                if (!emitModRM(0, isWide, {0x0F, 0xBA}, 7, a, 1)) return false;
+                emit8((uint8_t)ops[1].value);
+                return true;
+            }
+            if (m == "movsd" && n == 2) {
+                if (a.isXMM()) return emitModRM(0xF2, false, {0x0F, 0x10}, getNumber(a), ops[1]);
+                return ops[1].isXMM() && emitModRM(0xF2, false, {0x0F, 0x11}, getNumber(ops[1]), a);
+            }
+            if (m == "movq" && n == 2) {
+                if (a.isXMM() && isGPROrMemory(ops[1])) return emitModRM(0x66, true, {0x0F, 0x6E}, getNumber(a), ops[1]);
+                return ops[1].isXMM() && isGPROrMemory(a) && emitModRM(0x66, true, {0x0F, 0x7E}, getNumber(ops[1]), a);
+            }
+            if (m == "cvtsi2sd" && n == 2 && a.isXMM())
+                return isGPROrMemory(ops[1]) && emitModRM(0xF2, true, {0x0F, 0x2A}, getNumber(a), ops[1]);
+            return false;
+        };
+
+        bool encodeMove(const X86Operand& dst, const X86Operand& src) {
+            const bool isWide = !dst.isGPR() || dst.size == 8;
+            if (src.kind == X86Operand::IMMEDIATE) {
+                if (dst.isGPR() && dst.size != 1 && (!fitsInt32(src.value) || !isWide)) {
+                    // a 32 bit move zeroes the upper half, so only values that don't fit unsigned need 8 bytes
+                    const bool isImm64 = isWide && (uint64_t)src.value > UINT32_MAX;
+                    if (isImm64 || getNumber(dst) >= 8) emit8(0x40 | (isImm64 << 3) | (getNumber(dst) >> 3));
+                    emit8(0xB8 + (getNumber(dst) & 7));
+                    if (isImm64) emit64((uint64_t)src.value);
+                    else emit32((uint32_t)src.value);
+                    return true;
+                }
+                if (!isWide || !fitsInt32(src.value) || !emitModRM(0, true, {0xC7}, 0, dst, 4)) return false;
+                emit32((uint32_t)src.value);
+                return true;
+            }
+            if (src.isGPR() && isGPROrMemory(dst) && (dst.kind == X86Operand::MEMORY || dst.size == src.size))
+                return emitModRM(0, isWide, {(uint8_t)(src.size == 1 ? 0x88 : 0x89)}, getNumber(src), dst, 0, src.size == 1);
+            if (dst.isGPR() && src.kind == X86Operand::MEMORY)
+                return emitModRM(0, isWide, {(uint8_t)(dst.size == 1 ? 0x8A : 0x8B)}, getNumber(dst), src, 0, dst.size == 1);
+            return false;
+        };
+
+        // condition code of a jcc or setcc suffix, -1 if it isn't one
+        static int getCondition(const std::string& suffix) {
+            for (const auto& condition : CONDITIONS)
+                if (suffix == condition.suffix) return condition.code;
+            return -1;
+        };
+
+        X86Object& object;
+        std::vector<uint8_t>& text;
+        std::unordered_map<std::string, size_t> labels; // offset of each label in the text
+        std::unordered_map<std::string, uint32_t> symbolIds;
+        std::vector<Fixup> fixups;
+};
+
+std::string encodeX86(const X86Program& program, X86Object& object) {
+    object = X86Object();
+    return Encoder(object).encode(program);
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef __X86_ENCODER_HPP
+#define __X86_ENCODER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "x86_code.hpp"
+
+enum class X86Section : uint8_t { TEXT, DATA };
+
+struct X86Symbol {
+    std::string name;
+    X86Section section;
+    uint64_t offset; // into its section
+    bool isGlobal;
+};
+
+// a 32 bit pc relative reference from the text to a symbol, filled in with symbol + addend - where it is
+struct X86Relocation {
+    uint64_t offset; // into the text
+    uint32_t symbol; // index into symbols
+    int64_t addend;
+};
+
+// a program as machine code, ready to be written as an object file or executable
+struct X86Object {
+    std::vector<uint8_t> text;
+    std::vector<uint8_t> data;
+    std::vector<X86Symbol> symbols; // locals first, then globals
+    std::vector<X86Relocation> relocations; // to data, jumps & calls within the text are resolved already
+    uint32_t entry = 0; // index of ASM_ENTRY_LABEL in symbols
+};
+
+// assembles the instructions generateX86() emits, in the same syntax NASM takes
+// jumps & calls are always encoded with 32 bit offsets, the data is laid out as the strings
+// followed by the globals (8 byte aligned)
+// returns an error message naming the first instruction that can't be encoded, or "" if there are none
+std::string encodeX86(const X86Program&, X86Object&);
+
+#endif
\ No newline at end of file